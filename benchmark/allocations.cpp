@@ -0,0 +1,65 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "allocations.h"
+
+#include <atomic>
+#include <cstdlib>
+
+static std::atomic<quint64> allocations(0);
+
+#if defined(__GLIBC__)
+
+// the executable's definitions take the place of the C library's for every library loaded with it
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void  __libc_free(void* pointer);
+
+void* malloc(size_t size) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);  // growing a string or container counts as an allocation
+    return __libc_realloc(pointer, size);
+}
+
+void free(void* pointer) noexcept { __libc_free(pointer); }
+}
+
+bool allocationsCounted() { return true; }
+
+#else
+
+bool allocationsCounted() { return false; }
+
+#endif
+
+quint64 allocationCount() { return allocations.load(std::memory_order_relaxed); }
@@ -0,0 +1,35 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QtGlobal>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMEDIA BENCHMARK ALLOCATIONS
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Heap allocations made by the process so far: malloc, calloc and realloc, and so everything built on them (operator
+// new, Qt's containers and strings). Counted where the C library lets the executable put its own allocator in front
+// (glibc). Elsewhere allocationsCounted() is false and the count stays at 0.
+bool    allocationsCounted();
+quint64 allocationCount();
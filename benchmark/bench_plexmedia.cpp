@@ -0,0 +1,429 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonParseError>
+#include <QMap>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <QtXml/QDomDocument>
+
+#include "allocations.h"
+#include "plexartwork.h"
+#include "plexjsondecoder.h"
+#include "plexlibraryindex.h"
+#include "plexsessiontable.h"
+#include "plextimelinedecoder.h"
+#include "yio-model/mediaplayer/albummodel_mediaplayer.h"
+#include "yio-model/mediaplayer/searchmodel_mediaplayer.h"
+
+// Time and heap allocations of one pass through a benchmarked block. The fastest pass is kept: it is the one least
+// disturbed by the rest of the system. The allocation count is the same in every pass.
+class Probe {
+ public:
+    void start() {
+        m_allocations = allocationCount();
+        m_timer.start();
+    }
+
+    void stop() {
+        qint64  elapsed = m_timer.nsecsElapsed();
+        quint64 allocated = allocationCount() - m_allocations;
+        if (m_passes == 0 || elapsed < nsecs) nsecs = elapsed;
+        if (m_passes == 0 || allocated < allocations) allocations = allocated;
+        m_passes++;
+    }
+
+    qint64  nsecs = 0;
+    quint64 allocations = 0;
+
+ private:
+    QElapsedTimer m_timer;
+    quint64       m_allocations = 0;
+    int           m_passes = 0;
+};
+
+// Reply handling over large-library fixtures (see fixtures/generate.py): decoding, the handlers' own work and the
+// models handed to the UI. The last function checks every case against baseline.json.
+class BenchPlexMedia : public QObject {
+    Q_OBJECT
+
+ private slots:  // NOLINT open issue: https://github.com/cpplint/cpplint/pull/99
+    void initTestCase() {
+        const QStringList names = {"sessions_1.json",           "sessions_20.json",          "search_500.json",
+                                   "allleaves_3000.json",       "playlist_5000.json",        "timeline.xml",
+                                   "notification_playing.json", "notification_timeline.json"};
+        for (int i = 0; i < names.size(); i++) {
+            QFile file(QString(FIXTURE_PATH) + "/" + names[i]);
+            QVERIFY2(file.open(QIODevice::ReadOnly), qPrintable(file.fileName() + ": " + file.errorString()));
+            m_fixtures.insert(names[i], file.readAll());
+        }
+        QVERIFY(m_cacheDir.isValid());
+        if (!allocationsCounted()) qWarning("Heap allocations are not counted on this platform");
+    }
+
+    void decode_data() {
+        QTest::addColumn<QString>("fixture");
+        QTest::addColumn<int>("items");
+        QTest::newRow("sessions_1") << "sessions_1.json" << 1;
+        QTest::newRow("sessions_20") << "sessions_20.json" << 20;
+        QTest::newRow("search_500") << "search_500.json" << 500;
+        QTest::newRow("allleaves_3000") << "allleaves_3000.json" << 3000;
+        QTest::newRow("playlist_5000") << "playlist_5000.json" << 5000;
+    }
+
+    void decode() {
+        QFETCH(QString, fixture);
+        QFETCH(int, items);
+        const QByteArray& data = m_fixtures[fixture];
+
+        Probe probe;
+        int   decoded = 0;
+        QBENCHMARK {
+            probe.start();
+            {
+                PlexMediaContainer container;
+                QVERIFY(PlexJsonDecoder::decode(data, &container));
+                decoded = container.metadata.size() + container.sessions.size();
+            }
+            probe.stop();
+        }
+        QCOMPARE(decoded, items);
+        record(probe);
+    }
+
+    void decodeVariant_data() { decode_data(); }
+
+    // the path the decoder replaced, for comparison: the whole reply as a QVariantMap, and the fields the handlers
+    // read taken from a fresh copy of each item's map, like they did
+    void decodeVariant() {
+        QFETCH(QString, fixture);
+        QFETCH(int, items);
+        const QByteArray& data = m_fixtures[fixture];
+
+        Probe probe;
+        int   decoded = 0;
+        QBENCHMARK {
+            probe.start();
+            {
+                QJsonParseError error;
+                QJsonDocument   doc = QJsonDocument::fromJson(data, &error);
+                QVERIFY(error.error == QJsonParseError::NoError);
+                QVariantMap  map = doc.toVariant().toMap();
+                QVariantList results = map.value("MediaContainer").toMap().value("Metadata").toList();
+                QVector<PlexSession> sessions;
+                for (int i = 0; i < results.size(); i++) {
+                    PlexSession session;
+                    fromVariant(results[i], &session.item);
+                    session.player.machineIdentifier =
+                        results[i].toMap().value("Player").toMap().value("machineIdentifier").toString();
+                    session.player.address = results[i].toMap().value("Player").toMap().value("address").toString();
+                    session.player.platform = results[i].toMap().value("Player").toMap().value("platform").toString();
+                    session.userThumb = results[i].toMap().value("User").toMap().value("thumb").toString();
+                    sessions.append(session);
+                }
+                decoded = sessions.size();
+            }
+            probe.stop();
+        }
+        QCOMPARE(decoded, items);
+        record(probe);
+    }
+
+    void decodeNotification_data() {
+        QTest::addColumn<QString>("fixture");
+        QTest::addColumn<int>("items");
+        QTest::newRow("playing") << "notification_playing.json" << 1;
+        QTest::newRow("timeline_50") << "notification_timeline.json" << 50;
+    }
+
+    // every message of the notification websocket goes through here while a session is followed that way
+    void decodeNotification() {
+        QFETCH(QString, fixture);
+        QFETCH(int, items);
+        const QByteArray& data = m_fixtures[fixture];
+
+        Probe probe;
+        int   decoded = 0;
+        QBENCHMARK {
+            probe.start();
+            {
+                PlexNotification notification;
+                QVERIFY(PlexJsonDecoder::decodeNotification(data, &notification));
+                decoded = notification.playSessions.size() + notification.timeline.size();
+            }
+            probe.stop();
+        }
+        QCOMPARE(decoded, items);
+        record(probe);
+    }
+
+    void decodeTimeline() {
+        const QByteArray& xml = m_fixtures["timeline.xml"];
+
+        Probe        probe;
+        PlexTimeline timeline;
+        QBENCHMARK {
+            probe.start();
+            timeline = PlexTimeline();
+            PlexTimelineDecoder::decode(xml, &timeline);
+            probe.stop();
+        }
+        QCOMPARE(timeline.state, QString("playing"));
+        QCOMPARE(timeline.time, qint64(81234));
+        record(probe);
+    }
+
+    // the DOM walk the decoder replaced, for comparison: a QString copy of the reply, a QDomDocument of it, and
+    // every timeline's attributes looked up by name
+    void decodeTimelineDom() {
+        const QByteArray& xml = m_fixtures["timeline.xml"];
+
+        Probe        probe;
+        PlexTimeline timeline;
+        QBENCHMARK {
+            probe.start();
+            timeline = PlexTimeline();
+            QString      answer = xml;
+            QDomDocument doc;
+            QVERIFY(doc.setContent(answer, true));
+            QDomNodeList timelines = doc.elementsByTagName("Timeline");
+            for (int i = 0; i < timelines.size(); i++) {
+                QDomElement n = timelines.item(i).toElement();
+                if (n.attribute("state") != "stopped") {
+                    timeline.volume = n.attribute("volume").toInt();
+                    timeline.playQueueID = n.attribute("playQueueID");
+                    if (n.hasAttribute("playQueueVersion")) {
+                        timeline.playQueueVersion = n.attribute("playQueueVersion").toLongLong();
+                    }
+                    timeline.playQueueItemID = n.attribute("playQueueItemID").toLongLong();
+                    timeline.state = n.attribute("state");
+                    timeline.duration = n.attribute("duration").toInt();
+                    timeline.time = n.attribute("time").toInt();
+                    timeline.ratingKey = n.attribute("ratingKey");
+                    timeline.type = n.attribute("type");
+                    timeline.active = true;
+                }
+            }
+            probe.stop();
+        }
+        QCOMPARE(timeline.state, QString("playing"));
+        QCOMPARE(timeline.time, qint64(81234));
+        record(probe);
+    }
+
+    void sessions_data() {
+        QTest::addColumn<QString>("fixture");
+        QTest::newRow("sessions_1") << "sessions_1.json";
+        QTest::newRow("sessions_20") << "sessions_20.json";
+    }
+
+    // what a sessions reply costs beyond decoding: the table update and every player's position
+    void sessions() {
+        QFETCH(QString, fixture);
+        PlexMediaContainer container;
+        QVERIFY(PlexJsonDecoder::decode(m_fixtures[fixture], &container));
+
+        Probe            probe;
+        PlexSessionTable table;
+        qint64           positions = 0;
+        QBENCHMARK {
+            probe.start();
+            table.update(container.sessions);
+            for (int i = 0; i < container.sessions.size(); i++) {
+                positions += table.position(container.sessions[i].player.machineIdentifier);
+            }
+            probe.stop();
+        }
+        QVERIFY(positions > 0);
+        record(probe);
+    }
+
+    void browse_data() {
+        QTest::addColumn<QString>("fixture");
+        QTest::newRow("allleaves_3000") << "allleaves_3000.json";
+        QTest::newRow("playlist_5000") << "playlist_5000.json";
+    }
+
+    // the list built for the UI from a decoded reply, rows and thumbnail urls as getEpisodes and getPlaylist make them
+    void browse() {
+        QFETCH(QString, fixture);
+        PlexMediaContainer container;
+        QVERIFY(PlexJsonDecoder::decode(m_fixtures[fixture], &container));
+        PlexArtwork artwork(nullptr, m_cacheDir.path(), 0);
+        artwork.setServer("http://192.168.1.10:32400", "token");
+
+        Probe             probe;
+        const QStringList commands = {"PLAY", "QUEUE"};
+        QBENCHMARK {
+            probe.start();
+            BrowseModel* model = new BrowseModel(nullptr, container.ratingKey, container.title, "", "playlist",
+                                                 artwork.url(container.thumb, PlexArtwork::ARTWORK), commands);
+            for (int i = 0; i < container.metadata.size(); i++) {
+                const PlexMetadataItem& item = container.metadata[i];
+                QString subtitle = item.type == "episode" ? item.grandparentTitle + " - " + item.parentTitle
+                                                          : item.grandparentTitle;
+                model->addItem(item.ratingKey, item.title, subtitle, item.type,
+                               artwork.url(item.image(), PlexArtwork::THUMBNAIL), commands);
+            }
+            delete model;
+            probe.stop();
+        }
+        record(probe);
+    }
+
+    // search results as publishSearch groups them, from a decoded server search reply
+    void search() {
+        PlexMediaContainer container;
+        QVERIFY(PlexJsonDecoder::decode(m_fixtures["search_500.json"], &container));
+        PlexArtwork artwork(nullptr, m_cacheDir.path(), 0);
+        artwork.setServer("http://192.168.1.10:32400", "token");
+        const QStringList groups = {"album", "track", "artist", "playlist", "movie", "show", "episode"};
+
+        Probe probe;
+        int   found = 0;
+        QBENCHMARK {
+            probe.start();
+            found = 0;
+            QMap<QString, SearchModelList*> lists;
+            for (int i = 0; i < groups.size(); i++) {
+                lists.insert(groups[i], new SearchModelList());
+            }
+            for (int i = 0; i < container.metadata.size(); i++) {
+                PlexLibraryIndex::Item result = PlexLibraryIndex::fromMetadata(container.metadata[i], 0);
+                if (!lists.contains(result.type)) continue;
+                found++;
+                lists[result.type]->append(SearchModelListItem(result.ratingKey, result.type, result.title,
+                                                               result.subtitle,
+                                                               artwork.url(result.thumb, PlexArtwork::THUMBNAIL),
+                                                               QStringList({"PLAY", "QUEUE"})));
+            }
+            SearchModel* model = new SearchModel();
+            for (int i = 0; i < groups.size(); i++) {
+                model->append(new SearchModelItem(groups[i] + "s", lists[groups[i]]));
+            }
+            delete model;
+            probe.stop();
+        }
+        QCOMPARE(found, 500);
+        record(probe);
+    }
+
+    // every case against the baseline: allocating more than its tolerance, or missing from it, fails. Slower only fails
+    // on the machine that recorded it, elsewhere it is a warning. With PLEXMEDIA_BENCHMARK_UPDATE=1 the results of
+    // this run become the baseline instead.
+    void compareWithBaseline() {
+        QFile file(BASELINE_FILE);
+        QVERIFY2(file.open(QIODevice::ReadOnly), qPrintable(file.fileName() + ": " + file.errorString()));
+        QJsonObject baseline = QJsonDocument::fromJson(file.readAll()).object();
+        file.close();
+        QJsonObject cases = baseline.value("cases").toObject();
+
+        if (qgetenv("PLEXMEDIA_BENCHMARK_UPDATE") == "1") {
+            QVERIFY2(allocationsCounted(), "record on a platform that counts allocations, they are compared anywhere");
+            for (QMap<QString, Probe>::const_iterator i = m_results.constBegin(); i != m_results.constEnd(); ++i) {
+                QJsonObject result;
+                result.insert("nsecs", i.value().nsecs);
+                result.insert("allocations", static_cast<qint64>(i.value().allocations));
+                cases.insert(i.key(), result);
+            }
+            baseline.insert("cases", cases);
+            baseline.insert("host", QSysInfo::machineHostName());
+            QVERIFY2(file.open(QIODevice::WriteOnly | QIODevice::Truncate), qPrintable(file.errorString()));
+            file.write(QJsonDocument(baseline).toJson());
+            return;
+        }
+
+        QJsonObject tolerance = baseline.value("tolerance").toObject();
+        double      timeTolerance = tolerance.value("nsecs").toDouble(0.25);
+        double      allocationTolerance = tolerance.value("allocations").toDouble(0.02);
+        bool        recordedHere = baseline.value("host").toString() == QSysInfo::machineHostName();
+        QStringList regressions;
+        for (QMap<QString, Probe>::const_iterator i = m_results.constBegin(); i != m_results.constEnd(); ++i) {
+            if (!cases.contains(i.key())) {
+                regressions << i.key() + ": not in the baseline, record it with PLEXMEDIA_BENCHMARK_UPDATE=1";
+                continue;
+            }
+            QJsonObject expected = cases.value(i.key()).toObject();
+            double      nsecs = expected.value("nsecs").toDouble();
+            double      allocations = expected.value("allocations").toDouble();
+            qInfo("%s: %lld ns (baseline %.0f), %llu allocations (baseline %.0f)", qPrintable(i.key()),
+                  i.value().nsecs, nsecs, i.value().allocations, allocations);
+            if (i.value().nsecs > nsecs * (1 + timeTolerance)) {
+                QString slower = i.key() + ": " + QString::number(i.value().nsecs) + " ns, baseline " +
+                                 QString::number(nsecs, 'f', 0);
+                if (recordedHere) {
+                    regressions << slower;
+                } else {
+                    qWarning("%s (recorded on another machine)", qPrintable(slower));
+                }
+            }
+            if (allocationsCounted() && i.value().allocations > allocations * (1 + allocationTolerance)) {
+                regressions << i.key() + ": " + QString::number(i.value().allocations) + " allocations, baseline " +
+                                   QString::number(allocations, 'f', 0);
+            }
+        }
+        QVERIFY2(regressions.isEmpty(), qPrintable(regressions.join("\n")));
+    }
+
+ private:
+    static void fromVariant(const QVariant& metadata, PlexMetadataItem* item) {
+        item->ratingKey = metadata.toMap().value("ratingKey").toString();
+        item->key = metadata.toMap().value("key").toString();
+        item->type = metadata.toMap().value("type").toString();
+        item->title = metadata.toMap().value("title").toString();
+        item->titleSort = metadata.toMap().value("titleSort").toString();
+        item->originalTitle = metadata.toMap().value("originalTitle").toString();
+        item->parentTitle = metadata.toMap().value("parentTitle").toString();
+        item->grandparentTitle = metadata.toMap().value("grandparentTitle").toString();
+        item->thumb = metadata.toMap().value("thumb").toString();
+        item->parentThumb = metadata.toMap().value("parentThumb").toString();
+        item->grandparentThumb = metadata.toMap().value("grandparentThumb").toString();
+        item->summary = metadata.toMap().value("summary").toString();
+        item->playlistType = metadata.toMap().value("playlistType").toString();
+        item->librarySectionTitle = metadata.toMap().value("librarySectionTitle").toString();
+        item->leafCount = metadata.toMap().value("leafCount").toString();
+        item->duration = metadata.toMap().value("duration").toLongLong();
+        item->viewOffset = metadata.toMap().value("viewOffset").toLongLong();
+        item->updatedAt = metadata.toMap().value("updatedAt").toLongLong();
+        item->playQueueItemID = metadata.toMap().value("playQueueItemID").toLongLong();
+    }
+
+    // results are named function/row, i.e. "decode/playlist_5000"
+    void record(const Probe& probe) {
+        QString name = QTest::currentTestFunction();
+        if (QTest::currentDataTag()) name += QString("/") + QTest::currentDataTag();
+        m_results.insert(name, probe);
+    }
+
+    QHash<QString, QByteArray> m_fixtures;
+    QTemporaryDir              m_cacheDir;  // empty artwork cache: every thumbnail is a transcode url
+    QMap<QString, Probe>       m_results;
+};
+
+QTEST_GUILESS_MAIN(BenchPlexMedia)
+
+#include "bench_plexmedia.moc"
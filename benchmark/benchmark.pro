@@ -0,0 +1,54 @@
+# Benchmarks of the reply handlers over large-library fixtures: decode, handler and model build time and heap
+# allocations, checked against baseline.json. Build and run with: qmake && make check
+# Record a new baseline with: PLEXMEDIA_BENCHMARK_UPDATE=1 make check
+TEMPLATE  = app
+QT       += core network testlib
+QT       += xml  # only for the DOM path the timeline decoder is compared with
+CONFIG   += testcase console c++11
+CONFIG   -= app_bundle
+TARGET    = bench_plexmedia
+
+INTG_LIB_PATH = $$(YIO_SRC)
+isEmpty(INTG_LIB_PATH) {
+    INTG_LIB_PATH = $$clean_path($$PWD/../../integrations.library)
+    message("Environment variables YIO_SRC not defined! Using '$$INTG_LIB_PATH' for integrations.library project.")
+} else {
+    INTG_LIB_PATH = $$(YIO_SRC)/integrations.library
+    message("YIO_SRC is set: using '$$INTG_LIB_PATH' for integrations.library project.")
+}
+
+! include($$INTG_LIB_PATH/yio-model-mediaplayer.pri) {
+    error( "Cannot find the yio-model-mediaplayer.pri file!" )
+}
+
+# the fixtures are generated into the build directory, the same on every checkout
+FIXTURE_PATH = $$OUT_PWD/fixtures
+! system(python3 $$shell_quote($$PWD/fixtures/generate.py) $$shell_quote($$FIXTURE_PATH)) {
+    error( "Cannot write the benchmark fixtures to $$FIXTURE_PATH" )
+}
+DEFINES += FIXTURE_PATH=\\\"$$FIXTURE_PATH\\\" \
+    BASELINE_FILE=\\\"$$PWD/baseline.json\\\"
+
+SRC_PATH = $$PWD/../src
+INCLUDEPATH += $$SRC_PATH
+
+HEADERS += allocations.h \
+    $$SRC_PATH/plexartwork.h \
+    $$SRC_PATH/plexhttpclient.h \
+    $$SRC_PATH/plexjsondecoder.h \
+    $$SRC_PATH/plexlibraryindex.h \
+    $$SRC_PATH/plexmetrics.h \
+    $$SRC_PATH/plexrequest.h \
+    $$SRC_PATH/plexsessiontable.h \
+    $$SRC_PATH/plextimelinedecoder.h \
+    $$SRC_PATH/plextypes.h
+SOURCES += allocations.cpp \
+    bench_plexmedia.cpp \
+    $$SRC_PATH/plexartwork.cpp \
+    $$SRC_PATH/plexhttpclient.cpp \
+    $$SRC_PATH/plexjsondecoder.cpp \
+    $$SRC_PATH/plexlibraryindex.cpp \
+    $$SRC_PATH/plexmetrics.cpp \
+    $$SRC_PATH/plexrequest.cpp \
+    $$SRC_PATH/plexsessiontable.cpp \
+    $$SRC_PATH/plextimelinedecoder.cpp
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+# Writes the benchmark fixtures. Every reply has the layout and field set of a Plex Media Server 1.2x reply to the
+# same endpoint (Media/Part arrays, users and players included), with generated titles, ids and paths. Deterministic:
+# running it again gives the same files, so baselines recorded on one checkout hold for another. They add up to
+# about 10 MB and are written into the build directory by benchmark.pro rather than kept in the repository.
+# Usage: python3 generate.py <output directory>
+
+import json
+import os
+import random
+import sys
+
+if len(sys.argv) != 2:
+    sys.exit("usage: generate.py <output directory>")
+OUT = sys.argv[1]
+if not os.path.isdir(OUT):
+    os.makedirs(OUT)
+rng = random.Random(2019)
+WORDS = ("night summer river blue lost city fire light road home dream heart ghost paper gold silver winter echo "
+         "shadow north glass stone wild quiet open last first little broken electric hollow").split()
+PLATFORMS = ["Android", "iOS", "Windows", "macOS", "Chromecast", "Roku", "Linux", "tvOS"]
+
+
+def title(words=3):
+    return " ".join(rng.choice(WORDS) for _ in range(words)).title()
+
+
+def media(key, duration, video):
+    part = {"id": key * 3, "key": "/library/parts/%d/1580000000/file" % (key * 3), "duration": duration,
+            "file": "/data/media/%s/%d.%s" % ("tv" if video else "music", key, "mkv" if video else "flac"),
+            "size": rng.randint(5, 900) * 1000000, "container": "mkv" if video else "flac"}
+    item = {"id": key * 2, "duration": duration, "bitrate": rng.randint(800, 9000),
+            "container": part["container"], "Part": [part]}
+    if video:
+        item.update({"width": 1920, "height": 1080, "aspectRatio": 1.78, "audioChannels": 6, "audioCodec": "eac3",
+                     "videoCodec": "h264", "videoResolution": "1080", "videoFrameRate": "24p"})
+    else:
+        item.update({"audioChannels": 2, "audioCodec": "flac"})
+    return [item]
+
+
+def track(key, queue_item=None):
+    artist, album = 1000 + key // 120, 5000 + key // 12
+    duration = rng.randint(120, 420) * 1000
+    item = {"ratingKey": str(key), "key": "/library/metadata/%d" % key, "parentRatingKey": str(album),
+            "grandparentRatingKey": str(artist), "guid": "plex://track/%024x" % key, "type": "track",
+            "title": title(), "grandparentKey": "/library/metadata/%d" % artist,
+            "parentKey": "/library/metadata/%d" % album, "librarySectionTitle": "Music", "librarySectionID": 3,
+            "grandparentTitle": title(2), "parentTitle": title(2), "summary": "", "index": key % 12 + 1,
+            "parentIndex": 1, "ratingCount": rng.randint(0, 90000), "parentYear": rng.randint(1960, 2020),
+            "thumb": "/library/metadata/%d/thumb/1580000000" % album,
+            "parentThumb": "/library/metadata/%d/thumb/1580000000" % album,
+            "grandparentThumb": "/library/metadata/%d/thumb/1580000000" % artist, "duration": duration,
+            "addedAt": 1570000000 + key, "updatedAt": 1580000000 + key, "Media": media(key, duration, False)}
+    if queue_item is not None:
+        item["playQueueItemID"] = queue_item
+    return item
+
+
+def episode(key, show, season):
+    duration = rng.randint(20, 60) * 60000
+    return {"ratingKey": str(key), "key": "/library/metadata/%d" % key, "parentRatingKey": str(season),
+            "grandparentRatingKey": str(show), "guid": "plex://episode/%024x" % key, "type": "episode",
+            "title": title(), "grandparentKey": "/library/metadata/%d" % show,
+            "parentKey": "/library/metadata/%d" % season, "librarySectionTitle": "TV Shows",
+            "librarySectionID": 1, "grandparentTitle": "The Long Running Show", "parentTitle": "Season %d" % (
+                (key - 200000) // 25 + 1), "contentRating": "TV-14",
+            "summary": " ".join(rng.choice(WORDS) for _ in range(30)).capitalize() + ".", "index": key % 25 + 1,
+            "parentIndex": (key - 200000) // 25 + 1, "year": 2000 + (key - 200000) // 25,
+            "thumb": "/library/metadata/%d/thumb/1580000000" % key, "art": "/library/metadata/%d/art/1" % show,
+            "parentThumb": "/library/metadata/%d/thumb/1580000000" % season,
+            "grandparentThumb": "/library/metadata/%d/thumb/1580000000" % show, "duration": duration,
+            "originallyAvailableAt": "2005-01-01", "addedAt": 1570000000 + key, "updatedAt": 1580000000 + key,
+            "Media": media(key, duration, True)}
+
+
+def session(index):
+    item = track(100000 + index * 7, queue_item=900000 + index)
+    item.update({"viewOffset": rng.randint(0, item["duration"]), "sessionKey": str(index + 1),
+                 "User": {"id": str(index + 1), "thumb": "https://plex.tv/users/%016x/avatar" % (index + 1),
+                          "title": "user%d" % (index + 1)},
+                 "Player": {"address": "192.168.1.%d" % (20 + index),
+                            "machineIdentifier": "%032x" % (0xa000 + index),
+                            "model": "", "platform": PLATFORMS[index % len(PLATFORMS)],
+                            "platformVersion": "10", "product": "Plex for %s" % PLATFORMS[index % len(PLATFORMS)],
+                            "profile": "Android", "remotePublicAddress": "203.0.113.7",
+                            "state": "playing" if index % 3 else "paused", "title": "Player %d" % (index + 1),
+                            "vendor": "", "version": "8.4.1", "local": True, "relayed": False, "secure": True,
+                            "userID": index + 1},
+                 "Session": {"id": "%024x" % index, "bandwidth": 1411, "location": "lan"}})
+    return item
+
+
+def write(name, container):
+    with open(os.path.join(OUT, name), "w") as output:
+        json.dump({"MediaContainer": container}, output, separators=(",", ":"))
+
+
+def sessions(count):
+    return {"size": count, "Metadata": [session(i) for i in range(count)]}
+
+
+write("sessions_1.json", sessions(1))
+write("sessions_20.json", sessions(20))
+
+hits = []
+for i in range(500):
+    kind = i % 5
+    if kind in (0, 1):
+        hits.append(track(300000 + i))
+    elif kind == 2:
+        hits.append(episode(200000 + i, 100, 101 + i // 25))
+    elif kind == 3:
+        album = track(400000 + i)
+        album.update({"type": "album", "title": title(2), "leafCount": 12})
+        del album["Media"]
+        hits.append(album)
+    else:
+        artist = {"ratingKey": str(500000 + i), "key": "/library/metadata/%d/children" % (500000 + i),
+                  "guid": "plex://artist/%024x" % i, "type": "artist", "title": title(2),
+                  "librarySectionTitle": "Music", "summary": "", "index": 1,
+                  "thumb": "/library/metadata/%d/thumb/1580000000" % (500000 + i),
+                  "addedAt": 1570000000 + i, "updatedAt": 1580000000 + i}
+        hits.append(artist)
+write("search_500.json", {"size": 500, "identifier": "com.plexapp.plugins.library", "mediaTagPrefix":
+                          "/system/bundle/media/flags/", "Metadata": hits})
+
+write("allleaves_3000.json", {"size": 3000, "totalSize": 3000, "offset": 0, "allowSync": True, "art":
+                              "/library/metadata/100/art/1", "key": "100", "parentTitle": "The Long Running Show",
+                              "title1": "TV Shows", "title2": "The Long Running Show", "thumb":
+                              "/library/metadata/100/thumb/1580000000", "viewGroup": "episode",
+                              "Metadata": [episode(200000 + i, 100, 1000 + i // 25) for i in range(3000)]})
+
+playlist = [track(600000 + i) for i in range(5000)]
+for i, item in enumerate(playlist):
+    item["playlistItemID"] = 700000 + i
+write("playlist_5000.json", {"size": 5000, "totalSize": 5000, "offset": 0, "composite":
+                             "/playlists/42/composite/1580000000", "duration": 1200000000, "leafCount": 5000,
+                             "playlistType": "audio", "ratingKey": "42", "smart": False, "title": "Everything",
+                             "Metadata": playlist})
+
+
+def notify(name, container):
+    with open(os.path.join(OUT, name), "w") as output:
+        json.dump({"NotificationContainer": container}, output, separators=(",", ":"))
+
+
+# what the notification websocket sends for a playing session, and for a burst of library changes during a scan
+notify("notification_playing.json", {"type": "playing", "size": 1, "PlaySessionStateNotification": [
+    {"sessionKey": "1", "clientIdentifier": "%032x" % 0xa000, "guid": "", "ratingKey": "100754",
+     "url": "", "key": "/library/metadata/100754", "viewOffset": 81234, "playQueueItemID": 900000,
+     "playQueueID": 1234, "state": "playing", "transcodeSession": ""}]})
+notify("notification_timeline.json", {"type": "timeline", "size": 50, "TimelineEntry": [
+    {"identifier": "com.plexapp.plugins.library", "sectionID": "3", "itemID": str(600000 + i), "type": 10,
+     "title": title(), "state": 5, "metadataState": "created", "updatedAt": 1580000000 + i} for i in range(50)]})
+
+with open(os.path.join(OUT, "timeline.xml"), "w") as output:
+    output.write('<?xml version="1.0" encoding="UTF-8"?>\n'
+                 '<MediaContainer commandID="17" location="fullScreenMusic">\n'
+                 '  <Timeline address="192.168.1.20" audioStreamID="1160" containerKey="/playQueues/1234?own=1" '
+                 'controllable="playPause,stop,volume,shuffle,repeat,seekTo,skipPrevious,skipNext,stepBack,'
+                 'stepForward" duration="273000" guid="plex://track/000000000000000000018a92" itemType="music" '
+                 'key="/library/metadata/100754" machineIdentifier="%032x" playQueueID="1234" '
+                 'playQueueItemID="900000" playQueueVersion="3" port="32400" protocol="http" providerIdentifier='
+                 '"com.plexapp.plugins.library" ratingKey="100754" repeat="0" seekRange="0-273000" shuffle="0" '
+                 'state="playing" time="81234" token="xxxxxxxxxxxxxxxxxxxx" type="music" volume="65" />\n'
+                 '  <Timeline location="navigation" state="stopped" time="0" type="video" />\n'
+                 '  <Timeline location="navigation" state="stopped" time="0" type="photo" />\n'
+                 '</MediaContainer>\n' % 0xa000)
@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+# Runs the plugin against the stand-in server for a long time and reports what it costs: requests per second by
+# endpoint (counted by plexmock), CPU time and memory growth of the process that hosts the plugin (the remote
+# software, read from /proc, so Linux only).
+#
+# Start plexmock first, then either let the driver start the remote and stop it at the end:
+#   loaddriver.py --duration 4h -- /opt/yio/app-launcher/remote
+# or watch one that is already running:
+#   loaddriver.py --duration 4h --pid 1234
+# The remote's config has to point the Plex integration at the mock (see mock/main.cpp).
+
+import argparse
+import json
+import os
+import signal
+import subprocess
+import sys
+import time
+import urllib.request
+
+TICK = os.sysconf("SC_CLK_TCK")
+
+
+def duration(text):
+    units = {"s": 1, "m": 60, "h": 3600}
+    if text[-1] in units:
+        return float(text[:-1]) * units[text[-1]]
+    return float(text)
+
+
+def cpu_seconds(pid):
+    with open("/proc/%d/stat" % pid) as stat:
+        fields = stat.read().rsplit(")", 1)[1].split()
+    return (int(fields[11]) + int(fields[12])) / TICK  # utime and stime
+
+
+def rss_mb(pid):
+    with open("/proc/%d/status" % pid) as status:
+        for line in status:
+            if line.startswith("VmRSS:"):
+                return int(line.split()[1]) / 1024.0
+    return 0.0
+
+
+def mock_stats(url):
+    with urllib.request.urlopen(url + "/mock/stats", timeout=5) as reply:
+        stats = json.load(reply)
+    requests = {}
+    for side in ("server", "player"):
+        for endpoint, count in stats[side]["requests"].items():
+            requests[side + " " + endpoint] = count
+    errors = stats["server"]["errors"] + stats["player"]["errors"]
+    return requests, errors
+
+
+def slope(points):
+    # least squares, per second
+    if len(points) < 2:
+        return 0.0
+    n = float(len(points))
+    mean_t = sum(t for t, _ in points) / n
+    mean_v = sum(v for _, v in points) / n
+    var = sum((t - mean_t) ** 2 for t, _ in points)
+    return sum((t - mean_t) * (v - mean_v) for t, v in points) / var if var else 0.0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--mock", default="http://127.0.0.1:32400", help="URL of the plexmock server")
+    parser.add_argument("--duration", type=duration, default=3600, help="run time, i.e. 90m or 4h")
+    parser.add_argument("--interval", type=duration, default=60, help="time between samples")
+    parser.add_argument("--warmup", type=duration, default=300, help="left out of the memory growth")
+    parser.add_argument("--pid", type=int, help="process to watch instead of starting one")
+    parser.add_argument("command", nargs=argparse.REMAINDER, help="-- command that starts the remote")
+    args = parser.parse_args()
+
+    command = [c for c in args.command if c != "--"]
+    if not args.pid and not command:
+        parser.error("give --pid or a command to start")
+    process = subprocess.Popen(command) if command else None
+    pid = process.pid if process else args.pid
+
+    start = time.time()
+    start_cpu = cpu_seconds(pid)
+    start_requests, start_errors = mock_stats(args.mock)
+    last, last_requests = start, start_requests
+    memory = []
+    print("%8s %10s %8s %8s %9s" % ("minutes", "requests/s", "errors", "cpu %", "rss MB"))
+    try:
+        while time.time() - start < args.duration:
+            time.sleep(args.interval)
+            now = time.time()
+            requests, errors = mock_stats(args.mock)
+            rate = (sum(requests.values()) - sum(last_requests.values())) / (now - last)
+            cpu = 100.0 * (cpu_seconds(pid) - start_cpu) / (now - start)
+            rss = rss_mb(pid)
+            if now - start >= args.warmup:
+                memory.append((now - start, rss))
+            print("%8.1f %10.2f %8d %8.1f %9.1f" % ((now - start) / 60, rate, errors - start_errors, cpu, rss))
+            sys.stdout.flush()
+            last, last_requests = now, requests
+    except (KeyboardInterrupt, FileNotFoundError):
+        pass  # stopped early, or the remote exited: report what was seen
+    finally:
+        elapsed = time.time() - start
+        print("\nRun time %.1f min" % (elapsed / 60))
+        try:
+            print("CPU time %.1f s (%.2f %% of one core)" % (cpu_seconds(pid) - start_cpu,
+                                                             100.0 * (cpu_seconds(pid) - start_cpu) / elapsed))
+        except FileNotFoundError:
+            print("CPU time unknown, the process has exited")
+        if memory:
+            print("Memory %.1f MB after warm-up, %.1f MB at the end, growth %.2f MB/hour" %
+                  (memory[0][1], memory[-1][1], slope(memory) * 3600))
+        print("\nRequests per second by endpoint:")
+        requests, errors = mock_stats(args.mock)
+        for endpoint in sorted(requests, key=lambda e: -(requests[e] - start_requests.get(e, 0))):
+            count = requests[endpoint] - start_requests.get(endpoint, 0)
+            if count:
+                print("  %8.3f  %s" % (count / elapsed, endpoint))
+        print("Injected errors: %d" % (errors - start_errors))
+        if process:
+            process.send_signal(signal.SIGTERM)
+            process.wait()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,78 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+
+#include "mocklibrary.h"
+#include "mockplexplayer.h"
+#include "mockplexserver.h"
+
+// Local stand-in for a Plex Media Server and one player, for running the plugin without real devices. Point the
+// integration at it with server_address 127.0.0.1, the server port and any auth_token (the mock takes every token),
+// and leave discovery off: the player is found through /clients.
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("plexmock");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Stand-in Plex Media Server and player for load and latency testing");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"server-port", "Port of the server.", "port", "32400"},
+        {"player-port", "Port of the player.", "port", "32500"},
+        {"latency", "Milliseconds added to every reply.", "ms", "0"},
+        {"jitter", "Up to this many milliseconds more or less per reply, at random.", "ms", "0"},
+        {"error-rate", "Share of requests answered with a 500, 0 to 1.", "rate", "0"},
+        {"sessions", "Sessions of other players listed next to the mock player's.", "count", "0"},
+        {"tracks", "Tracks in the library.", "count", "5000"},
+        {"seed", "Seed of the library and of the injected faults.", "seed", "2019"},
+    });
+    parser.process(app);
+
+    MockHttpServer::Faults faults;
+    faults.latency = parser.value("latency").toInt();
+    faults.jitter = parser.value("jitter").toInt();
+    faults.errorRate = parser.value("error-rate").toDouble();
+    quint32 seed = parser.value("seed").toUInt();
+
+    MockLibrary    library(qMax(1, parser.value("tracks").toInt()), seed);
+    MockPlexPlayer player(&library);
+    MockPlexServer server(&library, &player, qMax(0, parser.value("sessions").toInt()));
+    player.setFaults(faults, seed);
+    server.setFaults(faults, seed + 1);
+
+    QTextStream err(stderr);
+    if (!player.listen(static_cast<quint16>(parser.value("player-port").toUInt()))) {
+        err << "Cannot listen on player port " << parser.value("player-port") << endl;
+        return 1;
+    }
+    if (!server.listen(static_cast<quint16>(parser.value("server-port").toUInt()))) {
+        err << "Cannot listen on server port " << parser.value("server-port") << endl;
+        return 1;
+    }
+    err << "Server on port " << server.port() << ", player on port " << player.port() << ", "
+        << library.trackCount() << " tracks" << endl;
+
+    return app.exec();
+}
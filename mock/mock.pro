@@ -0,0 +1,20 @@
+# Stand-in Plex Media Server and player, and the load driver that runs the plugin against them.
+# Build with: qmake && make. See main.cpp for the integration settings and loaddriver.py for the driver.
+TEMPLATE  = app
+QT       += core network
+QT       -= gui
+CONFIG   += console c++11
+CONFIG   -= app_bundle
+TARGET    = plexmock
+
+HEADERS += mockhttpserver.h \
+    mocklibrary.h \
+    mockplexplayer.h \
+    mockplexserver.h
+SOURCES += main.cpp \
+    mockhttpserver.cpp \
+    mocklibrary.cpp \
+    mockplexplayer.cpp \
+    mockplexserver.cpp
+
+DISTFILES += loaddriver.py
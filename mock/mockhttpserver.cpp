@@ -0,0 +1,193 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "mockhttpserver.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QPointer>
+#include <QTimer>
+
+MockHttpServer::MockHttpServer(QObject* parent) : QObject(parent) {
+    QObject::connect(&m_server, &QTcpServer::newConnection, this, [this]() {
+        while (m_server.hasPendingConnections()) {
+            QTcpSocket* socket = m_server.nextPendingConnection();
+            m_connections.insert(socket, Connection());
+            QObject::connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+            QObject::connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+                m_connections.remove(socket);
+                socket->deleteLater();
+            });
+        }
+    });
+}
+
+bool MockHttpServer::listen(quint16 port) { return m_server.listen(QHostAddress::Any, port); }
+
+void MockHttpServer::setFaults(const Faults& faults, quint32 seed) {
+    m_faults = faults;
+    m_random.seed(seed);
+}
+
+QJsonObject MockHttpServer::stats() const {
+    QJsonObject requests;
+    for (QMap<QString, qint64>::const_iterator iter = m_requests.constBegin(); iter != m_requests.constEnd(); ++iter) {
+        requests.insert(iter.key(), iter.value());
+    }
+    QJsonObject stats;
+    stats.insert("requests", requests);
+    stats.insert("errors", m_errors);
+    stats.insert("total", m_total);
+    return stats;
+}
+
+MockHttpServer::Reply MockHttpServer::json(const QJsonObject& container) {
+    QJsonObject root;
+    root.insert("MediaContainer", container);
+    Reply reply;
+    reply.body = QJsonDocument(root).toJson(QJsonDocument::Compact);
+    return reply;
+}
+
+MockHttpServer::Reply MockHttpServer::xml(const QByteArray& body) {
+    Reply reply;
+    reply.contentType = "text/xml;charset=utf-8";
+    reply.body = body;
+    return reply;
+}
+
+MockHttpServer::Reply MockHttpServer::status(int code) {
+    Reply reply;
+    reply.status = code;
+    reply.contentType = "text/plain";
+    return reply;
+}
+
+void MockHttpServer::page(const QVector<QJsonObject>& items, const QUrlQuery& query, QJsonObject* container) {
+    int start = query.hasQueryItem("X-Plex-Container-Start")
+                    ? query.queryItemValue("X-Plex-Container-Start").toInt() : 0;
+    int size = query.hasQueryItem("X-Plex-Container-Size")
+                   ? query.queryItemValue("X-Plex-Container-Size").toInt() : items.size();
+    start = qBound(0, start, items.size());
+    size = qBound(0, size, items.size() - start);
+
+    QJsonArray metadata;
+    for (int i = start; i < start + size; i++) {
+        metadata.append(items[i]);
+    }
+    container->insert("size", size);
+    container->insert("totalSize", items.size());
+    container->insert("offset", start);
+    if (size > 0) container->insert("Metadata", metadata);
+}
+
+void MockHttpServer::onReadyRead(QTcpSocket* socket) {
+    Connection& connection = m_connections[socket];
+    connection.buffer.append(socket->readAll());
+    if (connection.busy) {
+        return;  // picked up once the reply to the previous request is written
+    }
+
+    int headerEnd = connection.buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        return;
+    }
+    QList<QByteArray> lines = connection.buffer.left(headerEnd).split('\n');
+    QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    int               contentLength = 0;
+    bool              close = false;
+    for (int i = 1; i < lines.size(); i++) {
+        int        colon = lines[i].indexOf(':');
+        QByteArray name = lines[i].left(colon).trimmed().toLower();
+        QByteArray value = lines[i].mid(colon + 1).trimmed();
+        if (name == "content-length") contentLength = value.toInt();
+        if (name == "connection") close = value.toLower() == "close";
+    }
+    if (requestLine.size() < 3 || contentLength < 0) {
+        socket->abort();
+        return;
+    }
+    if (connection.buffer.size() < headerEnd + 4 + contentLength) {
+        return;  // rest of the body still to come
+    }
+
+    Request request;
+    request.method = requestLine[0];
+    request.url = QUrl("http://mock" + requestLine[1]);
+    request.query = QUrlQuery(request.url);
+    request.body = connection.buffer.mid(headerEnd + 4, contentLength);
+    connection.buffer.remove(0, headerEnd + 4 + contentLength);
+    connection.busy = true;
+
+    QString path = request.url.path();
+    Reply   reply;
+    if (path == "/mock/stats") {
+        reply = handle(request);  // the load driver's own requests are neither delayed, failed nor counted
+        respond(socket, reply, close);
+        return;
+    }
+    m_total++;
+    m_requests[QString::fromLatin1(request.method) + " " + endpoint(path)]++;
+    if (m_faults.errorRate > 0 && m_random.generateDouble() < m_faults.errorRate) {
+        m_errors++;
+        reply = status(500);
+    } else {
+        reply = handle(request);
+    }
+
+    int delay = m_faults.latency;
+    if (m_faults.jitter > 0) delay += m_random.bounded(2 * m_faults.jitter + 1) - m_faults.jitter;
+    QPointer<QTcpSocket> target(socket);
+    QTimer::singleShot(qMax(0, delay), this, [=]() {
+        if (target) respond(target, reply, close);
+    });
+}
+
+void MockHttpServer::respond(QTcpSocket* socket, const Reply& reply, bool close) {
+    static const QHash<int, QByteArray> reasons = {
+        {200, "OK"}, {400, "Bad Request"}, {404, "Not Found"}, {500, "Internal Server Error"}};
+
+    QByteArray head = "HTTP/1.1 " + QByteArray::number(reply.status) + " " + reasons.value(reply.status, "Error") +
+                      "\r\nContent-Type: " + reply.contentType +
+                      "\r\nContent-Length: " + QByteArray::number(reply.body.size()) +
+                      (close ? "\r\nConnection: close" : "\r\nConnection: keep-alive") + "\r\n\r\n";
+    socket->write(head + reply.body);
+    if (close) {
+        socket->disconnectFromHost();
+        return;
+    }
+    if (!m_connections.contains(socket)) {
+        return;  // the client hung up while the reply was held back
+    }
+    m_connections[socket].busy = false;
+    if (!m_connections[socket].buffer.isEmpty()) onReadyRead(socket);  // a request that came in meanwhile
+}
+
+QString MockHttpServer::endpoint(const QString& path) const {
+    QStringList segments = path.split('/');
+    for (int i = 0; i < segments.size(); i++) {
+        bool number = false;
+        segments[i].toLongLong(&number);
+        if (number) segments[i] = "{id}";
+    }
+    return segments.join('/');
+}
@@ -0,0 +1,99 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QJsonObject>
+#include <QMap>
+#include <QRandomGenerator>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUrl>
+#include <QUrlQuery>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMOCK HTTP SERVER
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Minimal HTTP/1.1 server for the stand-ins: keep-alive connections, one request at a time per connection, replies
+// held back by the configured latency and jitter, and a share of requests answered with a 500 instead of being
+// handled. Counts the requests per endpoint, ids folded into {id}.
+class MockHttpServer : public QObject {
+    Q_OBJECT
+
+ public:
+    struct Faults {
+        int    latency = 0;    // ms added to every reply
+        int    jitter = 0;     // up to this many ms more or less, at random
+        double errorRate = 0;  // share of requests failed with a 500, 0..1
+    };
+    struct Request {
+        QByteArray method;
+        QUrl       url;
+        QUrlQuery  query;
+        QByteArray body;
+    };
+    struct Reply {
+        int        status = 200;
+        QByteArray contentType = "application/json";
+        QByteArray body;
+    };
+
+    explicit MockHttpServer(QObject* parent = nullptr);
+
+    bool    listen(quint16 port);
+    quint16 port() const { return m_server.serverPort(); }
+
+    void setFaults(const Faults& faults, quint32 seed);
+
+    // {"requests": {endpoint: count}, "errors": injected 500s, "total": requests}
+    QJsonObject stats() const;
+
+ protected:
+    virtual Reply handle(const Request& request) = 0;
+
+    static Reply json(const QJsonObject& container);  // wrapped in a MediaContainer like every server reply
+    static Reply xml(const QByteArray& body);
+    static Reply status(int code);
+
+    // one page of a list, by the X-Plex-Container-Start/Size parameters. The container gets size, totalSize, offset.
+    static void page(const QVector<QJsonObject>& items, const QUrlQuery& query, QJsonObject* container);
+
+ private:
+    struct Connection {
+        QByteArray buffer;
+        bool       busy = false;  // a reply is on its way, the next request waits for it
+    };
+
+    void    onReadyRead(QTcpSocket* socket);
+    void    respond(QTcpSocket* socket, const Reply& reply, bool close);
+    QString endpoint(const QString& path) const;
+
+    QTcpServer                      m_server;
+    QHash<QTcpSocket*, Connection>  m_connections;
+    Faults                          m_faults;
+    QRandomGenerator                m_random;
+    QMap<QString, qint64>           m_requests;
+    qint64                          m_errors = 0;
+    qint64                          m_total = 0;
+};
@@ -0,0 +1,259 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "mocklibrary.h"
+
+#include <QJsonArray>
+#include <QRandomGenerator>
+
+#include <algorithm>
+
+static const char* const WORDS[] = {"night",  "summer", "river",  "blue",     "lost",   "city",    "fire",   "light",
+                                    "road",   "home",   "dream",  "heart",    "ghost",  "paper",   "gold",   "silver",
+                                    "winter", "echo",   "shadow", "north",    "glass",  "stone",   "wild",   "quiet",
+                                    "open",   "last",   "first",  "electric", "broken", "morning", "hollow", "little"};
+
+static QString title(QRandomGenerator* random, int words) {
+    QStringList title;
+    for (int i = 0; i < words; i++) {
+        QString word = WORDS[random->bounded(static_cast<int>(sizeof(WORDS) / sizeof(WORDS[0])))];
+        word[0] = word[0].toUpper();
+        title.append(word);
+    }
+    return title.join(' ');
+}
+
+MockLibrary::MockLibrary(int tracks, quint32 seed) : m_seed(seed) {
+    QRandomGenerator random(seed);
+    int              albums = (tracks + 9) / 10;
+    for (int i = 0; i < (albums + 4) / 5; i++) {
+        m_artists.append(title(&random, 2));
+    }
+    for (int i = 0; i < albums; i++) {
+        m_albums.append(title(&random, 3));
+    }
+    for (int i = 0; i < tracks; i++) {
+        m_tracks.append(title(&random, 3));
+        m_durations.append(1000 * random.bounded(120, 360));
+    }
+}
+
+QJsonObject MockLibrary::artist(int index) const {
+    QString key = QString::number(ARTIST_BASE + index);
+    return QJsonObject({{"ratingKey", key},
+                        {"key", "/library/metadata/" + key + "/children"},
+                        {"type", "artist"},
+                        {"title", m_artists[index]},
+                        {"librarySectionTitle", "Music"},
+                        {"thumb", "/library/metadata/" + key + "/thumb/" + QString::number(UPDATED_AT)},
+                        {"updatedAt", UPDATED_AT + index}});
+}
+
+QJsonObject MockLibrary::album(int index) const {
+    QString key = QString::number(ALBUM_BASE + index);
+    QString parent = QString::number(ARTIST_BASE + index / 5);
+    int     tracks = qMin(10, m_tracks.size() - index * 10);
+    return QJsonObject({{"ratingKey", key},
+                        {"key", "/library/metadata/" + key + "/children"},
+                        {"parentRatingKey", parent},
+                        {"type", "album"},
+                        {"title", m_albums[index]},
+                        {"parentTitle", m_artists[index / 5]},
+                        {"librarySectionTitle", "Music"},
+                        {"leafCount", tracks},
+                        {"thumb", "/library/metadata/" + key + "/thumb/" + QString::number(UPDATED_AT)},
+                        {"parentThumb", "/library/metadata/" + parent + "/thumb/" + QString::number(UPDATED_AT)},
+                        {"updatedAt", UPDATED_AT + index}});
+}
+
+QJsonObject MockLibrary::track(int index) const {
+    QString key = QString::number(TRACK_BASE + index);
+    QString parent = QString::number(ALBUM_BASE + index / 10);
+    QString grandparent = QString::number(ARTIST_BASE + index / 50);
+    return QJsonObject({{"ratingKey", key},
+                        {"key", "/library/metadata/" + key},
+                        {"parentRatingKey", parent},
+                        {"grandparentRatingKey", grandparent},
+                        {"type", "track"},
+                        {"title", m_tracks[index]},
+                        {"parentTitle", m_albums[index / 10]},
+                        {"grandparentTitle", m_artists[index / 50]},
+                        {"librarySectionTitle", "Music"},
+                        {"index", index % 10 + 1},
+                        {"duration", m_durations[index]},
+                        {"thumb", "/library/metadata/" + parent + "/thumb/" + QString::number(UPDATED_AT)},
+                        {"parentThumb", "/library/metadata/" + parent + "/thumb/" + QString::number(UPDATED_AT)},
+                        {"grandparentThumb",
+                         "/library/metadata/" + grandparent + "/thumb/" + QString::number(UPDATED_AT)},
+                        {"updatedAt", UPDATED_AT + index}});
+}
+
+QJsonObject MockLibrary::playlist() const {
+    QString key = QString::number(PLAYLIST_KEY);
+    return QJsonObject({{"ratingKey", key},
+                        {"key", "/playlists/" + key + "/items"},
+                        {"type", "playlist"},
+                        {"title", "Everything"},
+                        {"playlistType", "audio"},
+                        {"smart", false},
+                        {"leafCount", m_tracks.size()},
+                        {"composite", "/playlists/" + key + "/composite/" + QString::number(UPDATED_AT)},
+                        {"updatedAt", UPDATED_AT}});
+}
+
+QVector<QJsonObject> MockLibrary::all(int type) const {
+    QVector<QJsonObject> items;
+    if (type == ARTIST) {
+        for (int i = 0; i < m_artists.size(); i++) items.append(artist(i));
+    } else if (type == ALBUM) {
+        for (int i = 0; i < m_albums.size(); i++) items.append(album(i));
+    } else if (type == TRACK) {
+        for (int i = 0; i < m_tracks.size(); i++) items.append(track(i));
+    } else if (type == PLAYLIST) {
+        items.append(playlist());
+    }
+    return items;
+}
+
+int MockLibrary::index(const QString& ratingKey, int base, int count) const {
+    bool ok = false;
+    int  index = ratingKey.toInt(&ok) - base;
+    return ok && index >= 0 && index < count ? index : -1;
+}
+
+QJsonObject MockLibrary::item(const QString& ratingKey) const {
+    int i;
+    if ((i = index(ratingKey, TRACK_BASE, m_tracks.size())) >= 0) return track(i);
+    if ((i = index(ratingKey, ALBUM_BASE, m_albums.size())) >= 0) return album(i);
+    if ((i = index(ratingKey, ARTIST_BASE, m_artists.size())) >= 0) return artist(i);
+    if (ratingKey == QString::number(PLAYLIST_KEY)) return playlist();
+    return QJsonObject();
+}
+
+QVector<QJsonObject> MockLibrary::children(const QString& ratingKey) const {
+    QVector<QJsonObject> items;
+    int                  i;
+    if ((i = index(ratingKey, ALBUM_BASE, m_albums.size())) >= 0) {
+        for (int j = i * 10; j < qMin(i * 10 + 10, m_tracks.size()); j++) items.append(track(j));
+    } else if ((i = index(ratingKey, ARTIST_BASE, m_artists.size())) >= 0) {
+        for (int j = i * 5; j < qMin(i * 5 + 5, m_albums.size()); j++) items.append(album(j));
+    }
+    return items;
+}
+
+QVector<int> MockLibrary::tracksOf(const QString& ratingKey) const {
+    QVector<int> tracks;
+    int          i;
+    if ((i = index(ratingKey, TRACK_BASE, m_tracks.size())) >= 0) {
+        tracks.append(i);
+    } else if ((i = index(ratingKey, ALBUM_BASE, m_albums.size())) >= 0) {
+        for (int j = i * 10; j < qMin(i * 10 + 10, m_tracks.size()); j++) tracks.append(j);
+    } else if ((i = index(ratingKey, ARTIST_BASE, m_artists.size())) >= 0) {
+        for (int j = i * 50; j < qMin(i * 50 + 50, m_tracks.size()); j++) tracks.append(j);
+    } else if (ratingKey == QString::number(PLAYLIST_KEY)) {
+        for (int j = 0; j < m_tracks.size(); j++) tracks.append(j);
+    }
+    return tracks;
+}
+
+QVector<QJsonObject> MockLibrary::search(const QString& query, const QList<int>& types, int limitPerType) const {
+    QVector<QJsonObject> items;
+    if (types.contains(ARTIST)) {
+        for (int i = 0, found = 0; i < m_artists.size() && found < limitPerType; i++) {
+            if (m_artists[i].contains(query, Qt::CaseInsensitive)) {
+                items.append(artist(i));
+                found++;
+            }
+        }
+    }
+    if (types.contains(ALBUM)) {
+        for (int i = 0, found = 0; i < m_albums.size() && found < limitPerType; i++) {
+            if (m_albums[i].contains(query, Qt::CaseInsensitive)) {
+                items.append(album(i));
+                found++;
+            }
+        }
+    }
+    if (types.contains(TRACK)) {
+        for (int i = 0, found = 0; i < m_tracks.size() && found < limitPerType; i++) {
+            if (m_tracks[i].contains(query, Qt::CaseInsensitive)) {
+                items.append(track(i));
+                found++;
+            }
+        }
+    }
+    if (types.contains(PLAYLIST) && QString("Everything").contains(query, Qt::CaseInsensitive)) {
+        items.append(playlist());
+    }
+    return items;
+}
+
+QVector<QJsonObject> MockLibrary::recentlyAdded() const {
+    QVector<QJsonObject> items;
+    for (int i = m_albums.size() - 1; i >= 0 && items.size() < 25; i--) {
+        items.append(album(i));
+    }
+    return items;
+}
+
+MockLibrary::Queue* MockLibrary::createQueue(const QVector<int>& tracks, bool shuffle) {
+    Queue queue;
+    queue.id = QString::number(m_nextQueue++);
+    queue.tracks = tracks;
+    if (shuffle) {
+        QRandomGenerator random(m_seed + static_cast<quint32>(m_nextQueue));
+        for (int i = queue.tracks.size() - 1; i > 0; i--) {
+            std::swap(queue.tracks[i], queue.tracks[random.bounded(i + 1)]);
+        }
+    }
+    return &m_queues.insert(queue.id, queue).value();
+}
+
+MockLibrary::Queue* MockLibrary::queue(const QString& id) {
+    QHash<QString, Queue>::iterator iter = m_queues.find(id);
+    return iter == m_queues.end() ? nullptr : &iter.value();
+}
+
+qint64 MockLibrary::queueItemID(const Queue& queue, int position) const {
+    return queue.id.toLongLong() * 1000000 + position + 1;
+}
+
+QJsonObject MockLibrary::queueContainer(const Queue& queue, int window) const {
+    int start = qMax(0, queue.selected - window / 2);
+    int end = qMin(queue.tracks.size(), start + window);
+
+    QJsonArray metadata;
+    for (int i = start; i < end; i++) {
+        QJsonObject item = track(queue.tracks[i]);
+        item.insert("playQueueItemID", queueItemID(queue, i));
+        metadata.append(item);
+    }
+    QJsonObject container({{"playQueueID", queue.id.toLongLong()},
+                           {"playQueueVersion", queue.version},
+                           {"playQueueSelectedItemID", queueItemID(queue, queue.selected)},
+                           {"playQueueSelectedItemOffset", queue.selected},
+                           {"playQueueTotalCount", queue.tracks.size()},
+                           {"playQueueShuffled", false},
+                           {"size", end - start}});
+    if (end > start) container.insert("Metadata", metadata);
+    return container;
+}
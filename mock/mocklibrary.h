@@ -0,0 +1,87 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QJsonObject>
+#include <QStringList>
+#include <QVector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMOCK LIBRARY
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Generated music library of the stand-in server, and the play queues made from it. Ten tracks to an album, five
+// albums to an artist, and one playlist holding every track. Titles and durations come from the seed, so the same
+// seed gives the same library. Items are written the way the server writes them in its JSON replies.
+class MockLibrary {
+ public:
+    enum Type { ARTIST = 8, ALBUM = 9, TRACK = 10, PLAYLIST = 15 };  // the server's type numbers
+
+    struct Queue {
+        QString      id;
+        qint64       version = 1;
+        QVector<int> tracks;
+        int          selected = 0;  // position in tracks
+    };
+
+    MockLibrary(int tracks, quint32 seed);
+
+    QString machineIdentifier() const { return "plexmock-server"; }
+    int     trackCount() const { return m_tracks.size(); }
+
+    QJsonObject track(int index) const;
+    QJsonObject playlist() const;
+    qint64      duration(int track) const { return m_durations[track]; }
+
+    // items of a type, i.e. for /library/sections/{id}/all
+    QVector<QJsonObject> all(int type) const;
+    // the item behind /library/metadata/{ratingKey}, empty if there is none
+    QJsonObject item(const QString& ratingKey) const;
+    // albums of an artist, tracks of an album
+    QVector<QJsonObject> children(const QString& ratingKey) const;
+    // tracks of a track, an album, an artist or the playlist
+    QVector<int>         tracksOf(const QString& ratingKey) const;
+    QVector<QJsonObject> search(const QString& query, const QList<int>& types, int limitPerType) const;
+    QVector<QJsonObject> recentlyAdded() const;
+
+    Queue*      createQueue(const QVector<int>& tracks, bool shuffle);
+    Queue*      queue(const QString& id);
+    qint64      queueItemID(const Queue& queue, int position) const;
+    QJsonObject queueContainer(const Queue& queue, int window) const;
+
+ private:
+    QJsonObject artist(int index) const;
+    QJsonObject album(int index) const;
+    int         index(const QString& ratingKey, int base, int count) const;
+
+    enum { ARTIST_BASE = 1000, ALBUM_BASE = 100000, TRACK_BASE = 1000000, PLAYLIST_KEY = 900, UPDATED_AT = 1580000000 };
+
+    QStringList            m_artists;
+    QStringList            m_albums;
+    QStringList            m_tracks;
+    QVector<qint64>        m_durations;
+    QHash<QString, Queue>  m_queues;
+    int                    m_nextQueue = 1000;
+    quint32                m_seed;
+};
@@ -0,0 +1,161 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "mockplexplayer.h"
+
+MockPlexPlayer::MockPlexPlayer(MockLibrary* library, QObject* parent) : MockHttpServer(parent), m_library(library) {}
+
+qint64 MockPlexPlayer::position() const { return m_offset + (m_state == "playing" ? m_clock.elapsed() : 0); }
+
+void MockPlexPlayer::advance() {
+    MockLibrary::Queue* current = queue();
+    while (m_state == "playing" && current && position() >= m_library->duration(current->tracks[current->selected])) {
+        qint64 over = position() - m_library->duration(current->tracks[current->selected]);
+        if (current->selected + 1 >= current->tracks.size()) {
+            m_state = "stopped";
+            m_offset = 0;
+            return;
+        }
+        select(current->selected + 1, over);
+    }
+}
+
+void MockPlexPlayer::select(int position, qint64 offset) {
+    MockLibrary::Queue* current = queue();
+    if (!current) {
+        return;
+    }
+    current->selected = qBound(0, position, current->tracks.size() - 1);
+    m_offset = offset;
+    m_clock.start();
+}
+
+QJsonObject MockPlexPlayer::session() {
+    advance();
+    MockLibrary::Queue* current = queue();
+    if (m_state == "stopped" || !current) {
+        return QJsonObject();
+    }
+    QJsonObject session = m_library->track(current->tracks[current->selected]);
+    session.insert("viewOffset", position());
+    session.insert("sessionKey", "1");
+    session.insert("playQueueItemID", m_library->queueItemID(*current, current->selected));
+    session.insert("User", QJsonObject({{"id", "1"}, {"title", "mock"}, {"thumb", ""}}));
+    session.insert("Player", QJsonObject({{"address", "127.0.0.1"},
+                                          {"machineIdentifier", machineIdentifier()},
+                                          {"platform", "Linux"},
+                                          {"product", "Plex Mock Player"},
+                                          {"title", "Mock Player"},
+                                          {"state", m_state},
+                                          {"local", true}}));
+    session.insert("Session", QJsonObject({{"id", "plexmock-session-1"}, {"location", "lan"}}));
+    return session;
+}
+
+QByteArray MockPlexPlayer::timeline() {
+    advance();
+    MockLibrary::Queue* current = queue();
+    QString             music = "<Timeline type=\"music\" state=\"stopped\" time=\"0\" />";
+    if (current && m_state != "stopped") {
+        int track = current->tracks[current->selected];
+        music = QString("<Timeline type=\"music\" state=\"%1\" time=\"%2\" duration=\"%3\" ratingKey=\"%4\" "
+                        "key=\"/library/metadata/%4\" playQueueID=\"%5\" playQueueVersion=\"%6\" "
+                        "playQueueItemID=\"%7\" volume=\"%8\" machineIdentifier=\"%9\" controllable=\"playPause,stop,"
+                        "volume,seekTo,skipPrevious,skipNext\" />")
+                    .arg(m_state)
+                    .arg(position())
+                    .arg(m_library->duration(track))
+                    .arg(m_library->track(track).value("ratingKey").toString())
+                    .arg(current->id)
+                    .arg(current->version)
+                    .arg(m_library->queueItemID(*current, current->selected))
+                    .arg(m_volume)
+                    .arg(m_library->machineIdentifier());
+    }
+    return "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<MediaContainer commandID=\"" +
+           QByteArray::number(m_commandId) + "\" location=\"fullScreenMusic\">" + music.toUtf8() +
+           "<Timeline type=\"video\" state=\"stopped\" time=\"0\" />"
+           "<Timeline type=\"photo\" state=\"stopped\" time=\"0\" /></MediaContainer>";
+}
+
+MockHttpServer::Reply MockPlexPlayer::handle(const Request& request) {
+    QString path = request.url.path();
+    if (request.query.hasQueryItem("commandId")) m_commandId = request.query.queryItemValue("commandId").toInt();
+    advance();
+
+    if (path == "/player/timeline/poll") {
+        return xml(timeline());
+    } else if (path == "/player/timeline/subscribe" || path == "/player/timeline/unsubscribe") {
+        return status(200);
+    } else if (path == "/resources") {
+        return xml("<MediaContainer><Player title=\"Mock Player\" machineIdentifier=\"" +
+                   machineIdentifier().toUtf8() + "\" product=\"Plex Mock Player\" platform=\"Linux\" "
+                   "protocolCapabilities=\"timeline,playback,playqueues\" /></MediaContainer>");
+    } else if (!path.startsWith("/player/playback/")) {
+        return status(404);
+    }
+
+    QString command = path.mid(QString("/player/playback/").size());
+    if (command == "playMedia") {
+        // a queue made by the server, or one of the item alone
+        QString key = request.query.queryItemValue("key").section('/', -1);
+        QString container = request.query.queryItemValue("containerKey").section('?', 0, 0);
+        MockLibrary::Queue* target =
+            container.startsWith("/playQueues/") ? m_library->queue(container.section('/', -1)) : nullptr;
+        if (!target) target = m_library->createQueue(m_library->tracksOf(key), false);
+        if (target->tracks.isEmpty()) {
+            return status(400);
+        }
+        m_queue = target->id;
+        int position = qMax(0, target->tracks.indexOf(m_library->tracksOf(key).value(0, -1)));
+        m_state = "playing";
+        select(position, request.query.queryItemValue("offset").toLongLong());
+    } else if (command == "play") {
+        if (queue() && m_state != "playing") {
+            m_offset = m_state == "stopped" ? 0 : m_offset;
+            m_state = "playing";
+            m_clock.start();
+        }
+    } else if (command == "pause") {
+        if (m_state == "playing") {
+            m_offset = position();
+            m_state = "paused";
+        }
+    } else if (command == "stop") {
+        m_state = "stopped";
+        m_offset = 0;
+    } else if (command == "skipNext" || command == "skipPrevious") {
+        if (queue() && m_state != "stopped") select(queue()->selected + (command == "skipNext" ? 1 : -1), 0);
+    } else if (command == "seekTo") {
+        if (queue() && m_state != "stopped") {
+            m_offset = request.query.queryItemValue("offset").toLongLong();
+            m_clock.start();
+        }
+    } else if (command == "setParameters") {
+        if (request.query.hasQueryItem("volume")) {
+            m_volume = qBound(0, request.query.queryItemValue("volume").toInt(), 100);
+        }
+    } else if (command != "refreshPlayQueue") {  // the queue is read from the server at every use anyway
+        return status(404);
+    }
+    return status(200);
+}
@@ -0,0 +1,66 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+
+#include "mockhttpserver.h"
+#include "mocklibrary.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMOCK PLAYER
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Stand-in for a player's control port: /player/playback/* commands and /player/timeline/poll. Plays the server's
+// play queues in real time and moves on to the next track at the end of one. Poll requests are answered straight away
+// rather than held until something changes, and timeline subscriptions are accepted but never pushed, so the plugin
+// polls it like a player whose pushes do not get through.
+class MockPlexPlayer : public MockHttpServer {
+    Q_OBJECT
+
+ public:
+    explicit MockPlexPlayer(MockLibrary* library, QObject* parent = nullptr);
+
+    QString machineIdentifier() const { return "plexmock-player"; }
+
+    // the player's entry of /status/sessions, empty while nothing plays
+    QJsonObject session();
+
+ protected:
+    Reply handle(const Request& request) override;
+
+ private:
+    MockLibrary::Queue* queue() { return m_library->queue(m_queue); }
+    qint64              position() const;
+    void                advance();  // on to the next track once the current one is over, stopped after the last
+    void                select(int position, qint64 offset);
+    QByteArray          timeline();
+
+    MockLibrary*  m_library;
+    QString       m_queue;
+    QString       m_state = "stopped";
+    qint64        m_offset = 0;  // ms into the track when m_clock was started
+    QElapsedTimer m_clock;       // running while playing
+    int           m_volume = 100;
+    int           m_commandId = 0;
+};
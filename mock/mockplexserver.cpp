@@ -0,0 +1,234 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "mockplexserver.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+
+// 1x1 image for every artwork request
+static const char ARTWORK[] =
+    "iVBORw0KGgoAAAANSUhEUgAAAAEAAAABCAYAAAAfFcSJAAAADUlEQVR42mNkYPhfDwAChwGA60e6kgAAAABJRU5ErkJggg==";
+
+static const char* const PLATFORMS[] = {"Android", "iOS", "Windows", "macOS", "Chromecast", "Roku", "tvOS"};
+
+MockPlexServer::MockPlexServer(MockLibrary* library, MockPlexPlayer* player, int sessions, QObject* parent)
+    : MockHttpServer(parent), m_library(library), m_player(player), m_sessions(sessions) {
+    m_uptime.start();
+}
+
+MockHttpServer::Reply MockPlexServer::handle(const Request& request) {
+    QString     path = request.url.path();
+    QStringList segments = path.split('/', QString::SkipEmptyParts);
+
+    if (path == "/mock/stats") {
+        Reply reply;
+        reply.body = QJsonDocument(QJsonObject({{"server", stats()}, {"player", m_player->stats()}}))
+                         .toJson(QJsonDocument::Compact);
+        return reply;
+    } else if (path == "/identity") {
+        return json(QJsonObject({{"size", 0},
+                                 {"claimed", true},
+                                 {"machineIdentifier", m_library->machineIdentifier()},
+                                 {"version", "1.20.0.0-mock"}}));
+    } else if (path == "/status/sessions") {
+        QJsonArray  sessions;
+        QJsonObject own = m_player->session();
+        if (!own.isEmpty()) sessions.append(own);
+        for (int i = 0; i < m_sessions; i++) {
+            sessions.append(otherSession(i));
+        }
+        QJsonObject container({{"size", sessions.size()}});
+        if (!sessions.isEmpty()) container.insert("Metadata", sessions);
+        return json(container);
+    } else if (path == "/clients") {
+        QJsonObject player({{"name", "Mock Player"},
+                            {"host", "127.0.0.1"},
+                            {"address", "127.0.0.1"},
+                            {"port", m_player->port()},
+                            {"machineIdentifier", m_player->machineIdentifier()},
+                            {"version", "1.0.0"},
+                            {"protocol", "plex"},
+                            {"product", "Plex Mock Player"},
+                            {"platform", "Linux"},
+                            {"deviceClass", "pc"},
+                            {"protocolCapabilities", "timeline,playback,playqueues"}});
+        return json(QJsonObject({{"size", 1}, {"Server", QJsonArray({player})}}));
+    } else if (path == "/search") {
+        QList<int>        types;
+        const QStringList typeList = request.query.queryItemValue("type").split(',', QString::SkipEmptyParts);
+        for (int i = 0; i < typeList.size(); i++) {
+            types.append(typeList[i].toInt());
+        }
+        QJsonObject container;
+        page(m_library->search(request.query.queryItemValue("query", QUrl::FullyDecoded), types, 100), request.query,
+             &container);
+        return json(container);
+    } else if (path == "/library/sections") {
+        QJsonObject music({{"key", "3"}, {"type", "artist"}, {"title", "Music"}, {"updatedAt", 1580000000}});
+        return json(QJsonObject({{"size", 1}, {"Directory", QJsonArray({music})}}));
+    } else if (segments.size() == 4 && segments[0] == "library" && segments[1] == "sections") {
+        if (segments[2] != "3") {
+            return status(404);
+        }
+        QVector<QJsonObject> items;
+        if (segments[3] == "all") {
+            // updatedAt>=since, as the library index asks for deltas
+            qint64 since = 0;
+            const QList<QPair<QString, QString>> query = request.query.queryItems(QUrl::FullyDecoded);
+            for (int i = 0; i < query.size(); i++) {
+                if (query[i].first.startsWith("updatedAt")) since = query[i].second.toLongLong();
+            }
+            const QVector<QJsonObject> all = m_library->all(request.query.queryItemValue("type").toInt());
+            for (int i = 0; i < all.size(); i++) {
+                if (all[i].value("updatedAt").toVariant().toLongLong() >= since) items.append(all[i]);
+            }
+        } else if (segments[3] == "recentlyAdded") {
+            items = m_library->recentlyAdded();
+        } else {
+            return status(404);
+        }
+        QJsonObject container({{"title1", "Music"}, {"librarySectionID", 3}});
+        page(items, request.query, &container);
+        return json(container);
+    } else if (segments.size() >= 3 && segments[0] == "library" && segments[1] == "metadata") {
+        return metadata(request, segments);
+    } else if (path == "/playlists") {
+        QJsonObject container;
+        page(m_library->all(MockLibrary::PLAYLIST), request.query, &container);
+        return json(container);
+    } else if (segments.size() == 3 && segments[0] == "playlists" && segments[2] == "items") {
+        QJsonObject playlist = m_library->playlist();
+        if (segments[1] != playlist.value("ratingKey").toString()) {
+            return status(404);
+        }
+        const QVector<int>   tracks = m_library->tracksOf(segments[1]);
+        QVector<QJsonObject> items;
+        for (int i = 0; i < tracks.size(); i++) {
+            QJsonObject item = m_library->track(tracks[i]);
+            item.insert("playlistItemID", 700000 + i);
+            items.append(item);
+        }
+        QJsonObject container({{"ratingKey", playlist.value("ratingKey")},
+                               {"title", playlist.value("title")},
+                               {"playlistType", playlist.value("playlistType")},
+                               {"leafCount", playlist.value("leafCount")},
+                               {"composite", playlist.value("composite")}});
+        page(items, request.query, &container);
+        return json(container);
+    } else if (segments.value(0) == "playQueues") {
+        return playQueues(request, segments);
+    } else if (path.startsWith("/photo/:/transcode")) {
+        Reply reply;
+        reply.contentType = "image/png";
+        reply.body = QByteArray::fromBase64(ARTWORK);
+        return reply;
+    }
+    return status(404);
+}
+
+MockHttpServer::Reply MockPlexServer::metadata(const Request& request, const QStringList& segments) {
+    QJsonObject item = m_library->item(segments[2]);
+    if (item.isEmpty()) {
+        return status(404);
+    }
+    if (segments.size() == 3) {
+        return json(QJsonObject({{"size", 1}, {"Metadata", QJsonArray({item})}}));
+    }
+
+    QVector<QJsonObject> items;
+    if (segments[3] == "children") {
+        items = m_library->children(segments[2]);
+    } else if (segments[3] == "allLeaves") {
+        const QVector<int> tracks = m_library->tracksOf(segments[2]);
+        for (int i = 0; i < tracks.size(); i++) {
+            items.append(m_library->track(tracks[i]));
+        }
+    } else {
+        return status(404);
+    }
+    QJsonObject container({{"key", segments[2]},
+                           {"title1", item.value("parentTitle")},
+                           {"title2", item.value("title")},
+                           {"parentTitle", item.value("title")},
+                           {"grandparentTitle", item.value("parentTitle")},
+                           {"thumb", item.value("thumb")},
+                           {"grandparentThumb", item.value("parentThumb")},
+                           {"leafCount", item.value("leafCount")}});
+    page(items, request.query, &container);
+    return json(container);
+}
+
+MockHttpServer::Reply MockPlexServer::playQueues(const Request& request, const QStringList& segments) {
+    int window = request.query.hasQueryItem("window") ? request.query.queryItemValue("window").toInt() : 200;
+    // uri=server://{id}/com.plexapp.plugins.library/library/metadata/{key}
+    QString key = request.query.queryItemValue("uri", QUrl::FullyDecoded).section('/', -1);
+
+    if (segments.size() == 1 && request.method == "POST") {
+        QVector<int> tracks = m_library->tracksOf(request.query.hasQueryItem("playlistID")
+                                                      ? request.query.queryItemValue("playlistID") : key);
+        if (tracks.isEmpty()) {
+            return status(400);
+        }
+        MockLibrary::Queue* queue = m_library->createQueue(tracks, request.query.queryItemValue("shuffle") == "1");
+        return json(m_library->queueContainer(*queue, window));
+    }
+
+    MockLibrary::Queue* queue = segments.size() == 2 ? m_library->queue(segments[1]) : nullptr;
+    if (!queue) {
+        return status(404);
+    }
+    if (request.method == "PUT") {
+        QVector<int> tracks = m_library->tracksOf(key);
+        if (tracks.isEmpty()) {
+            return status(400);
+        }
+        queue->tracks += tracks;
+        queue->version++;
+    } else if (request.method != "GET") {
+        return status(400);
+    }
+    return json(m_library->queueContainer(*queue, window));
+}
+
+QJsonObject MockPlexServer::otherSession(int index) const {
+    // a different track for each, moving on in real time
+    int         track = (index * 37 + 11) % m_library->trackCount();
+    qint64      duration = m_library->duration(track);
+    QString     platform = PLATFORMS[index % static_cast<int>(sizeof(PLATFORMS) / sizeof(PLATFORMS[0]))];
+    QJsonObject session = m_library->track(track);
+    session.insert("viewOffset", (m_uptime.elapsed() + index * 13000) % duration);
+    session.insert("sessionKey", QString::number(index + 2));
+    session.insert("User", QJsonObject({{"id", QString::number(index + 2)},
+                                        {"title", "listener" + QString::number(index + 2)},
+                                        {"thumb", ""}}));
+    session.insert("Player", QJsonObject({{"address", "192.0.2." + QString::number(index % 250 + 1)},
+                                          {"machineIdentifier", "plexmock-other-" + QString::number(index + 1)},
+                                          {"platform", platform},
+                                          {"product", "Plex for " + platform},
+                                          {"title", "Other Player " + QString::number(index + 1)},
+                                          {"state", "playing"},
+                                          {"local", true}}));
+    session.insert("Session", QJsonObject({{"id", "plexmock-session-" + QString::number(index + 2)},
+                                           {"location", "lan"}}));
+    return session;
+}
@@ -0,0 +1,58 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+
+#include "mockhttpserver.h"
+#include "mocklibrary.h"
+#include "mockplexplayer.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMOCK SERVER
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Stand-in for a Plex Media Server with one music section: identity, sessions, clients, search, library browsing,
+// playlists and play queues, in the JSON the plugin asks for. The mock player's session is listed while it plays,
+// next to the given number of sessions of other players that nobody controls. There is no notification websocket:
+// its endpoint answers 404, so notification mode falls back to downloading the sessions.
+// GET /mock/stats returns the request counts of the server and the player for the load driver.
+class MockPlexServer : public MockHttpServer {
+    Q_OBJECT
+
+ public:
+    MockPlexServer(MockLibrary* library, MockPlexPlayer* player, int sessions, QObject* parent = nullptr);
+
+ protected:
+    Reply handle(const Request& request) override;
+
+ private:
+    Reply       metadata(const Request& request, const QStringList& segments);
+    Reply       playQueues(const Request& request, const QStringList& segments);
+    QJsonObject otherSession(int index) const;
+
+    MockLibrary*    m_library;
+    MockPlexPlayer* m_player;
+    int             m_sessions;
+    QElapsedTimer   m_uptime;
+};
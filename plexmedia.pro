@@ -1,7 +1,7 @@
 TEMPLATE  = lib
 CONFIG   += plugin
 QT       += core quick network
-QT       += xml
+QT       += websockets
 
 # Plugin VERSION
 GIT_HASH = "$$system(git log -1 --format="%H")"
@@ -58,8 +58,49 @@ unix {
 QMAKE_SUBSTITUTES += plexmedia.json.in version.txt.in
 # output path must be included for the output file from QMAKE_SUBSTITUTES
 INCLUDEPATH += $$OUT_PWD
-HEADERS  += src/plexmedia.h
-SOURCES  += src/plexmedia.cpp
+HEADERS  += src/plexmedia.h \
+    src/plexartwork.h \
+    src/plexcommandqueue.h \
+    src/plexdiscovery.h \
+    src/plexentitystate.h \
+    src/plexguidispatcher.h \
+    src/plexhttpclient.h \
+    src/plexjsondecoder.h \
+    src/plexlibraryindex.h \
+    src/plexmetadatacache.h \
+    src/plexmetrics.h \
+    src/plexnotificationclient.h \
+    src/plexpollscheduler.h \
+    src/plexprogressclock.h \
+    src/plexqueuecache.h \
+    src/plexrequest.h \
+    src/plexsessiontable.h \
+    src/plexstartupstate.h \
+    src/plextimelinedecoder.h \
+    src/plextimelinelistener.h \
+    src/plextimelinesubscription.h \
+    src/plextypes.h
+SOURCES  += src/plexmedia.cpp \
+    src/plexartwork.cpp \
+    src/plexcommandqueue.cpp \
+    src/plexdiscovery.cpp \
+    src/plexentitystate.cpp \
+    src/plexguidispatcher.cpp \
+    src/plexhttpclient.cpp \
+    src/plexjsondecoder.cpp \
+    src/plexlibraryindex.cpp \
+    src/plexmetadatacache.cpp \
+    src/plexmetrics.cpp \
+    src/plexnotificationclient.cpp \
+    src/plexpollscheduler.cpp \
+    src/plexprogressclock.cpp \
+    src/plexqueuecache.cpp \
+    src/plexrequest.cpp \
+    src/plexsessiontable.cpp \
+    src/plexstartupstate.cpp \
+    src/plextimelinedecoder.cpp \
+    src/plextimelinelistener.cpp \
+    src/plextimelinesubscription.cpp
 TARGET    = plexmedia
 
 # Configure destination path. DESTDIR is set in qmake-destination-path.pri
@@ -0,0 +1,268 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "plexartwork.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QUrl>
+
+static const quint32 INDEX_MAGIC = 0x504c5841;  // "PLXA"
+static const quint32 INDEX_VERSION = 1;
+
+PlexArtwork::PlexArtwork(PlexHttpClient* http, const QString& cacheDir, qint64 maxBytes, QObject* parent)
+    : QObject(parent), m_http(http), m_cacheDir(cacheDir), m_maxBytes(maxBytes), m_saveTimer(new QTimer(this)) {
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(SAVE_DELAY);
+    QObject::connect(m_saveTimer, &QTimer::timeout, this, &PlexArtwork::save);
+}
+
+PlexArtwork::~PlexArtwork() {
+    if (m_dirty) {
+        save();
+    }
+}
+
+void PlexArtwork::setServer(const QString& serverURL, const QString& token) {
+    m_serverURL = serverURL;
+    m_token = token;
+}
+
+QString PlexArtwork::url(const QString& thumb, int size) {
+    if (thumb.isEmpty()) {
+        return QString();
+    }
+
+    // the same image is asked for again on every poll and list rebuild. Only a change of what the UI gets counts.
+    QString                         k = key(thumb, size);
+    QHash<QString, Entry>::iterator iter = m_index.find(k);
+    QHash<QString, bool>::iterator  served = m_served.find(k);
+    if (iter != m_index.end() && QFile::exists(fileName(iter.value().hash))) {
+        if (served == m_served.end() || !served.value()) {
+            m_hits++;
+            m_bytesFromCache += iter.value().bytes;
+            m_served.insert(k, true);
+        }
+        iter.value().lastUsed = ++m_clock;
+        return QUrl::fromLocalFile(fileName(iter.value().hash)).toString();
+    }
+
+    if (served == m_served.end()) {
+        m_misses++;
+        m_served.insert(k, false);
+    }
+    return transcodeUrl(thumb, size);
+}
+
+void PlexArtwork::prefetch(const QString& thumb, int size) {
+    if (!thumb.isEmpty() && !m_index.contains(key(thumb, size))) {
+        fetch(thumb, size);
+    }
+}
+
+QString PlexArtwork::transcodeUrl(const QString& thumb, int size) const {
+    QString server = m_serverURL;
+    QString path = thumb;
+    if (thumb.startsWith("http")) {
+        QUrl absolute(thumb);
+        server = absolute.adjusted(QUrl::RemovePath | QUrl::RemoveQuery).toString();
+        path = absolute.path();
+    }
+    return server + "/photo/:/transcode?width=" + QString::number(size) + "&height=" + QString::number(size) +
+           "&minSize=1&upscale=1&url=" + QString::fromLatin1(QUrl::toPercentEncoding(path));
+}
+
+QString PlexArtwork::fileName(const QByteArray& hash) const {
+    return m_cacheDir + "/" + QString::fromLatin1(hash) + ".jpg";
+}
+
+void PlexArtwork::fetch(const QString& thumb, int size) {
+    QString k = key(thumb, size);
+    if (m_serverURL.isEmpty() || m_pending.contains(k)) {
+        return;
+    }
+    m_pending.insert(k);
+    m_queue.enqueue(qMakePair(thumb, size));
+    fetchNext();
+}
+
+void PlexArtwork::fetchNext() {
+    // artwork is never urgent, keep most of the connections to the server free for status and browse requests
+    while (m_inFlight < MAX_IN_FLIGHT && !m_queue.isEmpty()) {
+        Request next = m_queue.dequeue();
+        QString k = key(next.first, next.second);
+
+        QNetworkRequest request(QUrl(transcodeUrl(next.first, next.second)));
+        if (!m_token.isEmpty()) {
+            request.setRawHeader("X-Plex-Token", m_token.toLocal8Bit());
+        }
+        m_inFlight++;
+        m_http->get(request)->setTimeout(30000)->onReply(this, [=](int statusCode, const QByteArray& body) {
+            m_inFlight--;
+            m_pending.remove(k);
+            if (statusCode == 200 && !body.isEmpty()) {
+                m_bytesDownloaded += body.size();
+                store(next, body);
+            }
+            fetchNext();
+        });
+    }
+}
+
+void PlexArtwork::store(const Request& request, const QByteArray& body) {
+    QString    k = key(request.first, request.second);
+    QByteArray hash = QCryptographicHash::hash(body, QCryptographicHash::Sha1).toHex();
+
+    if (!m_refs.contains(hash)) {
+        QDir().mkpath(m_cacheDir);
+        QSaveFile file(fileName(hash));
+        if (!file.open(QIODevice::WriteOnly) || file.write(body) != body.size() || !file.commit()) {
+            return;
+        }
+        m_bytes += body.size();
+    }
+
+    QHash<QString, Entry>::iterator old = m_index.find(k);
+    if (old != m_index.end()) {
+        QByteArray oldHash = old.value().hash;
+        m_index.erase(old);
+        release(oldHash);
+    }
+
+    Entry entry;
+    entry.hash = hash;
+    entry.bytes = body.size();
+    entry.lastUsed = ++m_clock;
+    m_index.insert(k, entry);
+    m_refs[hash]++;
+
+    evict();
+    scheduleSave();
+    if (m_index.contains(k)) {  // not evicted straight away
+        emit cached(request.first, request.second);
+    }
+}
+
+void PlexArtwork::release(const QByteArray& hash) {
+    QHash<QByteArray, int>::iterator refs = m_refs.find(hash);
+    if (refs == m_refs.end()) {
+        return;
+    }
+    if (--refs.value() <= 0) {
+        QFile file(fileName(hash));
+        m_bytes -= file.size();
+        file.remove();
+        m_refs.erase(refs);
+    }
+}
+
+void PlexArtwork::evict() {
+    while (m_bytes > m_maxBytes && !m_index.isEmpty()) {
+        QHash<QString, Entry>::iterator oldest = m_index.begin();
+        for (QHash<QString, Entry>::iterator iter = m_index.begin(); iter != m_index.end(); ++iter) {
+            if (iter.value().lastUsed < oldest.value().lastUsed) {
+                oldest = iter;
+            }
+        }
+        QByteArray hash = oldest.value().hash;
+        m_index.erase(oldest);
+        release(hash);
+    }
+}
+
+void PlexArtwork::scheduleSave() {
+    m_dirty = true;
+    if (!m_saveTimer->isActive()) {
+        m_saveTimer->start();
+    }
+}
+
+bool PlexArtwork::load() {
+    QFile file(m_cacheDir + "/index");
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0, version = 0, count = 0;
+    in >> magic >> version >> count;
+    if (magic != INDEX_MAGIC || version != INDEX_VERSION) {
+        return false;
+    }
+
+    m_index.clear();
+    m_refs.clear();
+    m_bytes = 0;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+        QString k;
+        Entry   entry;
+        in >> k >> entry.hash >> entry.bytes >> entry.lastUsed;
+        if (in.status() != QDataStream::Ok || !QFile::exists(fileName(entry.hash))) {
+            continue;  // file was removed behind our back
+        }
+        if (!m_refs.contains(entry.hash)) {
+            m_bytes += entry.bytes;
+        }
+        m_refs[entry.hash]++;
+        m_clock = qMax(m_clock, entry.lastUsed);
+        m_index.insert(k, entry);
+    }
+    m_dirty = false;
+    return true;
+}
+
+bool PlexArtwork::save() {
+    m_saveTimer->stop();
+    QDir().mkpath(m_cacheDir);
+
+    QSaveFile file(m_cacheDir + "/index");
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << INDEX_MAGIC << INDEX_VERSION << static_cast<quint32>(m_index.size());
+    for (QHash<QString, Entry>::const_iterator iter = m_index.constBegin(); iter != m_index.constEnd(); ++iter) {
+        out << iter.key() << iter.value().hash << iter.value().bytes << iter.value().lastUsed;
+    }
+    if (!file.commit()) {
+        return false;
+    }
+    m_dirty = false;
+    return true;
+}
+
+QVariantMap PlexArtwork::stats() const {
+    QVariantMap map;
+    map.insert("hits", m_hits);
+    map.insert("misses", m_misses);
+    map.insert("hit_ratio", m_hits + m_misses > 0 ? static_cast<double>(m_hits) / (m_hits + m_misses) : 0.0);
+    map.insert("bytes_saved", m_bytesFromCache);  // not downloaded again thanks to the cache
+    map.insert("bytes_downloaded", m_bytesDownloaded);
+    map.insert("cached_bytes", m_bytes);
+    map.insert("cached_files", m_refs.size());
+    return map;
+}
@@ -0,0 +1,112 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QPair>
+#include <QQueue>
+#include <QSet>
+#include <QTimer>
+#include <QVariantMap>
+
+#include "plexhttpclient.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMEDIA ARTWORK
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Hands the UI artwork at the size it is shown. Thumb paths are rewritten to the server's /photo/:/transcode endpoint
+// so the server scales the image, and the scaled results are kept in a size-bounded disk cache. Files are named by
+// the hash of their content, so the same cover used by every track of an album is stored once.
+// A cached image is handed out as a local file. The cache is filled by prefetching what is likely to be shown next.
+// URLs handed out never carry the access token, it is only sent as a header with our own downloads.
+class PlexArtwork : public QObject {
+    Q_OBJECT
+
+ public:
+    enum Size { THUMBNAIL = 160, ARTWORK = 480 };  // px, browse rows and the now playing screen of the remote
+
+    PlexArtwork(PlexHttpClient* http, const QString& cacheDir, qint64 maxBytes, QObject* parent = nullptr);
+    ~PlexArtwork() override;
+
+    void setServer(const QString& serverURL, const QString& token);
+
+    // url to hand to the UI for the thumb path of an item: the cached file or the transcode url. Empty without thumb.
+    // A thumb given as a full URL belongs to another server and is transcoded there.
+    // Counted as a hit or a miss the first time it is handed out, and again only once it has been cached since.
+    QString url(const QString& thumb, int size);
+    // download into the cache without handing anything out, i.e. the next items in the play queue
+    void prefetch(const QString& thumb, int size);
+
+    bool load();
+    bool save();
+
+    int         hits() const { return m_hits; }
+    int         misses() const { return m_misses; }
+    QVariantMap stats() const;
+
+ signals:
+    void cached(const QString& thumb, int size);  // url() now hands out the local file
+
+ private:
+    typedef QPair<QString, int> Request;  // thumb and size
+
+    struct Entry {
+        QByteArray hash;  // content hash, also the file name
+        qint64     bytes = 0;
+        qint64     lastUsed = 0;
+    };
+
+    QString key(const QString& thumb, int size) const { return QString::number(size) + thumb; }
+    QString transcodeUrl(const QString& thumb, int size) const;
+    QString fileName(const QByteArray& hash) const;
+    void    fetch(const QString& thumb, int size);
+    void    fetchNext();
+    void    store(const Request& request, const QByteArray& body);
+    void    release(const QByteArray& hash);
+    void    evict();
+    void    scheduleSave();
+
+    PlexHttpClient*        m_http;
+    QString                m_cacheDir;
+    qint64                 m_maxBytes;
+    QString                m_serverURL;
+    QString                m_token;
+    QHash<QString, Entry>  m_index;  // thumb and size -> file
+    QHash<QByteArray, int> m_refs;   // number of index entries per file
+    qint64                 m_bytes = 0;
+    qint64                 m_clock = 0;
+    QQueue<Request>        m_queue;
+    QSet<QString>          m_pending;  // queued or downloading
+    int                    m_inFlight = 0;
+    QTimer*                m_saveTimer;
+    bool                   m_dirty = false;
+    QHash<QString, bool>   m_served;  // keys handed out so far, and whether as the cached file
+
+    int    m_hits = 0;
+    int    m_misses = 0;
+    qint64 m_bytesFromCache = 0;
+    qint64 m_bytesDownloaded = 0;
+
+    enum { MAX_IN_FLIGHT = 2, SAVE_DELAY = 5000 };
+};
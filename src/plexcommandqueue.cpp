@@ -0,0 +1,307 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "plexcommandqueue.h"
+
+#include <algorithm>
+
+PlexCommandQueue::PlexCommandQueue(Sender sender, QObject* parent) : QObject(parent), m_sender(sender) {
+    m_clock.start();
+}
+
+void PlexCommandQueue::push(Kind kind, const QVariant& value) {
+    // merge into the last waiting command if it is of the same kind. Only the last, so the order of presses is kept.
+    if (!m_queue.isEmpty() && m_queue.last().kind == kind) {
+        Command& last = m_queue.last();
+        m_merged++;
+        if (kind != SKIP) {
+            last.value = value;
+        } else if (last.value.toInt() + value.toInt() != 0) {
+            last.value = last.value.toInt() + value.toInt();
+        } else {
+            m_queue.removeLast();  // next and previous cancel out
+            if (!pending(SKIP)) {
+                m_expectations.remove(SKIP);
+            }
+        }
+        return;
+    }
+
+    Command command;
+    command.kind = kind;
+    command.value = value;
+    m_queue.append(command);
+    sendNext();
+}
+
+void PlexCommandQueue::push(const QString& path, const QString& params, Kind kind) {
+    Command command;
+    command.kind = kind;
+    command.path = path;
+    command.params = params;
+    m_queue.append(command);
+    sendNext();
+}
+
+void PlexCommandQueue::sendNext() {
+    if (m_busy || m_queue.isEmpty()) {
+        return;
+    }
+
+    Command command = m_queue.takeFirst();
+    QString path = command.path;
+    QString params = command.params;
+    switch (command.kind) {
+        case STATE:
+            path = command.value.toString() == "playing" ? "/player/playback/play" : "/player/playback/pause";
+            break;
+        case SKIP: {
+            int steps = command.value.toInt();
+            path = steps > 0 ? "/player/playback/skipNext" : "/player/playback/skipPrevious";
+            if (qAbs(steps) > 1) {  // the player moves one item per request, the rest waits at the front
+                Command rest = command;
+                rest.value = steps > 0 ? steps - 1 : steps + 1;
+                m_queue.prepend(rest);
+            }
+            break;
+        }
+        case SEEK:
+            path = "/player/playback/seekTo";
+            params = "?offset=" + QString::number(command.value.toLongLong());
+            break;
+        case VOLUME:
+            path = "/player/playback/setParameters";
+            params = "?volume=" + QString::number(command.value.toInt());
+            break;
+        case MEDIA:
+        case OTHER:
+            break;
+    }
+
+    m_busy = true;
+    m_inFlight = command.kind;
+    Kind         kind = command.kind;
+    Route        route = DIRECT;
+    PlexRequest* request = m_sender(path, params, &route);
+
+    QHash<int, Expectation>::iterator expectation = m_expectations.find(kind);
+    if (expectation != m_expectations.end() && expectation->requestSent < 0) {
+        expectation->requestSent = m_clock.elapsed() - expectation->pressed;
+        expectation->route = route;
+    }
+    QObject::connect(request, &PlexRequest::finished, this, [=]() {
+        QHash<int, Expectation>::iterator waiting = m_expectations.find(kind);
+        if (waiting != m_expectations.end() && waiting->replyReceived < 0 && !request->hasFailed()) {
+            waiting->replyReceived = m_clock.elapsed() - waiting->pressed;
+        }
+        m_busy = false;
+        sent(kind);
+        sendNext();
+    });
+}
+
+void PlexCommandQueue::sent(Kind kind) {
+    // the confirmation timeout only starts once the last command of a kind is through
+    QHash<int, Expectation>::iterator expectation = m_expectations.find(kind);
+    if (expectation != m_expectations.end() && !pending(kind)) {
+        expectation->sent = m_clock.elapsed();
+    }
+}
+
+bool PlexCommandQueue::pending(Kind kind) const {
+    if (m_busy && m_inFlight == kind) {
+        return true;
+    }
+    for (int i = 0; i < m_queue.size(); i++) {
+        if (m_queue[i].kind == kind) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PlexCommandQueue::expect(Kind kind, const QVariant& value, const QString& command) {
+    QHash<int, Expectation>::iterator expectation = m_expectations.find(kind);
+    if (expectation == m_expectations.end()) {
+        Expectation fresh;
+        fresh.value = value;
+        fresh.command = command;
+        fresh.platform = m_platform;
+        fresh.pressed = m_clock.elapsed();
+        m_expectations.insert(kind, fresh);
+        return;
+    }
+
+    // part of a burst: latency counts from its first press, a skip or new media waits for the item it started from to
+    // change. Anything else is traced as the command that set its final target.
+    if (kind != SKIP && kind != MEDIA) {
+        expectation->value = value;
+        expectation->command = command;
+    }
+    expectation->sent = 0;
+}
+
+QVariant PlexCommandQueue::expected(Kind kind, const QVariant& fallback) const {
+    QHash<int, Expectation>::const_iterator expectation = m_expectations.constFind(kind);
+    return expectation != m_expectations.constEnd() ? expectation->value : fallback;
+}
+
+QVariant PlexCommandQueue::reconcile(Kind kind, const QVariant& reported, Observer observer) {
+    QHash<int, Expectation>::iterator expectation = m_expectations.find(kind);
+    if (expectation == m_expectations.end()) {
+        return reported;
+    }
+
+    qint64 now = m_clock.elapsed();
+    if (matches(kind, *expectation, reported)) {
+        trace(*expectation, observer == TIMELINE ? BY_TIMELINE : BY_SESSIONS, now);
+        m_expectations.erase(expectation);
+        return reported;
+    }
+
+    if (expectation->sent == 0 || now - expectation->sent < CONFIRM_TIMEOUT) {
+        // not there yet, keep showing what was asked for
+        return kind == SKIP || kind == MEDIA ? reported : expectation->value;
+    }
+
+    m_rolledBack++;
+    trace(*expectation, FAILED, now);
+    m_expectations.erase(expectation);
+    return reported;
+}
+
+void PlexCommandQueue::fail(Kind kind) {
+    QHash<int, Expectation>::iterator expectation = m_expectations.find(kind);
+    if (expectation == m_expectations.end()) {
+        return;
+    }
+    trace(*expectation, FAILED, m_clock.elapsed());
+    m_expectations.erase(expectation);
+}
+
+bool PlexCommandQueue::matches(Kind kind, const Expectation& expectation, const QVariant& reported) const {
+    switch (kind) {
+        case SKIP:
+            // a burst moves one item per request: the first change only confirms it once the last step is through
+            return !pending(SKIP) && !reported.toString().isEmpty() &&
+                   reported.toString() != expectation.value.toString();
+        case MEDIA: {
+            // "ratingKey/playQueueItemID": another item, or the same one again in a new play queue
+            QStringList after = reported.toString().split('/');
+            QStringList before = expectation.value.toString().split('/');
+            if (pending(MEDIA) || after.first().isEmpty()) {
+                return false;
+            }
+            qint64 item = after.value(1).toLongLong();
+            qint64 itemBefore = before.value(1).toLongLong();
+            return after.first() != before.first() || (item > 0 && itemBefore > 0 && item != itemBefore);
+        }
+        case SEEK:
+            // playback carries on after the seek, allow for the time since the press
+            return qAbs(reported.toLongLong() - expectation.value.toLongLong()) <=
+                   SEEK_TOLERANCE + m_clock.elapsed() - expectation.pressed;
+        default:
+            return reported == expectation.value;
+    }
+}
+
+void PlexCommandQueue::trace(const Expectation& expectation, Outcome outcome, qint64 now) {
+    Waiting waiting;
+    waiting.key = (expectation.command.isEmpty() ? QString("UNKNOWN") : expectation.command) + "/" +
+                  (expectation.platform.isEmpty() ? QString("unknown") : expectation.platform) + "/" +
+                  (expectation.route == DIRECT ? "direct" : "relayed");
+    waiting.pressed = expectation.pressed;
+
+    // a stage that was not seen (i.e. the reply came after the report) counts as reached when it was observed
+    waiting.trace.observed = now - expectation.pressed;
+    waiting.trace.sent = expectation.requestSent >= 0 ? expectation.requestSent : waiting.trace.observed;
+    waiting.trace.reply = expectation.replyReceived >= 0 ? expectation.replyReceived : waiting.trace.observed;
+    waiting.trace.outcome = outcome;
+
+    m_waiting.append(waiting);
+    if (m_waiting.size() == 1) {
+        emit observed();
+    }
+}
+
+void PlexCommandQueue::entityUpdated(qint64 at) {
+    qint64 now = at - m_clock.msecsSinceReference();
+    for (int i = 0; i < m_waiting.size(); i++) {
+        Trace trace = m_waiting[i].trace;
+        trace.entity = qMax(trace.observed, now - m_waiting[i].pressed);
+
+        Traces& traces = m_traces[m_waiting[i].key];
+        traces.count++;
+        traces.counts[trace.outcome]++;
+        traces.recent.append(trace);
+        if (traces.recent.size() > TRACE_SAMPLES) {
+            traces.recent.removeFirst();
+        }
+    }
+    m_waiting.clear();
+}
+
+void PlexCommandQueue::clear() {
+    m_queue.clear();
+    m_expectations.clear();
+}
+
+QVariantMap PlexCommandQueue::stats() const {
+    QVariantMap map;
+    for (QHash<QString, Traces>::const_iterator iter = m_traces.constBegin(); iter != m_traces.constEnd(); ++iter) {
+        QVector<qint64> sent, reply, observed, entity;
+        for (int i = 0; i < iter.value().recent.size(); i++) {
+            sent.append(iter.value().recent[i].sent);
+            reply.append(iter.value().recent[i].reply);
+            observed.append(iter.value().recent[i].observed);
+            entity.append(iter.value().recent[i].entity);
+        }
+        QVariantMap latency;
+        latency.insert("count", iter.value().count);
+        latency.insert("failed", iter.value().counts[FAILED]);
+        latency.insert("by_timeline", iter.value().counts[BY_TIMELINE]);
+        latency.insert("by_sessions", iter.value().counts[BY_SESSIONS]);
+        latency.insert("sent_p50_ms", percentile(sent, 0.5));
+        latency.insert("reply_p50_ms", percentile(reply, 0.5));
+        latency.insert("reply_p95_ms", percentile(reply, 0.95));
+        latency.insert("observed_p50_ms", percentile(observed, 0.5));
+        latency.insert("observed_p95_ms", percentile(observed, 0.95));
+        latency.insert("observed_max_ms", percentile(observed, 1.0));
+        latency.insert("entity_p50_ms", percentile(entity, 0.5));
+        latency.insert("entity_p95_ms", percentile(entity, 0.95));
+        latency.insert("entity_max_ms", percentile(entity, 1.0));
+        map.insert(iter.key(), latency);
+    }
+    map.insert("merged", m_merged);
+    map.insert("rolled_back", m_rolledBack);
+    map.insert("queued", m_queue.size());
+    return map;
+}
+
+qint64 PlexCommandQueue::percentile(QVector<qint64> values, double fraction) {
+    if (values.isEmpty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    int index = qBound(0, static_cast<int>(values.size() * fraction + 0.5) - 1, values.size() - 1);
+    return values[index];
+}
@@ -0,0 +1,150 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QVariantMap>
+#include <QVector>
+
+#include <functional>
+
+#include "plexrequest.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMEDIA COMMAND QUEUE
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Player commands, sent one at a time in the order they were pressed so commandIds reach the player in order.
+// A press that arrives while the same kind of command is still waiting merges into it: volume, seek and play/pause
+// keep the latest target, skips add up (opposite skips cancel out).
+// The caller shows the expected state straight away. The timeline then confirms it, or it is rolled back to what the
+// player reports once the commands have been sent and nothing matching arrived in time.
+// Every command with an expected result is traced from the press: request sent, reply received, the first report
+// showing the result (or the rollback, traced as failed) and the entity showing it. Traces are grouped by the command
+// pressed, the player platform and the control path: straight to the player or relayed by the server.
+class PlexCommandQueue : public QObject {
+    Q_OBJECT
+
+ public:
+    enum Kind { STATE, SKIP, SEEK, VOLUME, MEDIA, OTHER };
+    enum Observer { TIMELINE, SESSIONS };  // reported by the player itself or relayed by the server
+    enum Route { DIRECT, RELAYED };        // the command went to the player, or through the server to it
+
+    // sends path and params to the current player, sets the route it took and returns the handle
+    typedef std::function<PlexRequest*(const QString& path, const QString& params, Route* route)> Sender;
+
+    explicit PlexCommandQueue(Sender sender, QObject* parent = nullptr);
+
+    // STATE: "playing" or "paused". SKIP: steps, positive is next. SEEK: offset in ms. VOLUME: 0-100.
+    void push(Kind kind, const QVariant& value);
+    // anything else for the player, sent in order but never merged. MEDIA for playMedia so its expectation is traced,
+    // OTHER has none (i.e. refreshPlayQueue) and is not traced.
+    void push(const QString& path, const QString& params, Kind kind = OTHER);
+
+    // optimistic state, traced under the name of the command pressed (i.e. "VOLUME_UP"). SKIP expects the ratingKey
+    // playing when it was pressed to change, MEDIA "ratingKey/playQueueItemID" to change.
+    void     expect(Kind kind, const QVariant& value, const QString& command);
+    QVariant expected(Kind kind, const QVariant& fallback) const;
+    bool     expecting(Kind kind) const { return m_expectations.contains(kind); }
+
+    // what to show for a reported value: the expected one while it is pending, otherwise the reported one
+    QVariant reconcile(Kind kind, const QVariant& reported, Observer observer = TIMELINE);
+    // the command could not be sent (i.e. its play queue was not created): traced as failed
+    void fail(Kind kind);
+
+    // the entity has been written up to the last report. at: QElapsedTimer::msecsSinceReference() of a timer started
+    // then, on whichever thread wrote it.
+    void entityUpdated(qint64 at);
+    bool waitingForEntity() const { return !m_waiting.isEmpty(); }
+
+    // platform of the player the commands go to, traces are grouped by it
+    void setPlatform(const QString& platform) { m_platform = platform; }
+
+    void clear();
+
+    QVariantMap stats() const;
+
+ signals:
+    // a report confirmed or rolled back a command, its trace waits for entityUpdated()
+    void observed();
+
+ private:
+    struct Command {
+        Kind     kind = OTHER;
+        QVariant value;
+        QString  path;
+        QString  params;
+    };
+    struct Expectation {
+        QVariant value;
+        QString  command;
+        QString  platform;
+        Route    route = DIRECT;
+        qint64   pressed = 0;        // first press since the last confirmation
+        qint64   sent = 0;           // last command of this kind completed, 0 while one is queued or in flight
+        qint64   requestSent = -1;   // first request of the burst left, ms after the press
+        qint64   replyReceived = -1; // the player answered it, ms after the press
+    };
+    enum Outcome { BY_TIMELINE, BY_SESSIONS, FAILED };
+    struct Trace {  // ms after the press
+        qint64  sent = 0;
+        qint64  reply = 0;
+        qint64  observed = 0;  // confirmed, or given up on
+        qint64  entity = 0;
+        Outcome outcome = FAILED;
+    };
+    struct Waiting {  // observed, the entity not written yet
+        QString key;
+        qint64  pressed = 0;
+        Trace   trace;
+    };
+    struct Traces {
+        int             count = 0;
+        int             counts[FAILED + 1] = {};
+        QVector<Trace>  recent;  // last TRACE_SAMPLES, oldest first
+    };
+
+    void sendNext();
+    void sent(Kind kind);
+    void trace(const Expectation& expectation, Outcome outcome, qint64 now);
+    bool matches(Kind kind, const Expectation& expectation, const QVariant& reported) const;
+    bool pending(Kind kind) const;
+
+    static qint64 percentile(QVector<qint64> values, double fraction);
+
+    Sender                  m_sender;
+    QList<Command>          m_queue;
+    bool                    m_busy = false;
+    Kind                    m_inFlight = OTHER;
+    QElapsedTimer           m_clock;
+    QHash<int, Expectation> m_expectations;
+    QList<Waiting>          m_waiting;
+    QHash<QString, Traces>  m_traces;  // "command/platform/route"
+    QString                 m_platform;
+    int                     m_merged = 0;
+    int                     m_rolledBack = 0;
+
+    enum { CONFIRM_TIMEOUT = 5000, SEEK_TOLERANCE = 2000, TRACE_SAMPLES = 100 };
+};
@@ -0,0 +1,208 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "plexdiscovery.h"
+
+#include <QNetworkDatagram>
+
+static const char* GDM_GROUP = "239.0.0.250";
+
+PlexDiscovery::PlexDiscovery(QObject* parent)
+    : QObject(parent),
+      m_socket(new QUdpSocket(this)),
+      m_announce(new QUdpSocket(this)),
+      m_timer(new QTimer(this)),
+      m_interval(REFRESH_INTERVAL),
+      m_playerTarget(QString(GDM_GROUP)),
+      m_serverTarget(QHostAddress::Broadcast),
+      m_playerPort(PLAYER_PORT),
+      m_serverPort(SERVER_PORT) {
+    m_clock.start();
+    QObject::connect(m_socket, &QUdpSocket::readyRead, this, &PlexDiscovery::onReadyRead);
+    QObject::connect(m_announce, &QUdpSocket::readyRead, this, &PlexDiscovery::onReadyRead);
+    QObject::connect(m_timer, &QTimer::timeout, this, &PlexDiscovery::scan);
+}
+
+bool PlexDiscovery::start(int interval) {
+    m_interval = qMax(1000, interval);
+    m_timer->setInterval(m_interval);
+    if (m_socket->state() != QAbstractSocket::BoundState && !m_socket->bind(QHostAddress::AnyIPv4, 0)) {
+        return false;
+    }
+    // several programs listen for announcements on the same port, missing them only delays a new player
+    if (m_announce->state() != QAbstractSocket::BoundState &&
+        m_announce->bind(QHostAddress::AnyIPv4, ANNOUNCE_PORT, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)) {
+        m_announce->joinMulticastGroup(QHostAddress(QString(GDM_GROUP)));
+    }
+    m_timer->start();
+    scan();
+    return true;
+}
+
+void PlexDiscovery::stop() {
+    m_timer->stop();
+    m_socket->close();
+    m_announce->close();
+}
+
+void PlexDiscovery::setTarget(const QHostAddress& address, quint16 playerPort, quint16 serverPort) {
+    m_playerTarget = address;
+    m_serverTarget = address;
+    m_playerPort = playerPort;
+    m_serverPort = serverPort;
+}
+
+void PlexDiscovery::scan() {
+    expire();
+    static const QByteArray search("M-SEARCH * HTTP/1.0\r\n\r\n");
+    m_socket->writeDatagram(search, m_playerTarget, m_playerPort);
+    m_socket->writeDatagram(search, m_serverTarget, m_serverPort);
+    m_searches++;
+}
+
+QVector<PlexDiscovery::Device> PlexDiscovery::players() const {
+    QVector<Device> devices;
+    for (QHash<QString, Device>::const_iterator iter = m_players.constBegin(); iter != m_players.constEnd(); ++iter) {
+        devices.append(iter.value());
+    }
+    return devices;
+}
+
+QVector<PlexDiscovery::Device> PlexDiscovery::servers() const {
+    QVector<Device> devices;
+    for (QHash<QString, Device>::const_iterator iter = m_servers.constBegin(); iter != m_servers.constEnd(); ++iter) {
+        devices.append(iter.value());
+    }
+    return devices;
+}
+
+QString PlexDiscovery::stats() const {
+    return QString("players: %1 servers: %2 searches: %3 answers: %4 announcements: %5")
+        .arg(m_players.size())
+        .arg(m_servers.size())
+        .arg(m_searches)
+        .arg(m_answers)
+        .arg(m_announcements);
+}
+
+bool PlexDiscovery::parse(const QByteArray& datagram, Device* device) {
+    QList<QByteArray> lines = datagram.split('\n');
+    QByteArray        first = lines.first().trimmed();
+    if (!first.startsWith("HTTP/1.0 200") && !first.startsWith("HELLO") && !first.startsWith("BYE")) {
+        return false;
+    }
+
+    QByteArray contentType;
+    for (int i = 1; i < lines.size(); i++) {
+        int colon = lines[i].indexOf(':');
+        if (colon < 0) {
+            continue;
+        }
+        QByteArray name = lines[i].left(colon).trimmed().toLower();
+        QString    value = QString::fromUtf8(lines[i].mid(colon + 1).trimmed());
+        if (name == "resource-identifier") {
+            device->machineIdentifier = value;
+        } else if (name == "name") {
+            device->name = value;
+        } else if (name == "product") {
+            device->product = value;
+        } else if (name == "port") {
+            device->port = value;
+        } else if (name == "protocol-capabilities") {
+            device->capabilities = value.split(',', QString::SkipEmptyParts);
+        } else if (name == "content-type") {
+            contentType = value.toLatin1();
+        }
+    }
+    device->server = contentType == "plex/media-server";
+    return device->isValid();
+}
+
+void PlexDiscovery::onReadyRead() {
+    QUdpSocket* socket = qobject_cast<QUdpSocket*>(sender());
+    if (!socket) {
+        return;
+    }
+    while (socket->hasPendingDatagrams()) {
+        QNetworkDatagram datagram = socket->receiveDatagram();
+        Device           device;
+        if (!parse(datagram.data(), &device)) {
+            continue;
+        }
+        if (socket == m_announce) {
+            m_announcements++;
+        } else {
+            m_answers++;
+        }
+
+        if (datagram.data().startsWith("BYE")) {
+            if (m_players.remove(device.machineIdentifier) > 0) {
+                emit playerLost(device.machineIdentifier);
+            }
+            continue;
+        }
+
+        bool    ipv4 = false;
+        quint32 address = datagram.senderAddress().toIPv4Address(&ipv4);  // also unwraps v4-mapped addresses
+        device.address = ipv4 ? QHostAddress(address).toString() : datagram.senderAddress().toString();
+        device.lastSeen = m_clock.elapsed();
+        insert(device);
+    }
+}
+
+void PlexDiscovery::insert(Device device) {
+    QHash<QString, Device>& table = device.server ? m_servers : m_players;
+    Device                  known = table.value(device.machineIdentifier);
+    if (device.port.isEmpty()) {
+        device.port = known.port;  // announcements do not always carry the port
+    }
+    table.insert(device.machineIdentifier, device);
+
+    if (known.isValid() && known.address == device.address && known.port == device.port) {
+        return;
+    }
+    if (device.server) {
+        emit serverFound(device);
+    } else {
+        emit playerFound(device);
+    }
+}
+
+void PlexDiscovery::expire() {
+    qint64 oldest = m_clock.elapsed() - static_cast<qint64>(m_interval) * EXPIRE_ROUNDS;
+    for (QHash<QString, Device>::iterator iter = m_players.begin(); iter != m_players.end();) {
+        if (iter.value().lastSeen < oldest) {
+            QString id = iter.key();
+            iter = m_players.erase(iter);
+            emit playerLost(id);
+        } else {
+            ++iter;
+        }
+    }
+    for (QHash<QString, Device>::iterator iter = m_servers.begin(); iter != m_servers.end();) {
+        if (iter.value().lastSeen < oldest) {
+            iter = m_servers.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+}
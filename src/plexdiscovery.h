@@ -0,0 +1,110 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QStringList>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QVector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMEDIA DISCOVERY
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Local network discovery of players and servers (GDM). An "M-SEARCH * HTTP/1.0" datagram is sent to the player group
+// (239.0.0.250:32412) and as a broadcast to the servers (port 32414); every device answers with its identifier,
+// control port and capabilities. Players also announce themselves (HELLO/BYE) to the group on port 32413.
+// The table is refreshed in the background, devices that stop answering drop out after a few rounds.
+class PlexDiscovery : public QObject {
+    Q_OBJECT
+
+ public:
+    struct Device {
+        QString     machineIdentifier;
+        QString     name;
+        QString     product;
+        QString     address;
+        QString     port;
+        QStringList capabilities;  // Protocol-Capabilities, e.g. timeline,playback,navigation,playqueues
+        bool        server = false;
+        qint64      lastSeen = 0;  // ms on the discovery clock
+
+        bool isValid() const { return !machineIdentifier.isEmpty(); }
+    };
+
+    explicit PlexDiscovery(QObject* parent = nullptr);
+
+    bool start(int interval = REFRESH_INTERVAL);
+    void stop();
+    void scan();  // one search round, the answers arrive asynchronously
+    bool isActive() const { return m_timer->isActive(); }
+
+    // where the searches are sent. Defaults to the GDM group and broadcast, a local responder can be used instead.
+    void setTarget(const QHostAddress& address, quint16 playerPort, quint16 serverPort);
+
+    Device          player(const QString& machineIdentifier) const { return m_players.value(machineIdentifier); }
+    QVector<Device> players() const;
+    QVector<Device> servers() const;
+    QString         stats() const;
+
+    // parses an answer or announcement, false if it is not one
+    static bool parse(const QByteArray& datagram, Device* device);
+
+ signals:
+    void playerFound(const PlexDiscovery::Device& device);  // new, or its address or port changed
+    void serverFound(const PlexDiscovery::Device& device);
+    void playerLost(const QString& machineIdentifier);
+
+ private slots:  // NOLINT open issue: https://github.com/cpplint/cpplint/pull/99
+    void onReadyRead();
+
+ private:
+    void insert(Device device);
+    void expire();
+
+    QUdpSocket*            m_socket;    // searches and their answers
+    QUdpSocket*            m_announce;  // HELLO/BYE from players, optional
+    QTimer*                m_timer;
+    QElapsedTimer          m_clock;
+    int                    m_interval;
+    QHostAddress           m_playerTarget;
+    QHostAddress           m_serverTarget;
+    quint16                m_playerPort;
+    quint16                m_serverPort;
+    QHash<QString, Device> m_players;
+    QHash<QString, Device> m_servers;
+    int                    m_searches = 0;
+    int                    m_answers = 0;
+    int                    m_announcements = 0;
+
+    enum {
+        REFRESH_INTERVAL = 30000,  // ms between search rounds
+        EXPIRE_ROUNDS = 3,         // rounds without an answer before a device is dropped
+        PLAYER_PORT = 32412,
+        ANNOUNCE_PORT = 32413,
+        SERVER_PORT = 32414
+    };
+};
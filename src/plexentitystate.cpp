@@ -0,0 +1,81 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "plexentitystate.h"
+
+#include <QTimer>
+
+PlexEntityState::PlexEntityState(QObject* parent) : QObject(parent) {}
+
+void PlexEntityState::update(int attribute, const QVariant& value) {
+    Attributes::const_iterator pending = m_pending.constFind(attribute);
+    if (pending != m_pending.constEnd()) {
+        if (pending.value() == value) {
+            m_suppressed++;
+            return;
+        }
+    } else {
+        Attributes::const_iterator shadow = m_shadow.constFind(attribute);
+        if (shadow != m_shadow.constEnd() && shadow.value() == value) {
+            m_suppressed++;
+            return;
+        }
+    }
+
+    if (m_pending.contains(attribute)) {
+        m_suppressed++;  // overwritten before it was written out
+    }
+    m_pending.insert(attribute, value);
+    requestFlush();
+}
+
+void PlexEntityState::invalidate() { m_shadow.clear(); }
+
+void PlexEntityState::requestFlush() {
+    if (!m_flushScheduled) {
+        m_flushScheduled = true;
+        QTimer::singleShot(0, this, &PlexEntityState::flush);
+    }
+}
+
+void PlexEntityState::flush() {
+    m_flushScheduled = false;
+
+    // a value may have been set back to what is already shown before we got here
+    Attributes changes;
+    for (Attributes::const_iterator iter = m_pending.constBegin(); iter != m_pending.constEnd(); ++iter) {
+        Attributes::const_iterator shadow = m_shadow.constFind(iter.key());
+        if (shadow != m_shadow.constEnd() && shadow.value() == iter.value()) {
+            m_suppressed++;
+        } else {
+            changes.insert(iter.key(), iter.value());
+            m_shadow.insert(iter.key(), iter.value());
+        }
+    }
+    m_pending.clear();
+
+    if (!changes.isEmpty()) {
+        m_emitted += changes.size();
+        emit changed(changes);
+    }
+    emit flushed();
+}
@@ -0,0 +1,65 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QMap>
+#include <QObject>
+#include <QVariant>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMEDIA ENTITY STATE
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Shadow copy of the attributes last written to the media player entity. Updates are compared with it and only
+// real changes are passed on, collected into one batch per event loop pass. Every entity attribute write fans out
+// into property bindings on the remote, so a poll that changes nothing should cost nothing.
+class PlexEntityState : public QObject {
+    Q_OBJECT
+
+ public:
+    typedef QMap<int, QVariant> Attributes;
+
+    explicit PlexEntityState(QObject* parent = nullptr);
+
+    void update(int attribute, const QVariant& value);
+    void invalidate();  // forget the shadow copy, the next update of each attribute is always passed on
+    void requestFlush();  // flushed() after the next batch, even if nothing in it changes
+
+    int emittedUpdates() const { return m_emitted; }
+    int suppressedUpdates() const { return m_suppressed; }
+
+ signals:
+    void changed(const PlexEntityState::Attributes& attributes);
+    // a batch has been handed on: after changed() for it, if anything changed
+    void flushed();
+
+ private slots:  // NOLINT open issue: https://github.com/cpplint/cpplint/pull/99
+    void flush();
+
+ private:
+    Attributes m_shadow;
+    Attributes m_pending;
+    bool       m_flushScheduled = false;
+    int        m_emitted = 0;
+    int        m_suppressed = 0;
+};
@@ -0,0 +1,74 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "plexguidispatcher.h"
+
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QThread>
+
+PlexGuiDispatcher::PlexGuiDispatcher() : QObject(nullptr), m_batches(0), m_tasks(0) {
+    if (QCoreApplication::instance()) {
+        moveToThread(QCoreApplication::instance()->thread());
+    }
+}
+
+void PlexGuiDispatcher::post(const Task& task) {
+    if (QThread::currentThread() == thread()) {
+        m_tasks.ref();
+        task();
+        return;
+    }
+
+    bool first;
+    {
+        QMutexLocker locker(&m_mutex);
+        first = m_queue.isEmpty();
+        m_queue.append(task);
+    }
+    // one wake-up per batch, later posts join the pending one
+    if (first) {
+        QMetaObject::invokeMethod(this, "drain", Qt::QueuedConnection);
+    }
+}
+
+void PlexGuiDispatcher::adopt(QObject* object) {
+    if (object && object->thread() != thread()) {
+        object->moveToThread(thread());
+    }
+}
+
+void PlexGuiDispatcher::drain() {
+    QVector<Task> batch;
+    {
+        QMutexLocker locker(&m_mutex);
+        batch.swap(m_queue);
+    }
+    if (batch.isEmpty()) {
+        return;
+    }
+    m_batches.ref();
+    for (int i = 0; i < batch.size(); i++) {
+        m_tasks.ref();
+        batch[i]();
+    }
+}
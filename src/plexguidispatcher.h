@@ -0,0 +1,65 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+
+#include <functional>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMEDIA GUI DISPATCHER
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Entities and the models handed to them belong to the GUI thread. In worker thread mode the integration posts its
+// entity calls here instead of making them itself: they are queued under a lock and run on the GUI thread, everything
+// queued so far in one batch. Calls made on the GUI thread itself run straight away.
+class PlexGuiDispatcher : public QObject {
+    Q_OBJECT
+
+ public:
+    typedef std::function<void()> Task;
+
+    // lives on the application's thread, whichever thread creates it. Has no parent, the owner deletes it.
+    PlexGuiDispatcher();
+
+    void post(const Task& task);
+
+    // move a model created on the worker thread to the GUI thread before handing it over. Call from the thread
+    // that owns the model; it must not have a parent.
+    void adopt(QObject* object);
+
+    int batches() const { return m_batches.load(); }
+    int tasks() const { return m_tasks.load(); }
+
+ private slots:  // NOLINT open issue: https://github.com/cpplint/cpplint/pull/99
+    void drain();
+
+ private:
+    QMutex        m_mutex;
+    QVector<Task> m_queue;  // guarded by m_mutex
+    QAtomicInt    m_batches;
+    QAtomicInt    m_tasks;
+};
@@ -0,0 +1,199 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "plexhttpclient.h"
+
+#include <QDateTime>
+#include <QSet>
+#include <QTimer>
+
+PlexHttpClient::PlexHttpClient(int maxConnectionsPerHost, QObject* parent)
+    : QObject(parent),
+      m_manager(new QNetworkAccessManager(this)),
+      m_maxConnectionsPerHost(qMax(1, maxConnectionsPerHost)) {}
+
+PlexRequest* PlexHttpClient::get(const QNetworkRequest& request) { return enqueue("GET", request, QByteArray()); }
+
+PlexRequest* PlexHttpClient::post(const QNetworkRequest& request, const QByteArray& body) {
+    return enqueue("POST", request, body);
+}
+
+PlexRequest* PlexHttpClient::put(const QNetworkRequest& request, const QByteArray& body) {
+    return enqueue("PUT", request, body);
+}
+
+PlexRequest* PlexHttpClient::failed(const QUrl& url, const QString& reason) {
+    PlexRequest* handle = new PlexRequest(url, this);
+    handle->fail(reason);
+    return handle;
+}
+
+PlexRequest* PlexHttpClient::hold(const QByteArray& verb, const QNetworkRequest& request, const QByteArray& body) {
+    PlexRequest* handle = create(verb, request, body);
+
+    PendingRequest pending;
+    pending.verb    = verb;
+    pending.request = request;
+    pending.body    = body;
+    pending.handle  = handle;
+    m_held.append(pending);
+    return handle;
+}
+
+void PlexHttpClient::release(const QByteArray& header, const QByteArray& value) {
+    QVector<PendingRequest> held;
+    held.swap(m_held);
+
+    QSet<QString> hosts;
+    for (int i = 0; i < held.size(); i++) {
+        if (held[i].handle.isNull() || held[i].handle->isFinished()) {
+            continue;  // timed out or aborted while waiting
+        }
+        PendingRequest pending = held[i];
+        pending.request.setRawHeader(header, value);
+        QString host = hostKey(pending.request.url());
+        m_pools[host].queue.enqueue(pending);
+        hosts.insert(host);
+    }
+    for (QSet<QString>::const_iterator host = hosts.constBegin(); host != hosts.constEnd(); ++host) {
+        dispatch(*host);
+    }
+}
+
+void PlexHttpClient::discard(const QString& reason) {
+    QVector<PendingRequest> held;
+    held.swap(m_held);
+    for (int i = 0; i < held.size(); i++) {
+        if (!held[i].handle.isNull()) {
+            held[i].handle->fail(reason);
+        }
+    }
+}
+
+int PlexHttpClient::queuedRequests() const {
+    int queued = 0;
+    for (QHash<QString, HostPool>::const_iterator i = m_pools.constBegin(); i != m_pools.constEnd(); ++i) {
+        queued += i.value().queue.size();
+    }
+    return queued;
+}
+
+PlexRequest* PlexHttpClient::enqueue(const QByteArray& verb, const QNetworkRequest& request, const QByteArray& body) {
+    QString      host = hostKey(request.url());
+    PlexRequest* handle = create(verb, request, body);
+
+    PendingRequest pending;
+    pending.verb    = verb;
+    pending.request = request;
+    pending.body    = body;
+    pending.handle  = handle;
+
+    m_pools[host].queue.enqueue(pending);
+
+    // dispatch on the next event loop pass so the caller can attach continuations and a timeout first
+    QTimer::singleShot(0, this, [=]() { dispatch(host); });
+    return handle;
+}
+
+PlexRequest* PlexHttpClient::create(const QByteArray& verb, const QNetworkRequest& request, const QByteArray& body) {
+    PlexRequest* handle = new PlexRequest(request.url(), this);
+    qint64       bytesOut = body.size();
+    QObject::connect(handle, &PlexRequest::finished, this, [=]() {
+        PlexMetrics::Sample sample;
+        sample.statusCode = handle->statusCode();
+        sample.bytesOut = bytesOut;
+        sample.bytesIn = handle->bytesReceived();
+        sample.latency = handle->latency();
+        sample.failed = handle->hasFailed();
+        sample.timedOut = handle->isTimedOut();
+        sample.decodeTime = handle->decodeTime();
+        sample.handlerTime = handle->handlerTime();
+        m_metrics.record(verb, handle->url(), sample);
+    });
+    return handle;
+}
+
+void PlexHttpClient::dispatch(const QString& host) {
+    HostPool& pool = m_pools[host];
+    while (pool.inFlight < m_maxConnectionsPerHost && !pool.queue.isEmpty()) {
+        PendingRequest pending = pool.queue.dequeue();
+        if (pending.handle.isNull() || pending.handle->isFinished()) {
+            continue;  // aborted or timed out while queued
+        }
+        send(host, pending);
+    }
+}
+
+void PlexHttpClient::send(const QString& host, const PendingRequest& pending) {
+    HostPool& pool = m_pools[host];
+    qint64    now = QDateTime::currentMSecsSinceEpoch();
+
+    // forget idle connections the manager will have closed by now, then take the most recently used one
+    while (!pool.idleSince.isEmpty() && now - pool.idleSince.first() > KEEP_ALIVE_TIMEOUT_MS) {
+        pool.idleSince.removeFirst();
+    }
+    if (pool.idleSince.isEmpty()) {
+        m_newConnections++;
+    } else {
+        pool.idleSince.removeLast();
+        m_reusedConnections++;
+    }
+    pool.inFlight++;
+
+    QNetworkRequest request = pending.request;
+    request.setRawHeader("Connection", "keep-alive");
+
+    QNetworkReply* reply;
+    if (pending.verb == "GET") {
+        reply = m_manager->get(request);
+    } else if (pending.verb == "POST") {
+        reply = m_manager->post(request, pending.body);
+    } else {
+        reply = m_manager->put(request, pending.body);
+    }
+
+    QPointer<PlexRequest> handle = pending.handle;
+    handle->attach(reply);
+
+    QObject::connect(reply, &QNetworkReply::finished, this, [=]() {
+        HostPool& pool = m_pools[host];
+        pool.inFlight--;
+
+        // a connection survives the reply unless the transfer failed or the peer asked to close it
+        bool closed = reply->error() != QNetworkReply::NoError ||
+                      reply->rawHeader("Connection").toLower() == "close";
+        if (!closed) {
+            pool.idleSince.append(QDateTime::currentMSecsSinceEpoch());
+        }
+
+        if (handle) {
+            handle->complete(reply);
+        }
+        reply->deleteLater();
+
+        dispatch(host);
+    });
+}
+
+QString PlexHttpClient::hostKey(const QUrl& url) const {
+    return url.host() + ":" + QString::number(url.port(url.scheme() == "https" ? 443 : 80));
+}
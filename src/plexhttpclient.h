@@ -0,0 +1,107 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QQueue>
+#include <QVector>
+
+#include "plexmetrics.h"
+#include "plexrequest.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMEDIA HTTP CLIENT
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// One long-lived HTTP client per integration. All requests go through a single QNetworkAccessManager so that
+// the TCP connections to the PMS host and the player host are kept alive and reused between polls.
+// Requests are limited per host; anything above the limit waits in a per-host queue until a slot frees up.
+// Each request returns its own handle, the reply is delivered to that handle only.
+class PlexHttpClient : public QObject {
+    Q_OBJECT
+
+ public:
+    explicit PlexHttpClient(int maxConnectionsPerHost = 4, QObject* parent = nullptr);
+
+    PlexRequest* get(const QNetworkRequest& request);
+    PlexRequest* post(const QNetworkRequest& request, const QByteArray& body);
+    PlexRequest* put(const QNetworkRequest& request, const QByteArray& body);
+
+    // a handle that fails straight away without sending anything
+    PlexRequest* failed(const QUrl& url, const QString& reason);
+
+    // requests that need a credential which is not there yet (i.e. before sign-in). They wait, with their timeout
+    // running, until release() sends them with the header added, or discard() fails them.
+    PlexRequest* hold(const QByteArray& verb, const QNetworkRequest& request, const QByteArray& body);
+    void         release(const QByteArray& header, const QByteArray& value);
+    void         discard(const QString& reason);
+    int          heldRequests() const { return m_held.size(); }
+
+    void setMaxConnectionsPerHost(int max) { m_maxConnectionsPerHost = qMax(1, max); }
+    int  maxConnectionsPerHost() const { return m_maxConnectionsPerHost; }
+
+    // connection counters. Qt does not expose socket reuse, so these are derived from our own pool bookkeeping.
+    int  reusedConnections() const { return m_reusedConnections; }
+    int  newConnections() const { return m_newConnections; }
+    int  queuedRequests() const;
+
+    QNetworkAccessManager* manager() { return m_manager; }
+
+    // counters of every finished request, per endpoint
+    PlexMetrics&       metrics() { return m_metrics; }
+    const PlexMetrics& metrics() const { return m_metrics; }
+
+ private:
+    struct PendingRequest {
+        QByteArray            verb;
+        QNetworkRequest       request;
+        QByteArray            body;
+        QPointer<PlexRequest> handle;
+    };
+
+    struct HostPool {
+        int                    inFlight = 0;
+        QVector<qint64>        idleSince;  // one entry per open, idle keep-alive connection
+        QQueue<PendingRequest> queue;
+    };
+
+    PlexRequest* enqueue(const QByteArray& verb, const QNetworkRequest& request, const QByteArray& body);
+    PlexRequest* create(const QByteArray& verb, const QNetworkRequest& request, const QByteArray& body);
+    void         dispatch(const QString& host);
+    void         send(const QString& host, const PendingRequest& pending);
+    QString      hostKey(const QUrl& url) const;
+
+    QNetworkAccessManager*   m_manager;
+    QHash<QString, HostPool> m_pools;
+    QVector<PendingRequest>  m_held;
+    int                      m_maxConnectionsPerHost;
+    int                      m_reusedConnections = 0;
+    int                      m_newConnections = 0;
+    PlexMetrics              m_metrics;
+
+    // Qt drops idle keep-alive connections after this period, after which we count the next request as a new one
+    static const qint64 KEEP_ALIVE_TIMEOUT_MS = 60000;
+};
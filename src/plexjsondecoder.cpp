@@ -0,0 +1,528 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "plexjsondecoder.h"
+
+#include <cstring>
+
+PlexJsonDecoder::PlexJsonDecoder(const QByteArray& data)
+    : m_begin(data.constData()), m_pos(data.constData()), m_end(data.constData() + data.size()) {}
+
+bool PlexJsonDecoder::decode(const QByteArray& data, PlexMediaContainer* container, QString* error) {
+    PlexJsonDecoder decoder(data);
+    bool            found = false;
+
+    *container = PlexMediaContainer();
+
+    if (decoder.beginObject()) {
+        bool first = true;
+        while (decoder.nextMember(&first)) {
+            if (decoder.keyIs("MediaContainer")) {
+                decoder.decodeContainer(container);
+                found = true;
+            } else {
+                decoder.skipValue();
+            }
+        }
+    }
+    if (!decoder.m_error && !found) {
+        decoder.fail("no MediaContainer in reply");
+    }
+
+    if (decoder.m_error && error) {
+        *error = decoder.m_errorString;
+    }
+    return !decoder.m_error;
+}
+
+bool PlexJsonDecoder::decodeNotification(const QByteArray& data, PlexNotification* notification, QString* error) {
+    PlexJsonDecoder decoder(data);
+    bool            found = false;
+
+    *notification = PlexNotification();
+
+    if (decoder.beginObject()) {
+        bool first = true;
+        while (decoder.nextMember(&first)) {
+            if (decoder.keyIs("NotificationContainer")) {
+                decoder.decodeNotificationContainer(notification);
+                found = true;
+            } else {
+                decoder.skipValue();
+            }
+        }
+    }
+    if (!decoder.m_error && !found) {
+        decoder.fail("no NotificationContainer in message");
+    }
+
+    if (decoder.m_error && error) {
+        *error = decoder.m_errorString;
+    }
+    return !decoder.m_error;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// MEDIACONTAINER
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PlexJsonDecoder::decodeContainer(PlexMediaContainer* container) {
+    if (!beginObject()) return;
+    bool first = true;
+    while (nextMember(&first)) {
+        if (keyIs("Metadata")) {
+            if (!beginArray()) continue;
+            bool firstElement = true;
+            while (nextElement(&firstElement)) {
+                PlexSession session;
+                decodeMetadata(&session);
+                // sessions carry the player they are playing on, everything else is a plain item
+                if (session.player.machineIdentifier.isEmpty()) {
+                    container->metadata.append(session.item);
+                } else {
+                    container->sessions.append(session);
+                }
+            }
+        } else if (keyIs("Directory")) {
+            if (!beginArray()) continue;
+            bool firstElement = true;
+            while (nextElement(&firstElement)) {
+                PlexSession directory;
+                decodeMetadata(&directory);
+                container->directories.append(directory.item);
+            }
+        } else if (keyIs("Server")) {
+            if (!beginArray()) continue;
+            bool firstElement = true;
+            while (nextElement(&firstElement)) {
+                PlexClient client;
+                decodeClient(&client);
+                container->clients.append(client);
+            }
+        } else if (keyIs("size")) {                         container->size = static_cast<int>(readInteger());
+        } else if (keyIs("totalSize")) {                    container->totalSize = readInteger();
+        } else if (keyIs("offset")) {                       container->offset = readInteger();
+        } else if (keyIs("updatedAt")) {                    container->updatedAt = readInteger();
+        } else if (keyIs("key")) {                          container->key = readString();
+        } else if (keyIs("ratingKey")) {                    container->ratingKey = readString();
+        } else if (keyIs("title")) {                        container->title = readString();
+        } else if (keyIs("title1")) {                       container->title1 = readString();
+        } else if (keyIs("title2")) {                       container->title2 = readString();
+        } else if (keyIs("parentTitle")) {                  container->parentTitle = readString();
+        } else if (keyIs("grandparentTitle")) {             container->grandparentTitle = readString();
+        } else if (keyIs("thumb")) {                        container->thumb = readString();
+        } else if (keyIs("grandparentThumb")) {             container->grandparentThumb = readString();
+        } else if (keyIs("viewGroup")) {                    container->viewGroup = readString();
+        } else if (keyIs("leafCount")) {                    container->leafCount = readString();
+        } else if (keyIs("machineIdentifier")) {            container->machineIdentifier = readString();
+        } else if (keyIs("playQueueID")) {                  container->playQueue.id = readString();
+        } else if (keyIs("playQueueVersion")) {             container->playQueue.version = readInteger();
+        } else if (keyIs("playQueueSelectedItemID")) {      container->playQueue.selectedItemID = readInteger();
+        } else if (keyIs("playQueueSelectedItemOffset")) {  container->playQueue.selectedItemOffset = readInteger();
+        } else if (keyIs("playQueueTotalCount")) {          container->playQueue.totalCount = readInteger();
+        } else {
+            skipValue();
+        }
+    }
+}
+
+void PlexJsonDecoder::decodeMetadata(PlexSession* session) {
+    PlexMetadataItem& item = session->item;
+    if (!beginObject()) return;
+    bool first = true;
+    while (nextMember(&first)) {
+        if (keyIs("Player")) {                          decodePlayer(&session->player);
+        } else if (keyIs("User")) {                     decodeUser(&session->userThumb);
+        } else if (keyIs("ratingKey")) {                item.ratingKey = readString();
+        } else if (keyIs("key")) {                      item.key = readString();
+        } else if (keyIs("type")) {                     item.type = readString();
+        } else if (keyIs("title")) {                    item.title = readString();
+        } else if (keyIs("titleSort")) {                item.titleSort = readString();
+        } else if (keyIs("originalTitle")) {            item.originalTitle = readString();
+        } else if (keyIs("parentTitle")) {              item.parentTitle = readString();
+        } else if (keyIs("grandparentTitle")) {         item.grandparentTitle = readString();
+        } else if (keyIs("thumb")) {                    item.thumb = readString();
+        } else if (keyIs("parentThumb")) {              item.parentThumb = readString();
+        } else if (keyIs("grandparentThumb")) {         item.grandparentThumb = readString();
+        } else if (keyIs("summary")) {                  item.summary = readString();
+        } else if (keyIs("tagline")) {                  item.tagLine = readString();
+        } else if (keyIs("playlistType")) {             item.playlistType = readString();
+        } else if (keyIs("librarySectionTitle")) {      item.librarySectionTitle = readString();
+        } else if (keyIs("leafCount")) {                item.leafCount = readString();
+        } else if (keyIs("duration")) {                 item.duration = readInteger();
+        } else if (keyIs("viewOffset")) {               item.viewOffset = readInteger();
+        } else if (keyIs("updatedAt")) {                item.updatedAt = readInteger();
+        } else if (keyIs("playQueueItemID")) {          item.playQueueItemID = readInteger();
+        } else {
+            skipValue();
+        }
+    }
+}
+
+void PlexJsonDecoder::decodePlayer(PlexPlayer* player) {
+    if (!beginObject()) return;
+    bool first = true;
+    while (nextMember(&first)) {
+        if (keyIs("machineIdentifier")) {   player->machineIdentifier = readString();
+        } else if (keyIs("address")) {      player->address = readString();
+        } else if (keyIs("title")) {        player->title = readString();
+        } else if (keyIs("platform")) {     player->platform = readString();
+        } else if (keyIs("state")) {        player->state = readString();
+        } else if (keyIs("local")) {        player->local = readBool();
+        } else {
+            skipValue();
+        }
+    }
+}
+
+void PlexJsonDecoder::decodeUser(QString* thumb) {
+    if (!beginObject()) return;
+    bool first = true;
+    while (nextMember(&first)) {
+        if (keyIs("thumb")) {
+            *thumb = readString();
+        } else {
+            skipValue();
+        }
+    }
+}
+
+void PlexJsonDecoder::decodeClient(PlexClient* client) {
+    if (!beginObject()) return;
+    bool first = true;
+    while (nextMember(&first)) {
+        if (keyIs("machineIdentifier")) {   client->machineIdentifier = readString();
+        } else if (keyIs("name")) {         client->name = readString();
+        } else if (keyIs("address")) {      client->address = readString();
+        } else if (keyIs("port")) {         client->port = readString();
+        } else if (keyIs("product")) {      client->product = readString();
+        } else if (keyIs("platform")) {     client->platform = readString();
+        } else {
+            skipValue();
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// NOTIFICATIONCONTAINER
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PlexJsonDecoder::decodeNotificationContainer(PlexNotification* notification) {
+    if (!beginObject()) return;
+    bool first = true;
+    while (nextMember(&first)) {
+        if (keyIs("type")) {
+            notification->type = readString();
+        } else if (keyIs("PlaySessionStateNotification")) {
+            if (!beginArray()) continue;
+            bool firstElement = true;
+            while (nextElement(&firstElement)) {
+                PlexPlaySessionState state;
+                decodePlaySessionState(&state);
+                notification->playSessions.append(state);
+            }
+        } else if (keyIs("TimelineEntry")) {
+            if (!beginArray()) continue;
+            bool firstElement = true;
+            while (nextElement(&firstElement)) {
+                PlexTimelineEntry entry;
+                decodeTimelineEntry(&entry);
+                notification->timeline.append(entry);
+            }
+        } else {
+            skipValue();
+        }
+    }
+}
+
+void PlexJsonDecoder::decodePlaySessionState(PlexPlaySessionState* state) {
+    if (!beginObject()) return;
+    bool first = true;
+    while (nextMember(&first)) {
+        if (keyIs("sessionKey")) {                  state->sessionKey = readString();
+        } else if (keyIs("clientIdentifier")) {     state->clientIdentifier = readString();
+        } else if (keyIs("ratingKey")) {            state->ratingKey = readString();
+        } else if (keyIs("key")) {                  state->key = readString();
+        } else if (keyIs("state")) {                state->state = readString();
+        } else if (keyIs("viewOffset")) {           state->viewOffset = readInteger();
+        } else if (keyIs("playQueueItemID")) {      state->playQueueItemID = readInteger();
+        } else {
+            skipValue();
+        }
+    }
+}
+
+void PlexJsonDecoder::decodeTimelineEntry(PlexTimelineEntry* entry) {
+    if (!beginObject()) return;
+    bool first = true;
+    while (nextMember(&first)) {
+        if (keyIs("itemID")) {              entry->itemID = readString();
+        } else if (keyIs("type")) {         entry->type = static_cast<int>(readInteger());
+        } else if (keyIs("state")) {        entry->state = static_cast<int>(readInteger());
+        } else if (keyIs("updatedAt")) {    entry->updatedAt = readInteger();
+        } else {
+            skipValue();
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// TOKENIZER
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool PlexJsonDecoder::beginObject() {
+    skipWhitespace();
+    if (m_pos < m_end && *m_pos == '{') {
+        m_pos++;
+        return true;
+    }
+    skipValue();  // unexpected type, i.e. null. Skip it and carry on.
+    return false;
+}
+
+bool PlexJsonDecoder::nextMember(bool* first) {
+    if (m_error) return false;
+    skipWhitespace();
+    if (m_pos < m_end && *m_pos == '}') {
+        m_pos++;
+        return false;
+    }
+    if (!*first && !expect(',')) return false;
+    *first = false;
+
+    skipWhitespace();
+    if (!expect('"')) return false;
+    m_key = m_pos;
+    while (m_pos < m_end && *m_pos != '"') {
+        if (*m_pos == '\\') m_pos++;  // keys are plain ASCII, just step over escapes
+        m_pos++;
+    }
+    m_keyLength = static_cast<int>(m_pos - m_key);
+    if (!expect('"')) return false;
+
+    skipWhitespace();
+    return expect(':');
+}
+
+bool PlexJsonDecoder::beginArray() {
+    skipWhitespace();
+    if (m_pos < m_end && *m_pos == '[') {
+        m_pos++;
+        return true;
+    }
+    skipValue();
+    return false;
+}
+
+bool PlexJsonDecoder::nextElement(bool* first) {
+    if (m_error) return false;
+    skipWhitespace();
+    if (m_pos < m_end && *m_pos == ']') {
+        m_pos++;
+        return false;
+    }
+    if (!*first && !expect(',')) return false;
+    *first = false;
+    return true;
+}
+
+bool PlexJsonDecoder::keyIs(const char* name) const {
+    return static_cast<int>(strlen(name)) == m_keyLength && memcmp(name, m_key, m_keyLength) == 0;
+}
+
+QString PlexJsonDecoder::readString() {
+    skipWhitespace();
+    if (m_pos >= m_end) {
+        fail("unexpected end of data");
+        return QString();
+    }
+
+    if (*m_pos != '"') {
+        // numbers and booleans are returned as their literal text, null as an empty string
+        if (*m_pos == '{' || *m_pos == '[') {
+            skipValue();
+            return QString();
+        }
+        const char* start = m_pos;
+        skipValue();
+        if (m_pos - start == 4 && memcmp(start, "null", 4) == 0) return QString();
+        return QString::fromLatin1(start, static_cast<int>(m_pos - start));
+    }
+
+    m_pos++;
+    const char* start = m_pos;
+    while (m_pos < m_end && *m_pos != '"' && *m_pos != '\\') m_pos++;
+
+    // fast path: no escapes, decode the UTF-8 bytes in place
+    if (m_pos < m_end && *m_pos == '"') {
+        QString value = QString::fromUtf8(start, static_cast<int>(m_pos - start));
+        m_pos++;
+        return value;
+    }
+
+    QString value = QString::fromUtf8(start, static_cast<int>(m_pos - start));
+    while (m_pos < m_end && *m_pos != '"') {
+        if (*m_pos != '\\') {
+            start = m_pos;
+            while (m_pos < m_end && *m_pos != '"' && *m_pos != '\\') m_pos++;
+            value += QString::fromUtf8(start, static_cast<int>(m_pos - start));
+            continue;
+        }
+        if (++m_pos >= m_end) break;
+        switch (*m_pos) {
+            case 'b': value += QChar('\b'); break;
+            case 'f': value += QChar('\f'); break;
+            case 'n': value += QChar('\n'); break;
+            case 'r': value += QChar('\r'); break;
+            case 't': value += QChar('\t'); break;
+            case 'u': {
+                if (m_end - m_pos < 5) {
+                    fail("truncated unicode escape");
+                    return value;
+                }
+                bool   ok;
+                ushort code = QByteArray(m_pos + 1, 4).toUShort(&ok, 16);
+                if (!ok) {
+                    fail("invalid unicode escape");
+                    return value;
+                }
+                value += QChar(code);  // surrogate pairs arrive as two escapes and combine in the QString
+                m_pos += 4;
+                break;
+            }
+            default: value += QChar::fromLatin1(*m_pos); break;  // \" \\ and \/
+        }
+        m_pos++;
+    }
+    expect('"');
+    return value;
+}
+
+qint64 PlexJsonDecoder::readInteger() {
+    skipWhitespace();
+    if (m_pos >= m_end) {
+        fail("unexpected end of data");
+        return 0;
+    }
+    if (*m_pos == '"') {
+        return readString().toLongLong();
+    }
+    if (*m_pos == 't' || *m_pos == 'f') {
+        return readBool() ? 1 : 0;
+    }
+
+    bool negative = false;
+    if (*m_pos == '-') {
+        negative = true;
+        m_pos++;
+    }
+    qint64 value = 0;
+    while (m_pos < m_end && *m_pos >= '0' && *m_pos <= '9') {
+        value = value * 10 + (*m_pos - '0');
+        m_pos++;
+    }
+    skipValue();  // fraction, exponent or a literal such as null
+    return negative ? -value : value;
+}
+
+bool PlexJsonDecoder::readBool() {
+    skipWhitespace();
+    if (m_end - m_pos >= 4 && memcmp(m_pos, "true", 4) == 0) {
+        m_pos += 4;
+        return true;
+    }
+    if (m_pos < m_end && *m_pos == '"') {
+        QString value = readString();
+        return value == "1" || value == "true";
+    }
+    if (m_pos < m_end && *m_pos >= '1' && *m_pos <= '9') {
+        return readInteger() != 0;
+    }
+    skipValue();
+    return false;
+}
+
+void PlexJsonDecoder::skipValue() {
+    skipWhitespace();
+    if (m_pos >= m_end) return;
+
+    if (*m_pos == '"') {
+        skipString();
+    } else if (*m_pos == '{' || *m_pos == '[') {
+        int depth = 0;
+        while (m_pos < m_end) {
+            char c = *m_pos;
+            if (c == '"') {
+                skipString();
+                continue;
+            }
+            if (c == '{' || c == '[') {
+                depth++;
+            } else if (c == '}' || c == ']') {
+                if (--depth == 0) {
+                    m_pos++;
+                    return;
+                }
+            }
+            m_pos++;
+        }
+        fail("unterminated object or array");
+    } else {
+        // number or literal: runs until the next separator
+        while (m_pos < m_end && *m_pos != ',' && *m_pos != '}' && *m_pos != ']' && *m_pos != ' ' && *m_pos != '\t' &&
+               *m_pos != '\r' && *m_pos != '\n') {
+            m_pos++;
+        }
+    }
+}
+
+void PlexJsonDecoder::skipString() {
+    m_pos++;  // opening quote
+    while (m_pos < m_end && *m_pos != '"') {
+        if (*m_pos == '\\') m_pos++;
+        m_pos++;
+    }
+    if (m_pos >= m_end) {
+        fail("unterminated string");
+        return;
+    }
+    m_pos++;  // closing quote
+}
+
+void PlexJsonDecoder::skipWhitespace() {
+    while (m_pos < m_end && (*m_pos == ' ' || *m_pos == '\t' || *m_pos == '\r' || *m_pos == '\n')) m_pos++;
+}
+
+bool PlexJsonDecoder::expect(char c) {
+    if (m_pos < m_end && *m_pos == c) {
+        m_pos++;
+        return true;
+    }
+    fail("unexpected character");
+    return false;
+}
+
+void PlexJsonDecoder::fail(const char* reason) {
+    if (m_error) return;
+    m_error = true;
+    m_errorString = QString("%1 at offset %2").arg(reason).arg(m_pos - m_begin);
+}
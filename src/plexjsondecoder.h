@@ -0,0 +1,78 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+#include "plextypes.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMEDIA JSON DECODER
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Single pass pull decoder for Plex MediaContainer replies. Reads the raw reply bytes once and fills the typed
+// records directly, skipping every value the integration does not use. No QJsonDocument or QVariantMap is built.
+class PlexJsonDecoder {
+ public:
+    static bool decode(const QByteArray& data, PlexMediaContainer* container, QString* error = nullptr);
+    static bool decodeNotification(const QByteArray& data, PlexNotification* notification, QString* error = nullptr);
+
+ private:
+    explicit PlexJsonDecoder(const QByteArray& data);
+
+    // MediaContainer structure
+    void decodeContainer(PlexMediaContainer* container);
+    void decodeMetadata(PlexSession* session);
+    void decodePlayer(PlexPlayer* player);
+    void decodeUser(QString* thumb);
+    void decodeClient(PlexClient* client);
+
+    // NotificationContainer structure
+    void decodeNotificationContainer(PlexNotification* notification);
+    void decodePlaySessionState(PlexPlaySessionState* state);
+    void decodeTimelineEntry(PlexTimelineEntry* entry);
+
+    // tokenizer
+    bool    beginObject();
+    bool    nextMember(bool* first);
+    bool    beginArray();
+    bool    nextElement(bool* first);
+    bool    keyIs(const char* name) const;
+    QString readString();
+    qint64  readInteger();
+    bool    readBool();
+    void    skipValue();
+    void    skipString();
+    void    skipWhitespace();
+    bool    expect(char c);
+    void    fail(const char* reason);
+
+    const char* m_begin;
+    const char* m_pos;
+    const char* m_end;
+    const char* m_key = nullptr;
+    int         m_keyLength = 0;
+    bool        m_error = false;
+    QString     m_errorString;
+};
@@ -0,0 +1,546 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "plexlibraryindex.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <algorithm>
+
+static const quint32 INDEX_MAGIC = 0x504c584c;  // "PLXL"
+static const quint32 INDEX_VERSION = 2;
+
+PlexLibraryIndex::PlexLibraryIndex(PlexHttpClient* http, const QString& fileName, QObject* parent)
+    : QObject(parent), m_http(http), m_fileName(fileName), m_refreshTimer(new QTimer(this)),
+      m_retryTimer(new QTimer(this)), m_changeTimer(new QTimer(this)) {
+    m_refreshTimer->setInterval(REFRESH_INTERVAL);
+    QObject::connect(m_refreshTimer, &QTimer::timeout, this, &PlexLibraryIndex::sync);
+    m_retryTimer->setInterval(RETRY_DELAY);
+    m_retryTimer->setSingleShot(true);
+    QObject::connect(m_retryTimer, &QTimer::timeout, this, &PlexLibraryIndex::sync);
+    m_changeTimer->setInterval(CHANGE_DELAY);
+    m_changeTimer->setSingleShot(true);
+    QObject::connect(m_changeTimer, &QTimer::timeout, this, &PlexLibraryIndex::sync);
+}
+
+void PlexLibraryIndex::setServer(const QString& serverURL, const QString& token) {
+    m_serverURL = serverURL;
+    m_token = token;
+}
+
+void PlexLibraryIndex::start() {
+    m_refreshTimer->start();
+    sync();
+}
+
+void PlexLibraryIndex::stop() {
+    m_refreshTimer->stop();
+    m_retryTimer->stop();
+    m_changeTimer->stop();
+}
+
+bool PlexLibraryIndex::isReady() const {
+    if (m_items.isEmpty() || m_state.isEmpty()) {
+        return false;
+    }
+    for (QHash<QString, SyncState>::const_iterator iter = m_state.constBegin(); iter != m_state.constEnd(); ++iter) {
+        if (!iter.value().complete) {
+            return false;  // partly loaded, the server knows better
+        }
+    }
+    return true;
+}
+
+void PlexLibraryIndex::changed() {
+    if (m_refreshTimer->isActive() && !m_changeTimer->isActive()) {
+        m_changeTimer->start();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// SYNCHRONISATION
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PlexLibraryIndex::sync() {
+    if (m_syncing || m_serverURL.isEmpty() || m_token.isEmpty()) {
+        return;
+    }
+    m_syncing = true;
+    m_changed = false;
+
+    QNetworkRequest request(QUrl(m_serverURL + "/library/sections"));
+    request.setRawHeader("Accept", "application/json");
+    request.setRawHeader("X-Plex-Token", m_token.toUtf8());
+
+    PlexRequest* handle = m_http->get(request)->setTimeout(30000);
+    handle->onError(this, [=](const QString& error) {
+        Q_UNUSED(error)
+        m_syncing = false;
+    });
+    handle->then(this, [=](const PlexMediaContainer& container) {
+        // one job per section and item type that search can return
+        for (int i = 0; i < container.directories.size(); i++) {
+            const PlexMetadataItem& directory = container.directories[i];
+            QVector<int>            types;
+            if (directory.type == "artist") {
+                types << 8 << 9 << 10;
+            } else if (directory.type == "movie") {
+                types << 1;
+            } else if (directory.type == "show") {
+                types << 2 << 4;
+            }
+            for (int j = 0; j < types.size(); j++) {
+                Job job;
+                job.section = directory.key.toInt();
+                job.type = types[j];
+                m_jobs.enqueue(job);
+                m_state[stateKey(job)];  // a section not walked yet keeps the index from being ready
+            }
+        }
+
+        // playlists are few, always loaded whole
+        Job playlists;
+        playlists.type = PLAYLISTS;
+        playlists.start = 0;
+        m_jobs.enqueue(playlists);
+        m_state[stateKey(playlists)];
+
+        runNext();
+    });
+}
+
+void PlexLibraryIndex::runNext() {
+    if (m_jobs.isEmpty()) {
+        finishJob();
+        return;
+    }
+
+    Job             job = m_jobs.dequeue();
+    QNetworkRequest request(jobUrl(job));
+    request.setRawHeader("Accept", "application/json");
+    request.setRawHeader("X-Plex-Token", m_token.toUtf8());
+
+    // one request at a time, the index is never urgent
+    PlexRequest* handle = m_http->get(request)->setTimeout(30000);
+    handle->onError(this, [=](const QString& error) {
+        Q_UNUSED(error)
+        // nothing of the interrupted walk was committed: a delta asks again from the last complete sync, a full
+        // load starts over. Tried again shortly rather than at the next refresh.
+        m_jobs.clear();
+        finishJob();
+        if (m_refreshTimer->isActive()) m_retryTimer->start();
+    });
+    handle->then(this, [=](const PlexMediaContainer& container) {
+        if (job.start < 0) {
+            checkJob(job, container);
+        } else {
+            pageJob(job, container);
+        }
+        runNext();
+    });
+}
+
+void PlexLibraryIndex::finishJob() {
+    m_syncing = false;
+    if (m_changed) {
+        m_changed = false;
+        save();
+        emit synced();
+    }
+}
+
+QUrl PlexLibraryIndex::jobUrl(const Job& job) const {
+    QString url = job.type == PLAYLISTS
+                      ? m_serverURL + "/playlists?"
+                      : m_serverURL + "/library/sections/" + QString::number(job.section) +
+                            "/all?type=" + QString::number(job.type) + "&";
+
+    if (job.start < 0) {
+        url += "X-Plex-Container-Start=0&X-Plex-Container-Size=0";  // only the total count
+    } else {
+        url += "X-Plex-Container-Start=" + QString::number(job.start) +
+               "&X-Plex-Container-Size=" + QString::number(PAGE_SIZE);
+    }
+    if (job.since > 0) {
+        url += "&updatedAt%3E=" + QString::number(job.since);  // updatedAt>=since
+    }
+    return QUrl(url);
+}
+
+QString PlexLibraryIndex::stateKey(const Job& job) const {
+    return QString::number(job.section) + ":" + QString::number(job.type);
+}
+
+void PlexLibraryIndex::checkJob(const Job& job, const PlexMediaContainer& container) {
+    const SyncState& state = m_state[stateKey(job)];
+
+    Job next = job;
+    next.start = 0;
+    next.total = container.totalSize;
+    if (!state.complete || container.totalSize < state.count) {
+        // first load, an interrupted one, or items were removed (which a delta does not show): load it whole
+        next.since = 0;
+    } else {
+        next.since = state.updatedAt;  // only what was added or changed since
+    }
+    m_jobs.enqueue(next);
+}
+
+void PlexLibraryIndex::pageJob(const Job& job, const PlexMediaContainer& container) {
+    SyncState& state = m_state[stateKey(job)];
+
+    if (job.start == 0 && job.since == 0) {
+        removeSection(job.section, typeName(job.type));
+        state.complete = false;  // until the last page is in
+        m_changed = true;
+    }
+    Job next = job;
+    for (int i = 0; i < container.metadata.size(); i++) {
+        upsert(fromMetadata(container.metadata[i], job.section));
+        next.newest = qMax(next.newest, container.metadata[i].updatedAt);
+        m_changed = true;
+    }
+
+    int fetched = job.start + container.metadata.size();
+    if (!container.metadata.isEmpty() && fetched < container.totalSize) {
+        next.start = fetched;
+        m_jobs.enqueue(next);
+        return;
+    }
+
+    // the last page: only now is the section known to be complete up to the newest item seen
+    state.count = job.type == PLAYLISTS ? container.totalSize : next.total;  // playlists skip the check
+    state.updatedAt = qMax(state.updatedAt, next.newest);
+    state.complete = true;
+    m_changed = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// INDEX
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+PlexLibraryIndex::Item PlexLibraryIndex::fromMetadata(const PlexMetadataItem& metadata, int section) {
+    Item item;
+    item.ratingKey = metadata.ratingKey;
+    item.type = metadata.type;
+    item.title = metadata.title.isEmpty() ? metadata.titleSort : metadata.title;
+    item.thumb = metadata.thumb.isEmpty() ? metadata.grandparentThumb : metadata.thumb;  // no images for some entries
+    item.updatedAt = metadata.updatedAt;
+    item.section = section;
+
+    if (metadata.type == "album") {
+        item.subtitle = metadata.parentTitle;
+    } else if (metadata.type == "track") {
+        item.subtitle = metadata.originalTitle.isEmpty() ? metadata.grandparentTitle : metadata.originalTitle;
+    } else if (metadata.type == "episode") {
+        item.subtitle = metadata.grandparentTitle + " - " + metadata.parentTitle;
+    } else if (metadata.type == "playlist") {
+        item.subtitle = metadata.playlistType;
+    }
+    return item;
+}
+
+void PlexLibraryIndex::upsert(const Item& item) {
+    QHash<QString, int>::const_iterator existing = m_byKey.constFind(item.ratingKey);
+    if (existing != m_byKey.constEnd()) {
+        m_items[existing.value()] = item;
+    } else {
+        m_byKey.insert(item.ratingKey, m_items.size());
+        m_items.append(item);
+    }
+    m_dirty = true;
+}
+
+void PlexLibraryIndex::removeSection(int section, const QString& type) {
+    QVector<Item> kept;
+    kept.reserve(m_items.size());
+    for (int i = 0; i < m_items.size(); i++) {
+        if (m_items[i].section != section || m_items[i].type != type) {
+            kept.append(m_items[i]);
+        }
+    }
+    if (kept.size() == m_items.size()) {
+        return;
+    }
+
+    m_items = kept;
+    m_byKey.clear();
+    for (int i = 0; i < m_items.size(); i++) {
+        m_byKey.insert(m_items[i].ratingKey, i);
+    }
+    m_dirty = true;
+}
+
+void PlexLibraryIndex::rebuild() {
+    m_words.clear();
+    m_trigrams.clear();
+    m_normalized.resize(m_items.size());
+
+    for (int i = 0; i < m_items.size(); i++) {
+        QString title = normalize(m_items[i].title);
+        m_normalized[i] = " " + title + " " + normalize(m_items[i].subtitle);
+
+        QStringList titleWords = title.split(' ', QString::SkipEmptyParts);
+        for (int j = 0; j < titleWords.size(); j++) {
+            m_words.append(qMakePair(titleWords[j], i));
+        }
+
+        QString padded = " " + title + " ";
+        for (int j = 0; j + 3 <= padded.size(); j++) {
+            quint64 trigram = (static_cast<quint64>(padded[j].unicode()) << 32) |
+                              (static_cast<quint64>(padded[j + 1].unicode()) << 16) | padded[j + 2].unicode();
+            QVector<int>& postings = m_trigrams[trigram];
+            if (postings.isEmpty() || postings.last() != i) {
+                postings.append(i);
+            }
+        }
+    }
+    std::sort(m_words.begin(), m_words.end());
+    m_dirty = false;
+}
+
+QVector<int> PlexLibraryIndex::prefixMatches(const QStringList& words) {
+    // the longest word narrows the candidates most, the other words filter them
+    int driver = 0;
+    for (int i = 1; i < words.size(); i++) {
+        if (words[i].size() > words[driver].size()) driver = i;
+    }
+    const QString& prefix = words[driver];
+
+    QVector<int>  matches;
+    QSet<int>     seen;
+    QVector<QPair<QString, int> >::const_iterator iter =
+        std::lower_bound(m_words.constBegin(), m_words.constEnd(), qMakePair(prefix, -1));
+    for (; iter != m_words.constEnd() && iter->first.startsWith(prefix); ++iter) {
+        int item = iter->second;
+        if (seen.contains(item)) continue;
+        seen.insert(item);
+
+        bool all = true;
+        for (int i = 0; i < words.size() && all; i++) {
+            all = i == driver || m_normalized[item].contains(" " + words[i]);
+        }
+        if (all) matches.append(item);
+    }
+    return matches;
+}
+
+QVector<int> PlexLibraryIndex::fuzzyMatches(const QString& query) {
+    QString padded = " " + normalize(query) + " ";
+    if (padded.size() < 4) {
+        return QVector<int>();
+    }
+
+    QSet<quint64> trigrams;
+    for (int j = 0; j + 3 <= padded.size(); j++) {
+        trigrams.insert((static_cast<quint64>(padded[j].unicode()) << 32) |
+                        (static_cast<quint64>(padded[j + 1].unicode()) << 16) | padded[j + 2].unicode());
+    }
+
+    QHash<int, int> shared;
+    for (QSet<quint64>::const_iterator t = trigrams.constBegin(); t != trigrams.constEnd(); ++t) {
+        const QVector<int> postings = m_trigrams.value(*t);
+        for (int i = 0; i < postings.size(); i++) {
+            shared[postings[i]]++;
+        }
+    }
+
+    // most of the query's trigrams must be there, best matches first
+    int                      threshold = qMax(2, (trigrams.size() * 3 + 4) / 5);
+    QVector<QPair<int, int> > ranked;
+    for (QHash<int, int>::const_iterator iter = shared.constBegin(); iter != shared.constEnd(); ++iter) {
+        if (iter.value() >= threshold) ranked.append(qMakePair(-iter.value(), iter.key()));
+    }
+    std::sort(ranked.begin(), ranked.end());
+
+    QVector<int> matches;
+    matches.reserve(ranked.size());
+    for (int i = 0; i < ranked.size(); i++) {
+        matches.append(ranked[i].second);
+    }
+    return matches;
+}
+
+QVector<PlexLibraryIndex::Item> PlexLibraryIndex::search(const QString& query, const QStringList& types,
+                                                          int limitPerType) {
+    if (m_dirty) {
+        rebuild();
+    }
+
+    QStringList queryWords = words(query);
+    if (queryWords.isEmpty()) {
+        return QVector<Item>();
+    }
+
+    QVector<int> matches = prefixMatches(queryWords);
+    if (matches.isEmpty()) {
+        matches = fuzzyMatches(query);  // already ranked
+    } else {
+        // titles starting with the query first, then other title matches, then subtitle only matches
+        QString phrase = " " + queryWords.join(' ');
+        QVector<QPair<QPair<int, int>, int> > ranked;
+        ranked.reserve(matches.size());
+        for (int i = 0; i < matches.size(); i++) {
+            const QString& normalized = m_normalized[matches[i]];
+            QString        title = normalize(m_items[matches[i]].title);
+            int            rank = normalized.startsWith(phrase) ? 0 : (title.contains(queryWords.first()) ? 1 : 2);
+            ranked.append(qMakePair(qMakePair(rank, title.size()), matches[i]));
+        }
+        std::sort(ranked.begin(), ranked.end());
+        for (int i = 0; i < ranked.size(); i++) {
+            matches[i] = ranked[i].second;
+        }
+    }
+
+    QVector<Item>       results;
+    QHash<QString, int> perType;
+    for (int i = 0; i < matches.size(); i++) {
+        const Item& item = m_items[matches[i]];
+        if (!types.isEmpty() && !types.contains(item.type)) continue;
+        int& count = perType[item.type];
+        if (count >= limitPerType) continue;
+        count++;
+        results.append(item);
+    }
+    return results;
+}
+
+QString PlexLibraryIndex::normalize(const QString& text) {
+    // lower case, accents removed, anything that is not a letter or digit separates words
+    QString decomposed = text.normalized(QString::NormalizationForm_KD).toLower();
+    QString result;
+    result.reserve(decomposed.size());
+    for (int i = 0; i < decomposed.size(); i++) {
+        QChar c = decomposed[i];
+        if (c.isLetterOrNumber()) {
+            result.append(c);
+        } else if (!c.isMark() && !result.isEmpty() && !result.endsWith(' ')) {
+            result.append(' ');
+        }
+    }
+    return result.trimmed();
+}
+
+QStringList PlexLibraryIndex::words(const QString& text) { return normalize(text).split(' ', QString::SkipEmptyParts); }
+
+QString PlexLibraryIndex::typeName(int type) {
+    switch (type) {
+        case 1:
+            return "movie";
+        case 2:
+            return "show";
+        case 4:
+            return "episode";
+        case 8:
+            return "artist";
+        case 9:
+            return "album";
+        case 10:
+            return "track";
+        case PLAYLISTS:
+            return "playlist";
+        default:
+            return QString();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PERSISTENCE
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool PlexLibraryIndex::load() {
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0) {
+        return false;
+    }
+    uchar* data = file.map(0, file.size());
+    if (!data) {
+        return false;
+    }
+    QByteArray  raw = QByteArray::fromRawData(reinterpret_cast<const char*>(data), static_cast<int>(file.size()));
+    QDataStream in(raw);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0, version = 0, states = 0, count = 0;
+    in >> magic >> version;
+    if (magic != INDEX_MAGIC || version != INDEX_VERSION) {
+        file.unmap(data);
+        return false;
+    }
+
+    m_state.clear();
+    in >> states;
+    for (quint32 i = 0; i < states && in.status() == QDataStream::Ok; i++) {
+        QString   key;
+        SyncState state;
+        in >> key >> state.count >> state.updatedAt >> state.complete;
+        m_state.insert(key, state);
+    }
+
+    m_items.clear();
+    m_byKey.clear();
+    in >> count;
+    m_items.reserve(static_cast<int>(count));
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+        Item   item;
+        qint32 section = 0;
+        in >> item.ratingKey >> item.type >> item.title >> item.subtitle >> item.thumb >> item.updatedAt >> section;
+        item.section = section;
+        upsert(item);
+    }
+    file.unmap(data);
+
+    if (in.status() != QDataStream::Ok) {
+        m_state.clear();  // truncated: keep the items but load everything again on the next sync
+    }
+    m_dirty = true;
+    return true;
+}
+
+bool PlexLibraryIndex::save() {
+    QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+    QSaveFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << INDEX_MAGIC << INDEX_VERSION;
+
+    out << static_cast<quint32>(m_state.size());
+    for (QHash<QString, SyncState>::const_iterator iter = m_state.constBegin(); iter != m_state.constEnd(); ++iter) {
+        out << iter.key() << iter.value().count << iter.value().updatedAt << iter.value().complete;
+    }
+
+    out << static_cast<quint32>(m_items.size());
+    for (int i = 0; i < m_items.size(); i++) {
+        const Item& item = m_items[i];
+        out << item.ratingKey << item.type << item.title << item.subtitle << item.thumb << item.updatedAt
+            << static_cast<qint32>(item.section);
+    }
+    return file.commit();
+}
@@ -0,0 +1,137 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QQueue>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+#include "plexhttpclient.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMEDIA LIBRARY INDEX
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// On-device index of the library for type-ahead search: artists, albums, tracks, movies, shows, episodes and
+// playlists. Built once from /library/sections/{id}/all, then kept current with updatedAt deltas, and stored on disk.
+// Words are kept in a sorted array for prefix lookups; title trigrams give a fuzzy match when no prefix matches.
+// A section's sync state is only committed once its last page has arrived, and the index is only ready (answers
+// search instead of the server) while every section is complete. An interrupted walk is started again.
+class PlexLibraryIndex : public QObject {
+    Q_OBJECT
+
+ public:
+    // what search results need, with the subtitle already resolved like the server search results are
+    struct Item {
+        QString ratingKey;
+        QString type;
+        QString title;
+        QString subtitle;
+        QString thumb;
+        qint64  updatedAt = 0;
+        int     section = 0;
+    };
+
+    PlexLibraryIndex(PlexHttpClient* http, const QString& fileName, QObject* parent = nullptr);
+
+    void setServer(const QString& serverURL, const QString& token);
+
+    void start();  // synchronise now and then periodically
+    void stop();
+    void sync();     // incremental update, does nothing if one is running
+    void changed();  // the library changed on the server: sync shortly, changes tend to come in bursts
+    bool isReady() const;
+    int  count() const { return m_items.size(); }
+
+    // types are item types (i.e. "album", "track"). Results are ordered best first.
+    QVector<Item> search(const QString& query, const QStringList& types, int limitPerType);
+
+    static Item fromMetadata(const PlexMetadataItem& metadata, int section);
+
+    bool load();
+    bool save();
+
+ signals:
+    void synced();
+
+ private:
+    struct SyncState {
+        qint64 count = 0;         // items of this section and type on the server at the last sync
+        qint64 updatedAt = 0;     // newest updatedAt seen, deltas ask for anything at or after it
+        bool   complete = false;  // the index holds all of it. False until the first walk, and while one reloads it.
+    };
+    struct Job {
+        int    section = 0;
+        int    type = 0;
+        int    start = -1;  // -1: check the total count first
+        qint64 since = 0;   // 0: full load, otherwise updatedAt filter
+        qint64 total = 0;   // count reported by the check, committed with the last page
+        qint64 newest = 0;  // newest updatedAt of the pages so far, committed with the last page
+    };
+
+    void         runNext();
+    void         finishJob();
+    void         checkJob(const Job& job, const PlexMediaContainer& container);
+    void         pageJob(const Job& job, const PlexMediaContainer& container);
+    QUrl         jobUrl(const Job& job) const;
+    QString      stateKey(const Job& job) const;
+    void         upsert(const Item& item);
+    void         removeSection(int section, const QString& type);
+    void         rebuild();
+    QVector<int> prefixMatches(const QStringList& words);
+    QVector<int> fuzzyMatches(const QString& query);
+
+    static QString     normalize(const QString& text);
+    static QStringList words(const QString& text);
+    static QString     typeName(int type);
+
+    PlexHttpClient*           m_http;
+    QString                   m_fileName;
+    QString                   m_serverURL;
+    QString                   m_token;
+    QTimer*                   m_refreshTimer;
+    QTimer*                   m_retryTimer;
+    QTimer*                   m_changeTimer;
+    QQueue<Job>               m_jobs;
+    bool                      m_syncing = false;
+    bool                      m_changed = false;
+    QHash<QString, SyncState> m_state;  // "section:type" -> state
+
+    // the index itself
+    QVector<Item>                 m_items;
+    QHash<QString, int>           m_byKey;  // ratingKey -> position in m_items
+    QVector<QPair<QString, int> > m_words;  // normalized word -> item, sorted by word
+    QHash<quint64, QVector<int> > m_trigrams;
+    QVector<QString>              m_normalized;    // normalized title and subtitle per item
+    bool                          m_dirty = true;  // search structures need a rebuild
+
+    enum {
+        PAGE_SIZE = 1000,
+        REFRESH_INTERVAL = 15 * 60 * 1000,
+        CHANGE_DELAY = 10000,
+        RETRY_DELAY = 60000,
+        PLAYLISTS = 15
+    };
+};
@@ -22,11 +22,17 @@
 
 #include "plexmedia.h"
 
-#include <QJsonArray>
+#include <QDir>
+#include <QFileInfo>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QSaveFile>
+#include <QSharedPointer>
+#include <QStandardPaths>
+#include <QThread>
 
-#include <QtXml/QDomDocument>
+#include "plexjsondecoder.h"
+#include "plextimelinedecoder.h"
 
 PlexMediaPlugin::PlexMediaPlugin() : Plugin("plexmedia", USE_WORKER_THREAD) {}
 
@@ -46,17 +52,150 @@ PlexMedia::PlexMedia(const QVariantMap& config, EntitiesInterface* entities, Not
             QVariantMap map = iter.value().toMap();
             m_clientUser      = map.value("username").toString();
             m_clientPass      = map.value("password").toString();
+            m_authToken       = map.value("auth_token").toString();
             m_entityId        = map.value("entity_id").toString();
             m_serverIP        = map.value("server_address").toString();
             m_serverPort      = map.value("server_port").toString();
+            m_subscriptionMode = map.value("timeline_subscription", false).toBool();
+            m_subscriptionPort = static_cast<quint16>(map.value("subscription_port", 0).toUInt());
+            m_notificationMode = map.value("notifications", false).toBool();
+            m_discoveryMode   = map.value("discovery", true).toBool();
+            m_playerEntityMode = map.value("player_entities", false).toBool();
+            QVariantList servers = map.value("servers").toList();
+            for (int i = 0; i < servers.size(); i++) {
+                QString server = servers[i].toString();
+                if (server.isEmpty()) continue;
+                if (!server.contains(':')) server += ":32400";
+                m_extraServers.append("http://" + server);
+            }
+            m_pollFast        = map.value("poll_interval_fast", 2000).toInt();
+            m_pollSlow        = map.value("poll_interval_slow", 4000).toInt();
+            m_pollMax         = map.value("poll_interval_max", 60000).toInt();
         }
     }
 
     m_serverURL = "http://" + m_serverIP + ":" + m_serverPort;
 
-    m_pollingTimer = new QTimer(this);
-    m_pollingTimer->setInterval(4000);
-    QObject::connect(m_pollingTimer, &QTimer::timeout, this, &PlexMedia::onPollingTimerTimeout);
+    // token and server identity from the last run, so a restart does not have to sign in again
+    m_startupStateFile = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/plexmedia/" +
+                         integrationId() + ".state";
+    m_startupState.load(m_startupStateFile);
+    m_serverDiscovery = m_serverIP.isEmpty() && m_discoveryMode;
+    if (m_serverDiscovery && !QUrl(m_startupState.serverURL).host().isEmpty()) {
+        // the server found on the network last time, until discovery answers again
+        m_serverIP = QUrl(m_startupState.serverURL).host();
+        m_serverPort = QString::number(QUrl(m_startupState.serverURL).port(32400));
+        m_serverURL = m_startupState.serverURL;
+    }
+    if (m_startupState.user != m_clientUser) {
+        m_startupState = PlexStartupState();  // another account
+    } else if (m_startupState.serverURL != m_serverURL) {
+        m_startupState.serverId.clear();  // another server, the token is still good
+        m_startupState.playerPorts.clear();
+        m_startupState.sessions.clear();
+    }
+    m_startupState.user = m_clientUser;
+    m_startupState.serverURL = m_serverURL;
+    m_fixedToken = !m_authToken.isEmpty();
+    if (!m_fixedToken) m_authToken = m_startupState.authToken;
+    m_serverId = m_startupState.serverId;
+
+    // entity calls go through the GUI thread when the integration runs on a worker thread
+    m_dispatcher = new PlexGuiDispatcher();
+    m_entityPresence = QSharedPointer<EntityPresence>(new EntityPresence());
+    m_entityPresence->ids.append(m_entityId);
+
+    // one long-lived client for every request so connections to the server and player are kept alive
+    m_http = new PlexHttpClient(4, this);
+    QObject::connect(
+        m_http->manager(), &QNetworkAccessManager::networkAccessibleChanged, this,
+        [=](QNetworkAccessManager::NetworkAccessibility accessibility) { qCDebug(m_logCategory) << accessibility; });
+
+    // request counts, latency and failures per endpoint. Kept as a file so they can be looked at while running.
+    m_metricsFile = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/plexmedia/" + integrationId() +
+                    ".metrics.json";
+    m_metricsTimer = new QTimer(this);
+    m_metricsTimer->setInterval(METRICS_INTERVAL);
+    QObject::connect(m_metricsTimer, &QTimer::timeout, this, &PlexMedia::saveMetrics);
+
+    // player commands, in order and with bursts merged. Straight to the player once its control port is known,
+    // otherwise the server relays them to it (X-Plex-Target-Client-Identifier).
+    m_commands = new PlexCommandQueue(
+        [=](const QString& path, const QString& params, PlexCommandQueue::Route* route) {
+            if (!player().port.isEmpty() && player().port != "0") {
+                *route = PlexCommandQueue::DIRECT;
+                return getRequest(player().url + path, params);
+            }
+            *route = PlexCommandQueue::RELAYED;
+            return getRequest((player().session.server.isEmpty() ? m_serverURL : player().session.server) + path,
+                              params);
+        },
+        this);
+
+    m_pollScheduler = new PlexPollScheduler(this);
+    m_pollScheduler->setIntervals(m_pollFast, m_pollSlow, m_pollMax);
+    m_pollScheduler->setDeadline(REQUEST_TIMEOUT);
+    QObject::connect(m_pollScheduler, &PlexPollScheduler::tick, this, &PlexMedia::onPollingTimerTimeout);
+
+    // progress is ticked locally and corrected by each poll, so it moves smoothly at any polling rate
+    m_progressClock = new PlexProgressClock(this);
+    QObject::connect(m_progressClock, &PlexProgressClock::progressChanged, this,
+                     [=](int seconds) { m_entityState->update(MediaPlayerDef::MEDIAPROGRESS, seconds); });
+
+    // entity attributes are only written when they change, in one batch per event loop pass
+    m_entityState = new PlexEntityState(this);
+    bindEntityState(m_entityState, m_entityId);
+
+    traceEntityUpdates(m_commands, m_entityState);
+
+    m_metadataCache = new PlexMetadataCache(
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/plexmedia/" + integrationId() + ".cache",
+        4 * 1024 * 1024, this);
+    m_metadataCache->load();
+
+    // one directory per integration, each keeps its own index and evicts only its own files
+    QString cacheRoot = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/plexmedia/";
+    m_artwork = new PlexArtwork(m_http, cacheRoot + integrationId() + ".artwork", 32 * 1024 * 1024, this);
+    m_artwork->setServer(m_serverURL, m_authToken);
+    m_artwork->load();
+    QObject::connect(m_artwork, &PlexArtwork::cached, this, [=](const QString& thumb, int size) {
+        if (size == PlexArtwork::ARTWORK && thumb == m_playerThumb) showArtwork(thumb);  // now a local file
+    });
+
+    m_libraryIndex = new PlexLibraryIndex(
+        m_http, QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/plexmedia/" + integrationId() + ".index",
+        this);
+    m_libraryIndex->setServer(m_serverURL, m_authToken);
+    m_libraryIndex->load();
+
+    m_searchTimer = new QTimer(this);
+    m_searchTimer->setSingleShot(true);
+    m_searchTimer->setInterval(SEARCH_DEBOUNCE);
+    QObject::connect(m_searchTimer, &QTimer::timeout, this, &PlexMedia::onSearchTimerTimeout);
+
+    // pushed player timeline (opt-in). Renewed every 30 seconds, the player is polled until its pushes arrive.
+    m_subscription = new PlexTimelineSubscription(
+        [=](const QString& url, const QString& params) { return getRequest(url, params); }, this);
+    m_subscription->setIntervals(30000, TIMELINE_PUSH_TIMEOUT, TIMELINE_BACKOFF);
+    QObject::connect(m_subscription, &PlexTimelineSubscription::timelineReceived, this, &PlexMedia::onTimelineReceived);
+    QObject::connect(m_subscription, &PlexTimelineSubscription::fellBack, this, [=](const QString& reason) {
+        qCWarning(m_logCategory) << reason << ", polling instead.";
+    });
+
+    // server notifications (opt-in). Session changes are pushed instead of downloading /status/sessions.
+    m_notifications = new PlexNotificationClient(this);
+    QObject::connect(m_notifications, &PlexNotificationClient::connected, this, &PlexMedia::onNotificationsConnected);
+    QObject::connect(m_notifications, &PlexNotificationClient::disconnected, this,
+                     &PlexMedia::onNotificationsDisconnected);
+    QObject::connect(m_notifications, &PlexNotificationClient::playSessionStateChanged, this,
+                     &PlexMedia::onPlaySessionStateChanged);
+    QObject::connect(m_notifications, &PlexNotificationClient::timelineChanged, this,
+                     &PlexMedia::onLibraryTimelineChanged);
+
+    // players and servers on the local network. Gives the player's control port without asking the server.
+    m_discovery = new PlexDiscovery(this);
+    QObject::connect(m_discovery, &PlexDiscovery::playerFound, this, &PlexMedia::onPlayerDiscovered);
+    QObject::connect(m_discovery, &PlexDiscovery::serverFound, this, &PlexMedia::onServerDiscovered);
 
     // add available entity
     QStringList supportedFeatures;
@@ -86,34 +225,199 @@ PlexMedia::PlexMedia(const QVariantMap& config, EntitiesInterface* entities, Not
                       << "SPEAKER_CONTROL"
                       << "LIST";
     addAvailableEntity(m_entityId, "media_player", integrationId(), friendlyName(), supportedFeatures);
+
+    // one more entity for each player seen before, it shows and controls that player only
+    if (m_playerEntityMode) {
+        QStringList playerFeatures;
+        playerFeatures << "SOURCE"
+                       << "VOLUME"
+                       << "VOLUME_SET"
+                       << "MEDIA_TITLE"
+                       << "MEDIA_ARTIST"
+                       << "MEDIA_DURATION"
+                       << "MEDIA_POSITION"
+                       << "MEDIA_IMAGE"
+                       << "PLAY"
+                       << "PAUSE"
+                       << "STOP"
+                       << "PREVIOUS"
+                       << "NEXT";
+        for (QHash<QString, QString>::const_iterator iter = m_startupState.players.constBegin();
+             iter != m_startupState.players.constEnd(); ++iter) {
+            QString          entityId = m_entityId + "." + iter.key();
+            PlexEntityState* state = new PlexEntityState(this);
+            bindEntityState(state, entityId);
+            m_playerEntities.insert(entityId, iter.key());
+            m_entityPresence->ids.append(entityId);
+            m_playerEntityStates.insert(entityId, state);
+            addAvailableEntity(entityId, "media_player", integrationId(), iter.value(), playerFeatures);
+        }
+    }
+}
+
+void PlexMedia::bindEntityState(PlexEntityState* state, const QString& entityId) {
+    QObject::connect(state, &PlexEntityState::changed, this, [=](const PlexEntityState::Attributes& attributes) {
+        if (!hasEntity(entityId)) {
+            state->invalidate();  // nothing was written, send everything again once the entity is back
+            return;
+        }
+        EntitiesInterface* entities = m_entities;
+        m_dispatcher->post([entities, entityId, attributes]() {
+            EntityInterface* entity = static_cast<EntityInterface*>(entities->getEntityInterface(entityId));
+            if (!entity) {
+                return;
+            }
+            for (PlexEntityState::Attributes::const_iterator iter = attributes.constBegin();
+                 iter != attributes.constEnd(); ++iter) {
+                entity->updateAttrByIndex(iter.key(), iter.value());
+            }
+        });
+    });
+}
+
+// a command trace ends once the entity shows the report that ended it. The report's attributes, if it changed any,
+// go out with the next flush of the entity state; the mark is posted after them, so the GUI thread takes its time
+// once they are written.
+void PlexMedia::traceEntityUpdates(PlexCommandQueue* commands, PlexEntityState* state) {
+    QObject::connect(commands, &PlexCommandQueue::observed, state, &PlexEntityState::requestFlush);
+    QObject::connect(state, &PlexEntityState::flushed, this, [=]() {
+        if (!commands->waitingForEntity()) {
+            return;
+        }
+        QPointer<PlexCommandQueue> queue = commands;
+        m_dispatcher->post([queue]() {
+            QElapsedTimer clock;
+            clock.start();
+            qint64 at = clock.msecsSinceReference();
+            if (queue) {
+                QMetaObject::invokeMethod(queue, [queue, at]() {
+                    if (queue) queue->entityUpdated(at);
+                }, Qt::QueuedConnection);
+            }
+        });
+    });
+}
+
+PlexMedia::~PlexMedia() { m_dispatcher->deleteLater(); }  // not ours to delete directly, it lives on the GUI thread
+
+void PlexMedia::refreshEntities() {
+    EntitiesInterface*             entities = m_entities;
+    QSharedPointer<EntityPresence> presence = m_entityPresence;
+    m_dispatcher->post([entities, presence]() {
+        QSet<QString> present;
+        for (int i = 0; i < presence->ids.size(); i++) {
+            if (entities->getEntityInterface(presence->ids[i])) present.insert(presence->ids[i]);
+        }
+        QMutexLocker locker(&presence->mutex);
+        presence->present = present;
+    });
+}
+
+bool PlexMedia::hasEntity(const QString& entityId) const {
+    QMutexLocker locker(&m_entityPresence->mutex);
+    return m_entityPresence->present.contains(entityId);
+}
+
+bool PlexMedia::hasEntities() const {
+    QMutexLocker locker(&m_entityPresence->mutex);
+    return !m_entityPresence->present.isEmpty();
 }
 
 void PlexMedia::connect() {
+    refreshEntities();  // called on the GUI thread, so known before the snapshot below is shown
+    if (QThread::currentThread() != thread()) {  // worker thread mode, all integration state lives on the worker
+        QMetaObject::invokeMethod(this, "connect", Qt::QueuedConnection);
+        return;
+    }
     qCDebug(m_logCategory) << "STARTING PLEXMEDIA";
     setState(CONNECTED);
+    m_connectTimer.start();
+    m_nowPlayingReported = false;
+
+    // show the last known sessions straight away, the first live fetch below corrects them
+    PlexMediaContainer snapshot;
+    if (playerId().isEmpty() && !m_startupState.sessions.isEmpty() &&
+        PlexJsonDecoder::decode(m_startupState.sessions, &snapshot)) {
+        updateSessions(snapshot.sessions);
+        qCDebug(m_logCategory) << "Session snapshot shown" << m_connectTimer.elapsed() << "ms after connect";
+    }
+
+    if (m_discoveryMode && !m_discovery->start()) {
+        qCWarning(m_logCategory) << "Local network discovery is not available";
+    }
 
+    // sign-in, identity and the first sessions fetch run side by side. Requests wait for the token if needed.
     // get auth token if we don't have it already
     if (m_authToken.isNull() || m_authToken.isEmpty()) {
         qCDebug(m_logCategory) << "Requesting auth token...";
         requestAuthToken();
+    } else if (!m_serverIP.isEmpty()) {  // otherwise started once discovery finds the server
+        openNotifications();
+        m_libraryIndex->start();
     }
 
     //get server id if we don't have it already
-    if (m_serverId.isNull() || m_serverId.isEmpty()) {
+    if ((m_serverId.isNull() || m_serverId.isEmpty()) && !m_serverIP.isEmpty()) {
         qCDebug(m_logCategory) << "Requesting server Id...";
         getMachineIdentifier();
     }
 
     // start polling
-    m_pollingTimer->start();
+    getCurrentPlayer();
+    m_pollScheduler->start();
+    m_metricsTimer->start();
+    if (m_subscriptionMode && !m_subscription->start(m_subscriptionPort)) {
+        qCWarning(m_logCategory) << "Cannot open timeline listener on port" << m_subscriptionPort << ", polling instead.";
+    }
 }
 
 void PlexMedia::disconnect() {
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, "disconnect", Qt::QueuedConnection);
+        return;
+    }
     setState(DISCONNECTED);
-    putRequest(m_playerURL + "/player/timeline/unsubscribe",""); // unsubscribe so player resets commandId counter (otherwise would be 90secs).
+    qCDebug(m_logCategory) << "HTTP connections reused:" << m_http->reusedConnections()
+                           << "new:" << m_http->newConnections();
+    putRequest(player().url + "/player/timeline/unsubscribe",""); // unsubscribe so player resets commandId counter (otherwise would be 90secs).
     m_cmdId = 0; // reset our own counter
-    m_directConn = false; // reset connection to check if player still exists on reconnect.
-    m_pollingTimer->stop();
+    player().directConn = false; // reset connection to check if player still exists on reconnect.
+    qCDebug(m_logCategory) << "Polling stats:" << m_pollScheduler->stats();
+    qCDebug(m_logCategory) << "Replies slower than" << SLOW_REPLY << "ms to handle:" << m_slowReplies;
+    m_metricsTimer->stop();
+    saveMetrics();
+    qCDebug(m_logCategory) << "Request metrics:" << m_metricsFile << m_http->metrics().requests() << "requests";
+    m_pollScheduler->stop();
+    qCDebug(m_logCategory) << "Player commands:" << m_commands->stats();
+    m_commands->clear();
+    for (PlexCommandQueue* commands : m_playerCommands) {
+        commands->clear();
+    }
+    m_progressClock->reset();
+    qCDebug(m_logCategory) << "Entity updates emitted:" << m_entityState->emittedUpdates()
+                           << "suppressed:" << m_entityState->suppressedUpdates();
+    m_entityState->invalidate();
+    for (PlexEntityState* state : m_playerEntityStates) {
+        state->invalidate();
+    }
+    qCDebug(m_logCategory) << "Metadata cache hits:" << m_metadataCache->hits() << "misses:" << m_metadataCache->misses()
+                           << "entries:" << m_metadataCache->count();
+    m_metadataCache->save();
+    saveStartupState();
+    qCDebug(m_logCategory) << "Artwork cache:" << m_artwork->stats();
+    m_artwork->save();
+    m_libraryIndex->stop();
+    m_searchTimer->stop();
+    cancelSearch();
+    qCDebug(m_logCategory) << "GUI thread batches:" << m_dispatcher->batches() << "calls:" << m_dispatcher->tasks();
+    qCDebug(m_logCategory) << "Search queries issued:" << m_searchesIssued << "cancelled:" << m_searchesCancelled
+                           << "stale:" << m_searchesStale;
+    qCDebug(m_logCategory) << "Timeline subscription fell back to polling" << m_subscription->fallbacks() << "times";
+    m_subscription->stop();
+    m_notifications->close();
+    m_sessionsStale = true;
+    qCDebug(m_logCategory) << "Discovery:" << m_discovery->stats();
+    m_discovery->stop();
 }
 
 void PlexMedia::enterStandby() { disconnect(); } //stop polling on disconnect
@@ -121,575 +425,559 @@ void PlexMedia::enterStandby() { disconnect(); } //stop polling on disconnect
 void PlexMedia::leaveStandby() { connect(); }
 
 void PlexMedia::requestAuthToken() {
-    QNetworkAccessManager* manager = new QNetworkAccessManager(this);
-    QNetworkRequest        request;
+    QNetworkRequest request;
 
-    QObject* context = new QObject(this); // set up connection to slots on "this" object.
-    QObject::connect(manager, &QNetworkAccessManager::finished, context, [=](QNetworkReply* reply) {
-        if (reply->error()) {
-            qCWarning(m_logCategory) << reply->errorString();
-        }
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
 
-        QString answer = reply->readAll();
+    QString header_auth;
+    header_auth.append(m_clientUser).append(":").append(m_clientPass);
 
-        // convert to json
-        QJsonParseError parseerror;
-        QJsonDocument   doc = QJsonDocument::fromJson(answer.toUtf8(), &parseerror);
-        if (parseerror.error != QJsonParseError::NoError) {
-            qCWarning(m_logCategory) << "JSON error : " << parseerror.errorString();
-            return;
-        }
-        QVariantMap map = doc.toVariant().toMap();
+    request.setRawHeader("Authorization", "Basic " + header_auth.toUtf8().toBase64());
+
+    request.setRawHeader("X-Plex-Client-Identifier", m_remoteId);
+    request.setRawHeader("X-Plex-Device", m_remoteSys);
+    request.setRawHeader("X-Plex-Device-Name", m_remoteName);
 
+    request.setUrl(QUrl::fromUserInput("https://plex.tv/users/sign_in.json"));
+
+    // have to sign in with post. Only one sign-in at a time, everything else waits for it.
+    if (!m_authRequest.isNull()) {
+        return;
+    }
+    m_authRequest = m_http->post(request, "")->setTimeout(REQUEST_TIMEOUT);
+    m_authRequest->onError(this, [=](const QString& error) {
+        qCWarning(m_logCategory) << error;
+        m_http->discard("Sign-in failed: " + error);
+    });
+    m_authRequest->thenJson(this, [=](const QVariantMap& map) {
         if (map.contains("error")) {
              qCWarning(m_logCategory) << "Error: " << map.value("error").toString();
+             m_http->discard("Sign-in failed");
              //display notification, likely user/pass is incorrect.
         } else {
             // store the auth token
             if (map.value("user").toMap().contains("authToken")) {
                 m_authToken =  map.value("user").toMap().value("authToken").toString();
-                qCDebug(m_logCategory) << "Plex user auth token: " << m_authToken;
+                m_tokenVerified = true;
+                qCDebug(m_logCategory) << "Plex user auth token received after" << m_connectTimer.elapsed() << "ms";
+                m_startupState.authToken = m_authToken;
+                saveStartupState();
+                m_http->release("X-Plex-Token", m_authToken.toLocal8Bit());
+                m_artwork->setServer(m_serverURL, m_authToken);
+                m_libraryIndex->setServer(m_serverURL, m_authToken);
+                if (!m_serverIP.isEmpty()) {
+                    openNotifications();
+                    m_libraryIndex->start();
+                }
             } else {
                 qCDebug(m_logCategory) << "Cannot find authToken?";
+                m_http->discard("Sign-in returned no token");
                 //other errors?
             }
         }
-
-        reply->deleteLater();
-        context->deleteLater();
-        manager->deleteLater();
     });
-
-    QObject::connect(
-        manager, &QNetworkAccessManager::networkAccessibleChanged, context,
-        [=](QNetworkAccessManager::NetworkAccessibility accessibility) { qCDebug(m_logCategory) << accessibility; });
-
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
-
-    QString header_auth;
-    header_auth.append(m_clientUser).append(":").append(m_clientPass);
-
-    request.setRawHeader("Authorization", "Basic " + header_auth.toUtf8().toBase64());
-
-    request.setRawHeader("X-Plex-Client-Identifier", m_remoteId);
-    request.setRawHeader("X-Plex-Device", m_remoteSys);
-    request.setRawHeader("X-Plex-Device-Name", m_remoteName);
-
-    request.setUrl(QUrl::fromUserInput("https://plex.tv/users/sign_in.json"));
-
-    manager->post(request, ""); // have to sign in with post
 }
 
 void PlexMedia::getMachineIdentifier() {
     QString url = m_serverURL + "/identity";
 
-    QObject* context = new QObject(this);
-    QObject::connect(this, &PlexMedia::requestReady, context, [=](const QVariantMap& map, const QString& rUrl) {
-        if (rUrl == url) { 
-            if (map.value("MediaContainer").toMap().contains("machineIdentifier")) {
-                m_serverId = map.value("MediaContainer").toMap().value("machineIdentifier").toString();
-                qCDebug(m_logCategory) << "machineIdentifier: " << m_serverId;
-            } else {
-                qCWarning(m_logCategory) << "machineIdentifier not found!";
-                //QMap<QString, QVariant>::const_iterator i = map.constBegin();
-                //while (i != map.constEnd()){
-                    //qCWarning(m_logCategory) << i.key() << ": " << i.value();
-                    //i++;
-                //}
-            }
+    getRequest(url, "")->then(this, [=](const PlexMediaContainer& container) {
+        if (!container.machineIdentifier.isEmpty()) {
+            m_serverId = container.machineIdentifier;
+            qCDebug(m_logCategory) << "machineIdentifier: " << m_serverId;
+            m_startupState.serverId = m_serverId;
+            saveStartupState();
+        } else {
+            qCWarning(m_logCategory) << "machineIdentifier not found!";
         }
-        context->deleteLater();
     });
-    getRequest(url,"");
+}
+
+void PlexMedia::saveStartupState() {
+    if (!m_startupState.save(m_startupStateFile)) {
+        qCWarning(m_logCategory) << "Cannot save startup state to" << m_startupStateFile;
+    }
+}
+
+void PlexMedia::saveMetrics() {
+    QDir().mkpath(QFileInfo(m_metricsFile).absolutePath());
+    QSaveFile file(m_metricsFile);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QJsonObject metrics = m_http->metrics().toJson();
+    metrics.insert("commands", QJsonObject::fromVariantMap(m_commands->stats()));  // press to entity, per command
+    file.write(QJsonDocument(metrics).toJson(QJsonDocument::Indented));
+    if (!file.commit()) {
+        qCWarning(m_logCategory) << "Cannot save request metrics to" << m_metricsFile;
+    }
 }
 
 void PlexMedia::search(QString query) { search(query, ""); } // search all
 void PlexMedia::search(QString query, QString type) {
-    QString url = m_serverURL + "/search";
+    // a new query supersedes whatever is still running for the previous one
+    m_searchGeneration++;
+    m_searchTimer->stop();
+    cancelSearch();
+
+    //convert type to item types
+    QStringList types;
+    if (type.contains("albums")) {       types << "album"; }
+    if (type.contains("tracks")) {       types << "track"; }
+    if (type.contains("artists")) {      types << "artist"; }
+    if (type.contains("playlists")) {    types << "playlist"; }
+    if (type.contains("movies")) {       types << "movie"; }
+    if (type.contains("shows")) {        types << "show"; }
+    if (type.contains("episodes")) {     types << "episode"; }
+
+    // answer from the local index when it has been built, no round trip per keystroke
+    if (m_libraryIndex->isReady()) {
+        QElapsedTimer timer;
+        timer.start();
+        QVector<PlexLibraryIndex::Item> results = m_libraryIndex->search(query, types, SEARCH_LIMIT);
+        if (!results.isEmpty()) {
+            qCDebug(m_logCategory) << "Index search:" << results.size() << "results in" << timer.nsecsElapsed() / 1000
+                                   << "us";
+            publishSearch(results);
+            return;
+        }
+    }
 
-    query.replace(" ", "%20");
+    // the server is only asked once typing pauses
+    m_searchQuery = query;
+    m_searchType = type;
+    m_searchTimer->start();
+}
 
-    QObject* context = new QObject(this);
-    QObject::connect(this, &PlexMedia::requestReady, context, [=](const QVariantMap& map, const QString& rUrl) {
-        if (rUrl == url) {  // parse the search response
-
-            //create the response groupings
-            SearchModelList* albums = new SearchModelList();
-            SearchModelList* tracks = new SearchModelList();
-            SearchModelList* artists = new SearchModelList();
-            SearchModelList* playlists = new SearchModelList();
-            SearchModelList* movies = new SearchModelList();
-            SearchModelList* shows = new SearchModelList();
-            SearchModelList* episodes = new SearchModelList();
-
-            QString itemType;
-            QString id;
-            QString title;
-            QString subtitle;
-            QString image;
-            QStringList commands = {"PLAY", "SHUFFLE", "QUEUE"};  // default
-
-            QVariantList results = map.value("MediaContainer").toMap().value("Metadata").toList();
-            for (int i = 0; i < results.length(); i++) {
-                id = results[i].toMap().value("ratingKey").toString();
-
-                title = results[i].toMap().value("title").toString();
-                if (title.length() == 0) { title = results[i].toMap().value("titleSort").toString(); }
-
-                itemType = results[i].toMap().value("type").toString();
-
-                if (itemType == "album") {
-                    subtitle = results[i].toMap().value("parentTitle").toString();
-                    QStringList commands = {"PLAY", "SHUFFLE", "QUEUE"};
-                } else if (itemType == "track") {
-                    if (results[i].toMap().contains("originalTitle")) subtitle = results[i].toMap().value("originalTitle").toString();
-                    else subtitle = results[i].toMap().value("grandparentTitle").toString();
-                    QStringList commands = {"PLAY", "QUEUE"};
-                } else if (itemType == "episode") {
-                    subtitle = results[i].toMap().value("grandparentTitle").toString()
-                                    + " - " + results[i].toMap().value("parentTitle").toString();
-                    QStringList commands = {"PLAY", "QUEUE"};
-                } else if (itemType == "playlist") {
-                    subtitle = results[i].toMap().value("playlistType").toString();
-                    QStringList commands = {"PLAY", "SHUFFLE"};
-                } else {
-                    subtitle = "";
-                }
-                if (results[i].toMap().contains("thumb")) {
-                    image = results[i].toMap().value("thumb").toString();
-                } else if (results[i].toMap().contains("grandparentThumb")) {
-                    image = results[i].toMap().value("grandparentThumb").toString();
-                } else {
-                    image = ""; // no images for some entries
-                }
-                SearchModelListItem item = SearchModelListItem(id, itemType, title, subtitle, image, commands);
-                if (itemType == "album") {              albums->append(item);
-                } else if (itemType == "track") {       tracks->append(item);
-                } else if (itemType == "artist") {      artists->append(item);
-                } else if (itemType == "playlist") {    playlists->append(item);
-                } else if (itemType == "movie") {       movies->append(item);
-                } else if (itemType == "show") {        shows->append(item);
-                } else if (itemType == "episode") {     episodes->append(item); }
-            }
+void PlexMedia::onSearchTimerTimeout() {
+    QString url = m_serverURL + "/search";
+    QString query = m_searchQuery;
+    QString type = m_searchType;
 
-            //change search items based on content
-            SearchModelItem* ialbums    = new SearchModelItem("albums", albums);
-            SearchModelItem* itracks    = new SearchModelItem("tracks", tracks);
-            SearchModelItem* iartists   = new SearchModelItem("artists", artists);
-            SearchModelItem* iplaylists = new SearchModelItem("playlists", playlists);
-            SearchModelItem* imovies    = new SearchModelItem("movies",movies);
-            SearchModelItem* ishows     = new SearchModelItem("shows", shows);
-            SearchModelItem* iepisodes  = new SearchModelItem("episodes", episodes);
-
-            SearchModel* m_model = new SearchModel();
-
-            m_model->append(ialbums);
-            m_model->append(itracks);
-            m_model->append(iartists);
-            m_model->append(iplaylists);
-            m_model->append(imovies);
-            m_model->append(ishows);
-            m_model->append(iepisodes);
-
-            // update the entity
-            EntityInterface* entity = static_cast<EntityInterface*>(m_entities->getEntityInterface(m_entityId));
-            if (entity) {
-                MediaPlayerInterface* me = static_cast<MediaPlayerInterface*>(entity->getSpecificInterface());
-                me->setSearchModel(m_model);
-            }
-        }
-        context->deleteLater();
-    });
+    query.replace(" ", "%20");
 
-    //convert type to integer
+    //convert type to integer. Episodes are asked for separately: long episode lists are slow and should not hold
+    //back the other groups.
     QString newType="";
+    QString episodeType="";
     if (type.contains("albums")) {       newType += "9,"; } //albums and tv shows
     if (type.contains("tracks")) {       newType += "10,"; } //tracks, episodes and movies
     if (type.contains("artists")) {      newType += "8,"; }
     if (type.contains("playlists")) {    newType += "15,"; } //can only play audio playlists at the moment... maybe limit results to audio only in search?
     if (type.contains("movies")) {       newType += "1,"; }
     if (type.contains("shows")) {        newType += "2,"; }
-    if (type.contains("episodes")) {     newType += "4,"; }
+    if (type.contains("episodes")) {     episodeType = "4"; }
     if (newType.length() > 0) {          newType = newType.left(newType.length()-1); }
-    else {                               newType = "1,2,4,8,9,10,15"; } //I have intentionally limited this to stuff that I've coded the controller to handle (i.e. not podcasts)
+    else if (episodeType.isEmpty()) {    newType = "1,2,8,9,10,15"; episodeType = "4"; } //I have intentionally limited this to stuff that I've coded the controller to handle (i.e. not podcasts)
+
+    QStringList groups;
+    if (!newType.isEmpty()) groups << newType;
+    if (!episodeType.isEmpty()) groups << episodeType;
+
+    // each group is published as soon as it arrives, replies for an older query are dropped
+    m_searchResults.clear();
+    quint32 generation = m_searchGeneration;
+    for (int i = 0; i < groups.size(); i++) {
+        m_searchesIssued++;
+        PlexRequest* request = getRequest(url, "?query=" + query + "&type=" + groups[i]);
+        m_searchRequests.append(request);
+        request->then(this, [=](const PlexMediaContainer& container) {
+            if (generation != m_searchGeneration) {
+                m_searchesStale++;
+                return;
+            }
+            for (int j = 0; j < container.metadata.size(); j++) {
+                m_searchResults.append(PlexLibraryIndex::fromMetadata(container.metadata[j], 0));
+            }
+            publishSearch(m_searchResults);
+        });
+    }
+}
+
+void PlexMedia::cancelSearch() {
+    for (int i = 0; i < m_searchRequests.size(); i++) {
+        if (!m_searchRequests[i].isNull() && !m_searchRequests[i]->isFinished()) {
+            m_searchRequests[i]->abort();
+            m_searchesCancelled++;
+        }
+    }
+    m_searchRequests.clear();
+}
+
+void PlexMedia::publishSearch(const QVector<PlexLibraryIndex::Item>& results) {
+    //create the response groupings
+    SearchModelList* albums = new SearchModelList();
+    SearchModelList* tracks = new SearchModelList();
+    SearchModelList* artists = new SearchModelList();
+    SearchModelList* playlists = new SearchModelList();
+    SearchModelList* movies = new SearchModelList();
+    SearchModelList* shows = new SearchModelList();
+    SearchModelList* episodes = new SearchModelList();
+
+    for (int i = 0; i < results.size(); i++) {
+        const PlexLibraryIndex::Item& result = results[i];
+
+        QStringList commands = {"PLAY", "SHUFFLE", "QUEUE"};  // default
+        if (result.type == "track" || result.type == "episode") {
+            commands = QStringList({"PLAY", "QUEUE"});
+        } else if (result.type == "playlist") {
+            commands = QStringList({"PLAY", "SHUFFLE"});
+        }
+        QString             image = m_artwork->url(result.thumb, PlexArtwork::THUMBNAIL);
+        SearchModelListItem item = SearchModelListItem(result.ratingKey, result.type, result.title, result.subtitle,
+                                                       image, commands);
+        if (result.type == "album") {              albums->append(item);
+        } else if (result.type == "track") {       tracks->append(item);
+        } else if (result.type == "artist") {      artists->append(item);
+        } else if (result.type == "playlist") {    playlists->append(item);
+        } else if (result.type == "movie") {       movies->append(item);
+        } else if (result.type == "show") {        shows->append(item);
+        } else if (result.type == "episode") {     episodes->append(item); }
+    }
+
+    //change search items based on content
+    SearchModelItem* ialbums    = new SearchModelItem("albums", albums);
+    SearchModelItem* itracks    = new SearchModelItem("tracks", tracks);
+    SearchModelItem* iartists   = new SearchModelItem("artists", artists);
+    SearchModelItem* iplaylists = new SearchModelItem("playlists", playlists);
+    SearchModelItem* imovies    = new SearchModelItem("movies",movies);
+    SearchModelItem* ishows     = new SearchModelItem("shows", shows);
+    SearchModelItem* iepisodes  = new SearchModelItem("episodes", episodes);
+
+    SearchModel* m_model = new SearchModel();
+
+    m_model->append(ialbums);
+    m_model->append(itracks);
+    m_model->append(iartists);
+    m_model->append(iplaylists);
+    m_model->append(imovies);
+    m_model->append(ishows);
+    m_model->append(iepisodes);
+
+    m_dispatcher->adopt(albums);
+    m_dispatcher->adopt(tracks);
+    m_dispatcher->adopt(artists);
+    m_dispatcher->adopt(playlists);
+    m_dispatcher->adopt(movies);
+    m_dispatcher->adopt(shows);
+    m_dispatcher->adopt(episodes);
+    m_dispatcher->adopt(m_model);
+
+    // update the entity
+    EntitiesInterface* entities = m_entities;
+    QString            entityId = m_entityId;
+    m_dispatcher->post([entities, entityId, m_model]() {
+        EntityInterface* entity = static_cast<EntityInterface*>(entities->getEntityInterface(entityId));
+        if (entity) {
+            MediaPlayerInterface* me = static_cast<MediaPlayerInterface*>(entity->getSpecificInterface());
+            me->setSearchModel(m_model);
+        }
+    });
+}
+
+// paged browse ids are "<id>@<start>". Returns the start and strips it from the id.
+static int splitPage(QString* id) {
+    int at = id->lastIndexOf('@');
+    if (at < 0) {
+        return 0;
+    }
+    int start = id->mid(at + 1).toInt();
+    id->truncate(at);
+    return start;
+}
 
-    getRequest(url, "?query=" + query + "&type=" + newType);
+static QString pageParams(int start, int size) {
+    return "?X-Plex-Container-Start=" + QString::number(start) + "&X-Plex-Container-Size=" + QString::number(size);
+}
+
+static QString pageRange(int start, int count, qint64 total) {
+    return "Items " + QString::number(start + 1) + "-" + QString::number(start + count) + " of " +
+           QString::number(total);
 }
 
 void PlexMedia::getAlbum(QString id) {
+    int start = splitPage(&id);
+    if (start > 0) {
+        getEpisodes(id, start);  // a further page of a show's episodes
+        return;
+    }
+
     QString url = m_serverURL + "/library/metadata/" + id + "/children";
 
-    QString subtitle = "";
-    QString type = "album";
-    QString sub_type = "track";
-
-    QObject* context = new QObject(this);
-    QObject::connect(this, &PlexMedia::requestReady, context, [=](const QVariantMap& map, const QString& rUrl) {
-        if (rUrl == url) {
-            qCDebug(m_logCategory) << "GET ALBUM/SHOW";
-            QVariantMap album = map.value("MediaContainer").toMap();
-            QString id       = album.value("key").toString();
-            QString title    = album.value("parentTitle").toString();
-            if (album.value("viewGroup").toString() == "season") {
-                QString subtitle = album.value("size").toString() + " season(s)";
-                QString type     = "show";
-                QString sub_type = "episode";
-            } else {
-                QString subtitle = album.value("grandparentTitle").toString();
-                QString type     = "album";
-                QString sub_type = "track";
-            }
-            QString image    = "";
-            if (album.contains("thumb")) {
-                image = album.value("thumb").toString();
-            } else if (album.contains("grandparentThumb")) {
-                image = album.value("grandparentThumb").toString();
-            }
+    getCachedRequest(url, "", [=](const PlexMediaContainer& album) {
+        qCDebug(m_logCategory) << "GET ALBUM/SHOW";
+        if (album.viewGroup == "season") {
+            // as we can only go one level deep at the minute need to make a master list of all episodes. we can go to the allLeaves endpoint for this.
+            getEpisodes(album.key, 0);
+            return;
+        }
 
-            QStringList commands = {"PLAY", "QUEUE"};
-
-            BrowseModel* thisAlbum = new BrowseModel(nullptr, id, title, subtitle, type, image, commands);
-
-            if (type == "show") {
-                // as we can only go one level deep at the minute need to make a master list of all episodes. we can go to the allLeaves endpoint for this.
-                QString episodes_url = m_serverURL + "/library/metadata/" + id + "/allLeaves";
-                QObject* sub_context = new QObject(this);
-                QObject::connect(this, &PlexMedia::requestReady, sub_context, [=](const QVariantMap& map, const QString& rUrl) {
-                    if (rUrl == episodes_url) {
-                        // add episodes to show
-                        QVariantList episodes = map.value("MediaContainer").toMap().value("Metadata").toList();
-                        for (int i = 0; i < episodes.length(); i++) {
-                            thisAlbum->addItem(episodes[i].toMap().value("ratingKey").toString(),
-                                           episodes[i].toMap().value("title").toString(),
-                                           episodes[i].toMap().value("grandparentTitle").toString() + " - "  + episodes[i].toMap().value("parentTitle").toString(),
-                                           sub_type,
-                                           m_serverURL + episodes[i].toMap().value("thumb").toString(),
-                                           commands);
-                        }
+        QString id       = album.key;
+        QString title    = album.parentTitle;
+        QString subtitle = album.grandparentTitle;
+        QString type     = "album";
+        QString sub_type = "track";
+        QString image =
+            m_artwork->url(album.thumb.isEmpty() ? album.grandparentThumb : album.thumb, PlexArtwork::ARTWORK);
 
-                    }
-                    sub_context->deleteLater();
-                });
-                getRequest(episodes_url, "");
-            } else {
-                // add tracks to album
-                QVariantList tracks = map.value("MediaContainer").toMap().value("Metadata").toList();
-                for (int i = 0; i < tracks.length(); i++) {
-                    thisAlbum->addItem(tracks[i].toMap().value("ratingKey").toString(),
-                                   tracks[i].toMap().value("title").toString(),
-                                   tracks[i].toMap().value("grandparentTitle").toString(),
-                                   sub_type,
-                                   m_serverURL + tracks[i].toMap().value("parentThumb").toString(),
-                                   commands);
-                }
-            }
+        QStringList commands = {"PLAY", "QUEUE"};
+
+        BrowseModel* thisAlbum = new BrowseModel(nullptr, id, title, subtitle, type, image, commands);
 
-            // update the entity
-            updateBrowseModel(thisAlbum);
+        // add tracks to album
+        for (int i = 0; i < album.metadata.size(); i++) {
+            const PlexMetadataItem& track = album.metadata[i];
+            thisAlbum->addItem(track.ratingKey, track.title, track.grandparentTitle, sub_type,
+                               m_artwork->url(track.parentThumb, PlexArtwork::THUMBNAIL), commands);
+            if (i < PREFETCH_ROWS) m_artwork->prefetch(track.parentThumb, PlexArtwork::THUMBNAIL);
         }
-        context->deleteLater();
+
+        // update the entity
+        updateBrowseModel(thisAlbum);
+    });
+}
+
+// every page is a list of its own, like playlist pages, so only the page on screen is held
+void PlexMedia::getEpisodes(const QString& id, int start) {
+    QString url = m_serverURL + "/library/metadata/" + id + "/allLeaves";
+
+    getCachedRequest(url, pageParams(start, BROWSE_PAGE_SIZE), [=](const PlexMediaContainer& container) {
+        QStringList commands = {"PLAY", "QUEUE"};
+        qint64      total = container.totalSize > 0 ? container.totalSize : container.size;
+        int         count = container.metadata.size();
+
+        QString      title = container.title2.isEmpty() ? container.parentTitle : container.title2;
+        QString      image = container.thumb.isEmpty() ? container.grandparentThumb : container.thumb;
+        BrowseModel* show = new BrowseModel(nullptr, id, title, pageRange(start, count, total), "show",
+                                            m_artwork->url(image, PlexArtwork::ARTWORK), commands);
+
+        // add episodes to show
+        for (int i = 0; i < count; i++) {
+            const PlexMetadataItem& episode = container.metadata[i];
+            show->addItem(episode.ratingKey, episode.title, episode.grandparentTitle + " - " + episode.parentTitle,
+                          "episode", m_artwork->url(episode.thumb, PlexArtwork::THUMBNAIL), commands);
+            if (i < PREFETCH_ROWS) m_artwork->prefetch(episode.thumb, PlexArtwork::THUMBNAIL);
+        }
+        if (start + count < total) {  // the rest is only downloaded when the user asks for it
+            show->addItem(id + "@" + QString::number(start + count), "More...",
+                          pageRange(start + count, qMin(static_cast<qint64>(BROWSE_PAGE_SIZE), total - start - count),
+                                    total),
+                          "show", "", QStringList());
+        }
+
+        // update the entity once the page is complete
+        updateBrowseModel(show);
     });
-    getRequest(url, "");
 }
 
 void PlexMedia::getPlaylist(QString id) {
+    int start = splitPage(&id);
+
     QString url = m_serverURL + "/playlists/" + id + "/items";
+    QString params = pageParams(start, BROWSE_PAGE_SIZE);
     if (id.contains("playQueues") || id.contains("recentlyAdded")) url = m_serverURL + id; // update if we are passed a playQueue or recently played list
+    if (id.contains("recentlyAdded")) params = pageParams(0, 25); // only show first 25 for recently added to avoid overly long lists. This is also the max for the music list using this method.
+    if (id.contains("playQueues")) params = "?window=" + QString::number(PLAY_QUEUE_WINDOW);
+
+    QString playlistId = id;
+    PlexRequest::ContainerHandler handler = [=](const PlexMediaContainer& playlist) {
+        qCDebug(m_logCategory) << "GET PLAYLIST";
+        QString id       = "";
+        QString title    = "";
+        QString subtitle = "";
+        QString type     = "playlist";
+        QString image    = "";
+        QStringList commands = {"PLAY", "QUEUE"}; //this is albumView so commands relate to individual tracks.
+
+        //take first entry as thumb
+        QString firstThumb;
+        QString firstGrandparentThumb;
+        if (!playlist.metadata.isEmpty()) {
+            firstThumb            = playlist.metadata.first().thumb;
+            firstGrandparentThumb = playlist.metadata.first().grandparentThumb;
+        }
 
-    QObject* context = new QObject(this);
-
-    QObject::connect(this, &PlexMedia::requestReady, context, [=](const QVariantMap& map, const QString& rUrl) {
-        if (rUrl == url) {
-            qCDebug(m_logCategory) << "GET PLAYLIST";
-            QString title    = "";
-            QString subtitle = "";
-            QString type     = "playlist";
-            QString image    = "";
-            QStringList commands = {"PLAY", "QUEUE"}; //this is albumView so commands relate to individual tracks.
-
-            QVariantMap playlist = map.value("MediaContainer").toMap();
-            if (playlist.contains("playQueueID")) { //if playqueue then
-                QString id       = "/playQueues/ " + playlist.value("playQueueID").toString();
-                QString title    = "Now Playing";
-                QString subtitle = playlist.value("playQueueTotalCount").toString() + " item(s)";
-                //take first entry as thumb
-                QString image    = m_serverURL + playlist.value("Metadata").toList()[0].toMap().value("grandparentThumb").toString();
-            } else if (playlist.contains("title2")) {
-                QString id       = "/library/recentlyAdded";
-                QString title    = "Recently Added (" +  playlist.value("title1").toString() + ")";
-                QString subtitle = "25 item(s)";
-                //take first entry as thumb
-                QString image    = m_serverURL + playlist.value("Metadata").toList()[0].toMap().value("thumb").toString();
-            } else { //if standard playlist
-                QString id       = playlist.value("ratingKey").toString();
-                QString title    = playlist.value("title").toString();
-                QString subtitle = playlist.value("leafCount").toString() + " item(s)";
-                //take first entry as thumb
-                QString image    = m_serverURL + playlist.value("Metadata").toList()[0].toMap().value("grandparentThumb").toString();
-            }
+        bool paged = false;
+        if (!playlist.playQueue.id.isEmpty()) { //if playqueue then
+            id       = "/playQueues/" + playlist.playQueue.id;
+            title    = "Now Playing";
+            subtitle = QString::number(playlist.playQueue.totalCount) + " item(s)";
+            image    = m_artwork->url(firstGrandparentThumb, PlexArtwork::ARTWORK);
+        } else if (!playlist.title2.isEmpty()) {
+            id       = "/library/recentlyAdded";
+            title    = "Recently Added (" +  playlist.title1 + ")";
+            subtitle = "25 item(s)";
+            image    = m_artwork->url(firstThumb, PlexArtwork::ARTWORK);
+        } else { //if standard playlist
+            id       = playlist.ratingKey;
+            title    = playlist.title;
+            subtitle = playlist.leafCount + " item(s)";
+            image    = m_artwork->url(firstGrandparentThumb, PlexArtwork::ARTWORK);
+            paged    = true;
+        }
 
-            BrowseModel* thisPlaylist = new BrowseModel(nullptr, id, title, subtitle, type, image, commands);
-
-            // add tracks to playlist
-            QVariantList tracks = map.value("MediaContainer").toMap().value("Metadata").toList();
-            int listLength = tracks.length();
-            if (id.contains("recentlyAdded")) { listLength = 25; } // only show first 25 for recently added to avoid overly long lists. This is also the max for the music list using this method.
-            for (int i = 0; i < listLength; i++) {
-                QString id = "";
-                title = "";
-                subtitle = "";
-
-                id = tracks[i].toMap().value("ratingKey").toString();
-                title = tracks[i].toMap().value("title").toString();
-                type = tracks[i].toMap().value("type").toString();
-                if (type == "season") { type = "show"; }
-
-                if (tracks[i].toMap().contains("grandparentTitle")) {
-                    subtitle = tracks[i].toMap().value("grandparentTitle").toString(); //track or tv show
-                } else if (tracks[i].toMap().contains("parentTitle")) { // album (via recenlty added)
-                    subtitle = tracks[i].toMap().value("parentTitle").toString();
-                } else if (tracks[i].toMap().contains("summary")) {
-                    subtitle = tracks[i].toMap().value("summary").toString(); //movie
-                }
+        int    listLength = playlist.metadata.size();
+        qint64 total = playlist.totalSize > 0 ? playlist.totalSize : playlist.leafCount.toLongLong();
+        if (paged && start > 0) subtitle = pageRange(start, listLength, total);
+
+        BrowseModel* thisPlaylist = new BrowseModel(nullptr, id, title, subtitle, type, image, commands);
 
-                // try and find an image. . Work backwards if we can't find anything.
-                QString thumb = "";
-                if (tracks[i].toMap().contains("thumb")) { QString thumb = tracks[i].toMap().value("thumb").toString();
-                } else if (tracks[i].toMap().contains("parentThumb")) { QString thumb = tracks[i].toMap().value("parentThumb").toString();
-                } else if (tracks[i].toMap().contains("grandparentThumb")) { QString thumb = tracks[i].toMap().value("grandparentThumb").toString(); }
+        // add tracks to playlist
+        if (id.contains("recentlyAdded")) { listLength = qMin(listLength, 25); }
+        for (int i = 0; i < listLength; i++) {
+            const PlexMetadataItem& track = playlist.metadata[i];
 
-                thisPlaylist->addItem(id,title,subtitle,type,m_serverURL + thumb,commands);
+            type = track.type;
+            if (type == "season") { type = "show"; }
 
-                // update the entity
-                updateBrowseModel(thisPlaylist);
+            if (!track.grandparentTitle.isEmpty()) {
+                subtitle = track.grandparentTitle; //track or tv show
+            } else if (!track.parentTitle.isEmpty()) { // album (via recenlty added)
+                subtitle = track.parentTitle;
+            } else {
+                subtitle = track.summary; //movie
             }
+
+            // try and find an image. Work backwards if we can't find anything.
+            thisPlaylist->addItem(track.ratingKey, track.title, subtitle, type,
+                                  m_artwork->url(track.image(), PlexArtwork::THUMBNAIL), commands);
+            if (i < PREFETCH_ROWS) m_artwork->prefetch(track.image(), PlexArtwork::THUMBNAIL);
         }
-        context->deleteLater();
-    });
-    getRequest(url, "");
+        if (paged && start + listLength < total) { // the rest is only downloaded when the user asks for it
+            thisPlaylist->addItem(playlistId + "@" + QString::number(start + listLength), "More...",
+                                  pageRange(start + listLength,
+                                            qMin(static_cast<qint64>(BROWSE_PAGE_SIZE), total - start - listLength),
+                                            total),
+                                  "playlist", "", QStringList());
+        }
+
+        // update the entity once the list is complete
+        updateBrowseModel(thisPlaylist);
+    };
+
+    if (id == "/playQueues/" + player().queue) {
+        syncPlayQueue(handler);  // the cached window of the current queue
+    } else if (id.contains("playQueues")) {
+        getRequest(url, params)->then(this, handler);  // the play queue changes with every track, not worth caching
+    } else {
+        getCachedRequest(url, params, handler);
+    }
 }
 
 void PlexMedia::getUserPlaylists() {
     QString all_url = m_serverURL + "/playlists";
     qCDebug(m_logCategory) << "SENDING PLAYLIST REQUESTS";
 
-    QObject* context = new QObject(this);
-    QObject::connect(this, &PlexMedia::requestReady, context, [=](const QVariantMap& map, const QString& rUrl) {
-        if (rUrl == all_url) {
-            qCDebug(m_logCategory) << "GET USERS PLAYLIST";
-            QString     id       = "";
-            QString     title    = "";
-            QString     subtitle = "";
-            QString     type     = "playlist";
-            QString     image    = "";
-            QStringList commands = {"PLAY", "SHUFFLE"};
-
-            BrowseModel* allPlaylists = new BrowseModel(nullptr, id, title, subtitle, type, image, commands);
-
-            allPlaylists->addItem("/library/sections/3/recentlyAdded","Recently Added (Music)","25 item(s)",type,"",commands); // no image as don't want to have to make a call for it.
-            allPlaylists->addItem("/library/sections/1/recentlyAdded","Recently Added (TV Shows)","25 item(s)",type,"",commands);
-            allPlaylists->addItem("/library/sections/2/recentlyAdded","Recently Added (Movies)","25 item(s)",type,"",commands);
-
-            // add playlists to model
-            QVariantList playlists = map.value("MediaContainer").toMap().value("Metadata").toList();
-            for (int i = 0; i < playlists.length(); i++) {
-               // playlists don't have an image by default. don't want to loop through HTTP calls to get thumbs so gonna suck it up. Best to include a playlist-specific default image in future.
-               allPlaylists->addItem(playlists[i].toMap().value("ratingKey").toString(),
-                              playlists[i].toMap().value("title").toString(),
-                              playlists[i].toMap().value("leafCount").toString() + " item(s)",
-                              type,
-                              "",
-                              commands);
-            }
-
-            // update the entity
-            updateBrowseModel(allPlaylists);
-
-            //now create a playlist of the current playQueue (if there is one)
-            if (!(m_playerQueue.isNull() || m_playerQueue.isEmpty())) {
-                QString now_url = m_serverURL + "/playQueues/" + m_playerQueue;
-
-                QObject* context = new QObject(this);
-                QObject::connect(this, &PlexMedia::requestReady, context, [=](const QVariantMap& map, const QString& rUrl) {
-                    if (rUrl == now_url) {
-                        qCDebug(m_logCategory) << "GET NOW PLAYING PLAYLIST";
-
-                        // try and find an image. Work backwards if we can't find anything. Would be good to update this to the currently playing track?
-                        QVariantList playlists = map.value("MediaContainer").toMap().value("Metadata").toList();
-                        QString thumb = "";
-                        if (playlists[0].toMap().contains("thumb")) { thumb = playlists[0].toMap().value("thumb").toString();
-                        } else if (playlists[0].toMap().contains("parentThumb")) { thumb = playlists[0].toMap().value("parentThumb").toString();
-                        } else if (playlists[0].toMap().contains("grandparentThumb")) { thumb = playlists[0].toMap().value("grandparentThumb").toString(); }
-
-                        QStringList commands = {"PLAY", "SHUFFLE"};
-                        allPlaylists->addItem("/playQueues/" + m_playerQueue,"Now Playing",map.value("MediaContainer").toMap().value("playQueueTotalCount").toString() + " item(s)",type,m_serverURL + thumb,commands);
+    getCachedRequest(all_url, "", [=](const PlexMediaContainer& container) {
+        qCDebug(m_logCategory) << "GET USERS PLAYLIST";
+        QString     id       = "";
+        QString     title    = "";
+        QString     subtitle = "";
+        QString     type     = "playlist";
+        QString     image    = "";
+        QStringList commands = {"PLAY", "SHUFFLE"};
+
+        BrowseModel* allPlaylists = new BrowseModel(nullptr, id, title, subtitle, type, image, commands);
+
+        allPlaylists->addItem("/library/sections/3/recentlyAdded","Recently Added (Music)","25 item(s)",type,"",commands); // no image as don't want to have to make a call for it.
+        allPlaylists->addItem("/library/sections/1/recentlyAdded","Recently Added (TV Shows)","25 item(s)",type,"",commands);
+        allPlaylists->addItem("/library/sections/2/recentlyAdded","Recently Added (Movies)","25 item(s)",type,"",commands);
+
+        // add playlists to model
+        for (int i = 0; i < container.metadata.size(); i++) {
+           // playlists don't have an image by default. don't want to loop through HTTP calls to get thumbs so gonna suck it up. Best to include a playlist-specific default image in future.
+           const PlexMetadataItem& playlist = container.metadata[i];
+           allPlaylists->addItem(playlist.ratingKey, playlist.title, playlist.leafCount + " item(s)", type, "", commands);
+        }
 
-                        // update the entity
-                        updateBrowseModel(allPlaylists);
-                        allPlaylists->deleteLater();
-                    }
-                    context->deleteLater();
-                });
-                getRequest(now_url, "");
-            } else {
-                qCDebug(m_logCategory) << "No m_playerQueue defined.";
-            }
+        //now add a playlist of the current playQueue (if there is one). Its window is kept current by the timeline.
+        const PlexMediaContainer& queue = m_playQueue.container();
+        if (!player().queue.isEmpty() && queue.playQueue.id == player().queue) {
+            // try and find an image. Work backwards if we can't find anything. Would be good to update this to the currently playing track?
+            QString thumb = "";
+            if (!queue.metadata.isEmpty()) { thumb = queue.metadata.first().image(); }
+            allPlaylists->addItem("/playQueues/" + player().queue, "Now Playing",
+                                  QString::number(queue.playQueue.totalCount) + " item(s)", type,
+                                  m_artwork->url(thumb, PlexArtwork::THUMBNAIL), commands);
+        } else {
+            qCDebug(m_logCategory) << "No play queue defined.";
         }
-        context->deleteLater();
+
+        // update the entity once the list is complete
+        updateBrowseModel(allPlaylists);
     });
-    getRequest(all_url, "");
 }
 
 void PlexMedia::getCurrentPlayer() {
-    // could be upgraded as subscription based rather than polling. updates are sent to /:/timeline in XML. issue with keeping an open connection though.
-    // direct polling is possible via POST {m_playerURL + "/player/timeline/poll?wait=1&commandId=" + m_cmdId} to poll but this returns XML and not JSON. Provides additional information such as volume as well.
+    // with timeline_subscription the player pushes its timeline to /:/timeline on our listener, the poll below only runs until the pushes arrive.
+    // direct polling is possible via POST {player().url + "/player/timeline/poll?wait=1&commandId=" + m_cmdId} to poll but this returns XML and not JSON. Provides additional information such as volume as well.
     // apparently Win and Mac players do not respond to these poll request though? Requires a known port to be reliable hence hasve included a backup via the server.
     // implemented workflow is media info taken from session and port taken from client endpoint and then poll for details of volume and playQueue.
 
-    EntityInterface* entity = static_cast<EntityInterface*>(m_entities->getEntityInterface(m_entityId));
-    if (entity) { //only poll if plex is the active entity
+    refreshEntities();  // answered by the next tick
+    bool visible = hasEntities();
+    m_pollScheduler->setVisible(visible);
+    if (visible && !m_serverIP.isEmpty()) { //only poll if one of our entities is active and the server is known
 
         // if no speaker or need to get list of sources or there is no direct connection to the current/previous source.
-        if (m_playerId.isNull() || m_playerId.isEmpty() || m_speakerRequest || !m_directConn || m_newTrack) {
-            //qCDebug(m_logCategory) << "m_playerID.isNull =" << m_playerId.isNull()<< "m_playerID.isEmpty ="  << m_playerId.isEmpty() << "m_speakerRequest =" <<  m_speakerRequest << "m_directConn ="  << m_directConn << "m_newTrack =" << m_newTrack;
+        if (m_notificationMode && m_notifications->isConnected() && !m_sessionsStale && !m_newTrack) {
+            // the server pushes session changes, so the cached session table is current. No need to download it.
+            if (playerId().isNull() || playerId().isEmpty() || m_speakerRequest) updateSessions(allSessions());
+        } else if (playerId().isNull() || playerId().isEmpty() || m_speakerRequest || !player().directConn || m_newTrack) {
+            //qCDebug(m_logCategory) << "m_playerID.isNull =" << playerId().isNull()<< "m_playerID.isEmpty ="  << playerId().isEmpty() << "m_speakerRequest =" <<  m_speakerRequest << "player().directConn ="  << player().directConn << "m_newTrack =" << m_newTrack;
             QString url = m_serverURL + "/status/sessions"; // list of all active sessions
 
-            if (m_pollingTimer->interval() < 4000) { m_pollingTimer->setInterval(4000); } // if we are polling the server then slow polling rate back down.
-
-            QObject* context = new QObject(this);
-            QObject::connect(this, &PlexMedia::requestReady, context, [=](const QVariantMap& map, const QString& rUrl) {
-                //qCDebug(m_logCategory) << "getCurrentPlayer returned URL is: " + rUrl + ", requested URL is " + url;
-                if (rUrl == url) {
-                        if (map.value("MediaContainer").toMap().contains("Metadata")) {
-                            m_playerConnected = true;
-                            if (m_speakerRequest) getSpeakers(map); // process outstanding speaker request first.
-
-                            QVariantList players = map.value("MediaContainer").toMap().value("Metadata").toList(); //define list of players
-
-                            //Loop through and find the correct player.
-                           int player_index = 0;
-                            bool foundPlayer = false;
-                            for (int i = 0; i < players.length(); i++) {
-                                if (players[i].toMap().value("Player").toMap().value("machineIdentifier").toString() == m_playerId) {
-                                    player_index = i;
-                                    foundPlayer = true;
-                                    break;
-                                }
-                            }
-                            if (!foundPlayer) m_playerId = ""; //if player has gone offline then reset to default.
-
-                            if (m_playerId.isNull() || m_playerId.isEmpty()) {
-                                // if nothing is set then use the first player reported.
-                                player_index = 0;
-                                m_playerPort = "0"; //reset port. we'll try to find it next.
-                            }
-
-                            m_playerId = players[player_index].toMap().value("Player").toMap().value("machineIdentifier").toString();
-                            m_playerIP = players[player_index].toMap().value("Player").toMap().value("address").toString();
-                            if (m_playerPort == "0") m_playerURL = "http://" + m_playerIP + ":32500"; // if port is not set then make a guess to (potentially) enable control while we wait for /clients endpoint to confirm.
-                            else m_playerURL = "http://" + m_playerIP + ":" + m_playerPort;
-
-                            if (m_playerCurrentTrack == players[player_index].toMap().value("ratingKey").toString()) {
-                                m_newTrack = false;
-                            } else {
-                                m_newTrack = true;
-                                m_playerCurrentTrack = players[player_index].toMap().value("ratingKey").toString(); // set as current track
-                            }
-
-                            // reduce the burden if track/show/movie hasn't changed.
-                            //if (m_newTrack) {
-                                // get player platform
-                                m_playerPlatform = players[player_index].toMap().value("Player").toMap().value("platform").toString();
-
-                                // get the image. work backwards depending on the metadata available.
-                                QString image = "";
-                                if (players[player_index].toMap().contains("thumb")) { image = players[player_index].toMap().value("thumb").toString();
-                                } else if (players[player_index].toMap().contains("parentThumb")) { image = players[player_index].toMap().value("parentThumb").toString();
-                                } else if (players[player_index].toMap().contains("grandparentThumb")) { image = players[player_index].toMap().value("grandparentThumb").toString(); }
-                                entity->updateAttrByIndex(MediaPlayerDef::MEDIAIMAGE, m_serverURL + image);
-
-                                // get the device
-                                entity->updateAttrByIndex(MediaPlayerDef::SOURCE,
-                                                          players[player_index].toMap().value("Player").toMap().value("title").toString());
-
-                                // get the track title
-                                entity->updateAttrByIndex(MediaPlayerDef::MEDIATITLE,
-                                                          players[player_index].toMap().value("title").toString());
-
-                                // get the artist/show/movie parent
-                                QString trackParent;
-                                if (players[player_index].toMap().value("type").toString() == "track") {
-                                    if (players[player_index].toMap().contains("originalTitle")) { trackParent = players[player_index].toMap().value("originalTitle").toString();
-                                    } else { trackParent = players[player_index].toMap().value("grandparentTitle").toString(); } // parent is album and grandparent is artist.
-                                } else if (players[player_index].toMap().value("type").toString() == "show")  { trackParent = players[player_index].toMap().value("grandparentTitle").toString() + " - " + players[player_index].toMap().value("parentTitle").toString();
-                                } else if (players[player_index].toMap().value("type").toString() == "movie") { trackParent = players[player_index].toMap().value("tagLine").toString();
-                                } else { trackParent = players[player_index].toMap().value("parentTitle").toString(); }
-
-                                entity->updateAttrByIndex(MediaPlayerDef::MEDIAARTIST,
-                                                          trackParent);
-                            //}
-
-                            // use opportunity to update status and progress.
-                            // get the state
-                            m_playerState = players[player_index].toMap().value("Player").toMap().value("state").toString();
-                            if (m_playerState == "playing") {
-                                entity->updateAttrByIndex(MediaPlayerDef::STATE, MediaPlayerDef::PLAYING);
-                            } else {
-                                entity->updateAttrByIndex(MediaPlayerDef::STATE, MediaPlayerDef::IDLE);
-                            }
-
-                            // update progress
-                            entity->updateAttrByIndex(
-                                MediaPlayerDef::MEDIADURATION,
-                                static_cast<int>(players[player_index].toMap().value("duration").toInt() / 1000));
-                            entity->updateAttrByIndex(MediaPlayerDef::MEDIAPROGRESS,
-                                                      static_cast<int>(players[player_index].toMap().value("viewOffset").toInt() / 1000));
-
-                        } else if (m_playerConnected) { // if no players then empty the player screen.
-                            qCDebug(m_logCategory) << "No players discovered. Clearing player.";
-                            entity->updateAttrByIndex(MediaPlayerDef::MEDIAIMAGE, "");
-                            entity->updateAttrByIndex(MediaPlayerDef::SOURCE, "");
-                            entity->updateAttrByIndex(MediaPlayerDef::MEDIATITLE, "");
-                            entity->updateAttrByIndex(MediaPlayerDef::MEDIAARTIST, "");
-                            entity->updateAttrByIndex(MediaPlayerDef::MEDIADURATION, 0);
-                            entity->updateAttrByIndex(MediaPlayerDef::MEDIAPROGRESS, 0);
-                            entity->updateAttrByIndex(MediaPlayerDef::STATE, MediaPlayerDef::OFF);
-                            m_playerConnected = false;
-                        }
-                }
-                context->deleteLater();
-            });
-            getRequest(url, "");
+            if (m_pollScheduler->acquire("sessions")) { // previous download still running? skip this tick.
+                PlexRequest* handle = m_pollScheduler->track("sessions", getRequest(url, ""));
+                handle->onReply(this, [=](int statusCode, const QByteArray& body) {
+                    if (statusCode == 200) m_startupState.sessions = body; // snapshot for the next start
+                });
+                handle->then(this, [=](const PlexMediaContainer& container) {
+                    m_sessions = container.sessions;
+                    m_sessionsStale = false;
+                    updateSessions(allSessions());
+                    if (!m_nowPlayingReported) {
+                        m_nowPlayingReported = true;
+                        qCDebug(m_logCategory) << "Now playing populated" << m_connectTimer.elapsed()
+                                               << "ms after connect";
+                    }
+                });
+            }
         }
+        getExtraSessions();  // the other servers have no notifications, they are downloaded on every tick
 
         // poll if we have a player to poll
         // this is all a bit convoluted but I've tried to reduce the number of calls made to get different bits of information.
-        if (!(m_playerId.isNull() || m_playerId.isEmpty())) {
-            // try clients endpoint if we don't have a confirmed port yet.
+        if (!(playerId().isNull() || playerId().isEmpty())) {
+            // try clients endpoint if we don't have a confirmed port yet (i.e. the player did not answer discovery).
             // hopefully able to grab the confirmed port straight away and then call again until we change player.
-            if (m_playerPort == "0") { //only try to find port if not currently set for the active player.
+            //only try to find port if not currently set for the active player.
+            if (player().port == "0" && m_pollScheduler->acquire("clients")) {
                 QString url = m_serverURL + "/clients";
-                QObject* context = new QObject(this);
-                QObject::connect(this, &PlexMedia::requestReady, context, [=](const QVariantMap& map, const QString& rUrl) {
-                   if (rUrl == url) {
-                        //Loop through and find the correct player.
-                        QVariantList players = map.value("MediaContainer").toMap().value("Server").toList();
-                        for (int i = 0; i < players.length(); i++) {
-                            if (players[i].toMap().value("machineIdentifier").toString() == m_playerId) {
-                                m_playerPort = players[i].toMap().value("port").toString();
-                                qCDebug(m_logCategory) << "PORT FOUND, SETTING TO: " << m_playerPort;
-                                break;
-                            }
+                PlexRequest* handle = m_pollScheduler->track("clients", getRequest(url, ""));
+                handle->then(this, [=](const PlexMediaContainer& container) {
+                    //Loop through and find the correct player. The other ports are kept for when a player is picked.
+                    for (int i = 0; i < container.clients.size(); i++) {
+                        if (container.clients[i].port.isEmpty()) {
+                            continue;
+                        }
+                        m_startupState.playerPorts.insert(container.clients[i].machineIdentifier,
+                                                          container.clients[i].port);
+                        if (container.clients[i].machineIdentifier == playerId()) {
+                            player().port = container.clients[i].port;
+                            qCDebug(m_logCategory) << "PORT FOUND, SETTING TO: " << player().port;
                         }
                     }
-                    context->deleteLater();
                 });
-                getRequest(url, "");
-                if (m_playerPort != "0") { m_playerURL = "http://" + m_playerIP + ":" + m_playerPort; }
+                if (player().port != "0") { player().url = "http://" + player().address + ":" + player().port; }
             }
 
-            if (!m_playerURL.isEmpty()) { //URL is emptied when player is changed.
-                QString url = m_playerURL + "/player/timeline/poll";
+            if (m_subscriptionMode) {
+                m_subscription->setPlayer(player().url);  // (re)subscribe to the active player
+            }
+
+            if (!player().url.isEmpty() && !(m_subscriptionMode && m_subscription->isPushing())) { //no URL until the player is found. No need to poll once the player's pushes arrive.
+                QString url = player().url + "/player/timeline/poll";
                 QString message = "?wait=1";
                 getPollRequest(url, message);
             }
@@ -698,8 +986,299 @@ void PlexMedia::getCurrentPlayer() {
     } //end of active entity check
 }
 
+// artist/show/movie parent line of the playing item
+static QString mediaArtist(const PlexMetadataItem& item) {
+    QString trackParent;
+    if (item.type == "track") {
+        if (!item.originalTitle.isEmpty()) { trackParent = item.originalTitle;
+        } else { trackParent = item.grandparentTitle; } // parent is album and grandparent is artist.
+    } else if (item.type == "show")  { trackParent = item.grandparentTitle + " - " + item.parentTitle;
+    } else if (item.type == "movie") { trackParent = item.tagLine;
+    } else { trackParent = item.parentTitle; }
+    return trackParent;
+}
+
+void PlexMedia::updateSessions(const QVector<PlexSession>& players) {
+    // every player is tracked. The active one is shown on the main entity, each one on its own entity if enabled.
+    m_sessionTable.update(players);
+    for (const PlexSession& session : players) {
+        if (!session.player.machineIdentifier.isEmpty()) {
+            m_startupState.players.insert(session.player.machineIdentifier, session.player.title);
+        }
+    }
+    updatePlayerEntities();
+
+    if (!hasEntity(m_entityId)) {
+        return;
+    }
+
+    if (!players.isEmpty()) {
+        m_playerConnected = true;
+        if (m_speakerRequest) getSpeakers(players); // process outstanding speaker request first.
+
+        if (m_sessionTable.size() == 0) {
+            return;  // no player identified itself
+        }
+        if (!m_sessionTable.contains(playerId())) {
+            if (!playerId().isEmpty()) {
+                qCDebug(m_logCategory) << "Player" << playerId() << "has no session any more";
+            }
+            // if nothing is set or the player has gone offline then use the first player reported.
+            m_commands->clear();
+            m_sessionTable.setActive(m_sessionTable.ids().first()); // with what was learned if it was active before
+        }
+
+        const PlexSession       session = player().session;
+        const PlexMetadataItem& item = session.item;
+
+        player().address = session.player.address;
+        if (player().port == "0") player().port = m_discovery->player(playerId()).port; // answered discovery
+        if (player().port.isEmpty() || player().port == "0") player().port = m_startupState.playerPorts.value(playerId(), "0"); // found before a restart
+        if (player().port == "0") player().url = "http://" + player().address + ":32500"; // if port is not set then make a guess to (potentially) enable control while we wait for /clients endpoint to confirm.
+        else player().url = "http://" + player().address + ":" + player().port;
+
+        if (player().currentTrack == item.ratingKey) {
+            m_newTrack = false;
+        } else {
+            m_newTrack = true;
+            player().currentTrack = item.ratingKey; // set as current track
+        }
+        m_commands->reconcile(PlexCommandQueue::SKIP, item.ratingKey, PlexCommandQueue::SESSIONS);
+        m_commands->reconcile(PlexCommandQueue::MEDIA, item.ratingKey + "/" + QString::number(item.playQueueItemID),
+                              PlexCommandQueue::SESSIONS);
+        bool skipping = m_commands->expecting(PlexCommandQueue::SKIP);  // already showing the item it lands on
+        if (!skipping && item.playQueueItemID > 0) player().queueItem = item.playQueueItemID;
+        if (m_newTrack) syncPlayQueue(PlexRequest::ContainerHandler());
+
+        // unchanged track/show/movie details are filtered out by the entity state, so these are cheap to repeat.
+        // get player platform
+        m_commands->setPlatform(session.player.platform);
+
+        // get the device
+        m_entityState->update(MediaPlayerDef::SOURCE, session.player.title);
+
+        if (!skipping) {
+            // get the image. work backwards depending on the metadata available.
+            showArtwork(item.image());
+
+            // get the track title
+            m_entityState->update(MediaPlayerDef::MEDIATITLE, item.title);
+
+            // get the artist/show/movie parent
+            m_entityState->update(MediaPlayerDef::MEDIAARTIST, mediaArtist(item));
+        }
+
+        // use opportunity to update status and progress.
+        // get the state
+        player().state = session.player.state;
+        m_pollScheduler->setActivity(player().state == "playing" ? PlexPollScheduler::PLAYING
+                                                             : PlexPollScheduler::PAUSED);
+        if (m_commands->reconcile(PlexCommandQueue::STATE, player().state, PlexCommandQueue::SESSIONS).toString() ==
+            "playing") {
+            m_entityState->update(MediaPlayerDef::STATE, MediaPlayerDef::PLAYING);
+        } else {
+            m_entityState->update(MediaPlayerDef::STATE, MediaPlayerDef::IDLE);
+        }
+
+        // update progress
+        if (!skipping) {
+            m_entityState->update(MediaPlayerDef::MEDIADURATION, static_cast<int>(item.duration / 1000));
+        }
+        if (!skipping && (!player().directConn || m_newTrack) && // the player's own timeline is more accurate than the server's copy
+            m_commands->reconcile(PlexCommandQueue::SEEK, item.viewOffset, PlexCommandQueue::SESSIONS).toLongLong() ==
+                item.viewOffset) {
+            m_progressClock->sample(item.ratingKey, m_sessionTable.position(playerId()), item.duration,
+                                    player().state == "playing");
+        }
+
+    } else if (m_playerConnected) { // if no players then empty the player screen.
+        qCDebug(m_logCategory) << "No players discovered. Clearing player.";
+        showArtwork("");
+        m_entityState->update(MediaPlayerDef::SOURCE, "");
+        m_entityState->update(MediaPlayerDef::MEDIATITLE, "");
+        m_entityState->update(MediaPlayerDef::MEDIAARTIST, "");
+        m_entityState->update(MediaPlayerDef::MEDIADURATION, 0);
+        m_progressClock->reset();
+        m_entityState->update(MediaPlayerDef::MEDIAPROGRESS, 0);
+        m_entityState->update(MediaPlayerDef::STATE, MediaPlayerDef::OFF);
+        m_playerConnected = false;
+    }
+    if (players.isEmpty()) {
+        m_pollScheduler->setActivity(PlexPollScheduler::IDLE); // nobody is playing, back off
+    }
+}
+
+QVector<PlexSession> PlexMedia::allSessions() const {
+    QVector<PlexSession> sessions = m_sessions;
+    for (int i = 0; i < m_extraServers.size(); i++) {
+        sessions += m_extraSessions.value(m_extraServers[i]);
+    }
+    return sessions;
+}
+
+void PlexMedia::getExtraSessions() {
+    for (int i = 0; i < m_extraServers.size(); i++) {
+        QString server = m_extraServers[i];
+        QString endpoint = "sessions " + server;
+        if (!m_pollScheduler->acquire(endpoint)) {
+            continue;
+        }
+        PlexRequest* handle = m_pollScheduler->track(endpoint, getRequest(server + "/status/sessions", ""));
+        handle->then(this, [=](const PlexMediaContainer& container) {
+            QVector<PlexSession> sessions = container.sessions;
+            for (int j = 0; j < sessions.size(); j++) {
+                // thumb paths are only valid on their own server, the artwork cache transcodes full URLs there
+                PlexMetadataItem& item = sessions[j].item;
+                if (item.thumb.startsWith('/')) item.thumb = server + item.thumb;
+                if (item.parentThumb.startsWith('/')) item.parentThumb = server + item.parentThumb;
+                if (item.grandparentThumb.startsWith('/')) item.grandparentThumb = server + item.grandparentThumb;
+                sessions[j].server = server;
+            }
+            m_extraSessions.insert(server, sessions);
+            updateSessions(allSessions());
+        });
+    }
+}
+
+void PlexMedia::updatePlayerEntities() {
+    for (QHash<QString, QString>::const_iterator iter = m_playerEntities.constBegin();
+         iter != m_playerEntities.constEnd(); ++iter) {
+        PlexEntityState*                state = m_playerEntityStates.value(iter.key());
+        const PlexSessionTable::Player* player = m_sessionTable.find(iter.value());
+        if (!player) {
+            state->update(MediaPlayerDef::STATE, MediaPlayerDef::OFF);
+            state->update(MediaPlayerDef::MEDIATITLE, "");
+            state->update(MediaPlayerDef::MEDIAARTIST, "");
+            state->update(MediaPlayerDef::MEDIAIMAGE, "");
+            state->update(MediaPlayerDef::MEDIADURATION, 0);
+            state->update(MediaPlayerDef::MEDIAPROGRESS, 0);
+            continue;
+        }
+
+        // what was pressed for it shows until its sessions confirm it or the expectation runs out
+        const PlexMetadataItem& item = player->session.item;
+        PlexCommandQueue*       commands = m_playerCommands.value(iter.value());
+        bool                    playing = player->playing;
+        if (commands) {
+            commands->reconcile(PlexCommandQueue::SKIP, item.ratingKey, PlexCommandQueue::SESSIONS);
+            playing = commands->reconcile(PlexCommandQueue::STATE, playing ? "playing" : "paused",
+                                          PlexCommandQueue::SESSIONS).toString() == "playing";
+            if (commands->expecting(PlexCommandQueue::VOLUME)) pollPlayerVolume(iter.value());
+        }
+
+        // progress moves on with each sessions update, only the main entity ticks in between
+        state->update(MediaPlayerDef::SOURCE, player->session.player.title);
+        state->update(MediaPlayerDef::MEDIAIMAGE, m_artwork->url(item.image(), PlexArtwork::ARTWORK));
+        state->update(MediaPlayerDef::MEDIATITLE, item.title);
+        state->update(MediaPlayerDef::MEDIAARTIST, mediaArtist(item));
+        state->update(MediaPlayerDef::MEDIADURATION, static_cast<int>(item.duration / 1000));
+        state->update(MediaPlayerDef::MEDIAPROGRESS, static_cast<int>(m_sessionTable.position(iter.value()) / 1000));
+        state->update(MediaPlayerDef::STATE, playing ? MediaPlayerDef::PLAYING : MediaPlayerDef::IDLE);
+    }
+}
+
+// a player other than the active one gets a command queue of its own: ordered, merged and rolled back the same way
+PlexCommandQueue* PlexMedia::playerCommands(const QString& playerId) {
+    PlexCommandQueue* commands = m_playerCommands.value(playerId);
+    if (!commands) {
+        commands = new PlexCommandQueue(
+            [=](const QString& path, const QString& params, PlexCommandQueue::Route* route) {
+                return playerRequest(playerId, path, params, route);
+            },
+            this);
+        traceEntityUpdates(commands, m_playerEntityStates.value(m_playerEntities.key(playerId)));
+        m_playerCommands.insert(playerId, commands);
+    }
+    return commands;
+}
+
+PlexRequest* PlexMedia::playerRequest(const QString& playerId, const QString& path, const QString& params,
+                                      PlexCommandQueue::Route* route) {
+    // address from its session or discovery, port from wherever it was found. Relayed by its server until both are.
+    const PlexSessionTable::Player* player = m_sessionTable.find(playerId);
+    PlexDiscovery::Device           device = m_discovery->player(playerId);
+    QString address = player ? player->session.player.address : device.address;
+    QString port = player && player->port != "0" ? player->port : device.port;
+    if (port.isEmpty()) port = m_startupState.playerPorts.value(playerId);
+
+    QMap<QByteArray, QByteArray> headers;
+    headers.insert("X-Plex-Target-Client-Identifier", playerId.toLocal8Bit());
+    if (!address.isEmpty() && !port.isEmpty() && port != "0") {
+        if (route) *route = PlexCommandQueue::DIRECT;
+        return getRequest("http://" + address + ":" + port + path, params, headers);
+    }
+    if (route) *route = PlexCommandQueue::RELAYED;
+    QString server = player && !player->session.server.isEmpty() ? player->session.server : m_serverURL;
+    return getRequest(server + path, params, headers);
+}
+
+void PlexMedia::sendPlayerCommand(const QString& playerId, int command, const QVariant& param) {
+    PlexEntityState*                state = m_playerEntityStates.value(m_playerEntities.key(playerId));
+    PlexCommandQueue*               commands = playerCommands(playerId);
+    const PlexSessionTable::Player* player = m_sessionTable.find(playerId);
+    QString                         current = player ? player->session.item.ratingKey : QString();
+    if (player) commands->setPlatform(player->session.player.platform);
+
+    // shown straight away, confirmed or rolled back by its sessions (and its timeline for the volume)
+    if (command == MediaPlayerDef::C_PLAY) {
+        commands->expect(PlexCommandQueue::STATE, "playing", "PLAY");
+        commands->push(PlexCommandQueue::STATE, "playing");
+        state->update(MediaPlayerDef::STATE, MediaPlayerDef::PLAYING);
+    } else if (command == MediaPlayerDef::C_PAUSE) {
+        commands->expect(PlexCommandQueue::STATE, "paused", "PAUSE");
+        commands->push(PlexCommandQueue::STATE, "paused");
+        state->update(MediaPlayerDef::STATE, MediaPlayerDef::IDLE);
+    } else if (command == MediaPlayerDef::C_STOP) {
+        commands->push("/player/playback/stop", "");  // its session ends, the entity follows
+    } else if (command == MediaPlayerDef::C_NEXT) {
+        commands->expect(PlexCommandQueue::SKIP, current, "NEXT");
+        commands->push(PlexCommandQueue::SKIP, 1);
+    } else if (command == MediaPlayerDef::C_PREVIOUS) {
+        commands->expect(PlexCommandQueue::SKIP, current, "PREVIOUS");
+        commands->push(PlexCommandQueue::SKIP, -1);
+    } else if (command == MediaPlayerDef::C_VOLUME_SET) {
+        int volume = qBound(0, param.toInt(), 100);
+        commands->expect(PlexCommandQueue::VOLUME, volume, "VOLUME_SET");
+        commands->push(PlexCommandQueue::VOLUME, volume);
+        state->update(MediaPlayerDef::VOLUME, volume);
+    }
+}
+
+// sessions do not carry the volume: while a change waits for confirmation the player's own timeline is asked
+void PlexMedia::pollPlayerVolume(const QString& playerId) {
+    QString endpoint = "timeline " + playerId;
+    if (!m_pollScheduler->acquire(endpoint)) {
+        return;
+    }
+    m_pollScheduler->track(endpoint, playerRequest(playerId, "/player/timeline/poll", "?wait=0", nullptr))
+        ->onReply(this, [=](int statusCode, const QByteArray& body) {
+            PlexTimeline timeline;
+            if (statusCode != 200 || !PlexTimelineDecoder::decode(body, &timeline) || !timeline.active) {
+                return;  // asked again with the next sessions update
+            }
+            PlexSessionTable::Player* player = m_sessionTable.find(playerId);
+            if (player) player->volume = timeline.volume;
+            PlexCommandQueue* commands = m_playerCommands.value(playerId);
+            PlexEntityState*  state = m_playerEntityStates.value(m_playerEntities.key(playerId));
+            if (commands && state) {
+                state->update(MediaPlayerDef::VOLUME,
+                              commands->reconcile(PlexCommandQueue::VOLUME, timeline.volume).toInt());
+            }
+        });
+}
+
 void PlexMedia::sendCommand(const QString& type, const QString& entityId, int command, const QVariant& param) {
-    if (!(type == "media_player" && entityId == m_entityId)) { return; }
+    if (QThread::currentThread() != thread()) {  // commands come from the GUI thread in worker thread mode
+        QMetaObject::invokeMethod(this, [=]() { sendCommand(type, entityId, command, param); }, Qt::QueuedConnection);
+        return;
+    }
+    if (type != "media_player") { return; }
+    if (m_playerEntities.contains(entityId) && m_playerEntities.value(entityId) != playerId()) {
+        sendPlayerCommand(m_playerEntities.value(entityId), command, param);
+        return;
+    }
+    // the active player's own entity is controlled like the main entity
+    if (entityId != m_entityId && !m_playerEntities.contains(entityId)) { return; }
 
     if (m_serverId.isNull() || m_serverId.isEmpty()) {
         qCWarning(m_logCategory) << "No machine identifier available.";
@@ -708,44 +1287,43 @@ void PlexMedia::sendCommand(const QString& type, const QString& entityId, int co
     }
 
     // check we have a player identifier so we have something to control
-    if (m_playerId.isNull() || m_playerId.isEmpty()) {
+    if (playerId().isNull() || playerId().isEmpty()) {
         qCWarning(m_logCategory) << "No player identifier available. No players discovered.";
         return;
     }
 
     if (command == MediaPlayerDef::C_PLAY) {
-        getRequest(m_playerURL + "/player/playback/play", "");  // normal play without browsing
+        play();  // normal play without browsing
     } else if (command == MediaPlayerDef::C_PLAY_ITEM || command == MediaPlayerDef::C_SHUFFLE) {
         if (param == "") {
-            getRequest(m_playerURL + "/player/playback/play", ""); //nothing passed then just play?
+            play(); //nothing passed then just play?
         } else {
             QString shuffle = "0";
             if (command == MediaPlayerDef::C_SHUFFLE_PLAY) shuffle = "1";
             if (param.toMap().contains("type")) {
+                // confirmed once another item, or the same one in a new play queue, is playing
+                m_commands->expect(PlexCommandQueue::MEDIA,
+                                   player().currentTrack + "/" + QString::number(player().queueItem),
+                                   command == MediaPlayerDef::C_SHUFFLE ? "SHUFFLE" : "PLAY_ITEM");
                 if (param.toMap().value("type").toString() == "playlist") {
                     //need to use playQueues
                     QString  url     = m_serverURL + "/playQueues";
                     QString message = "?playlistID=";
                     message = message + param.toMap().value("id").toString() + "&shuffle="+ shuffle +"&continuous=0&type=audio"; //only support audio playlist at the moment
-                    QObject* context = new QObject(this);
-                    QObject::connect(this, &PlexMedia::requestReady, context,
-                                     [=](const QVariantMap& map, const QString& rUrl) {
-                                         qCDebug(m_logCategory) << "playPlaylist returned URL is: " << rUrl << ", requested URL is " << url;
-                                         if (rUrl == url) {
-                                             QString url = m_playerURL + "/player/playback/playMedia";
-                                             QString message = "?key=/library/metadata/";
-                                             message = message + param.toMap().value("id").toString() + "&offset=0&address=" + m_serverIP + "&port=" + m_serverPort + "&machineIdentifier=" + m_serverId;
-                                             message = message + "&containerKey=/playQueues/" + map.value("MediaContainer").toMap().value("playQueueID").toString() + "&window=200&own=1";
-                                             getRequest(url, message);
-                                         }
-                                         context->deleteLater();
-                                     });
-                    postRequest(url, message);
+                    postRequest(url, message)->then(this, [=](const PlexMediaContainer& container) {
+                        qCDebug(m_logCategory) << "playPlaylist returned for URL " << url;
+                        QString message = "?key=/library/metadata/";
+                        message = message + param.toMap().value("id").toString() + "&offset=0&address=" + m_serverIP + "&port=" + m_serverPort + "&machineIdentifier=" + m_serverId;
+                        message = message + "&containerKey=/playQueues/" + container.playQueue.id + "&window=200&own=1";
+                        m_commands->push("/player/playback/playMedia", message, PlexCommandQueue::MEDIA);
+                    })->onError(this, [=](const QString& error) {
+                        Q_UNUSED(error)
+                        m_commands->fail(PlexCommandQueue::MEDIA);  // no play queue, nothing to play
+                    });
                 } else {
-                    QString  url     = m_playerURL + "/player/playback/playMedia";
                     QString message = "?key=/library/metadata/";
                     message = message + param.toMap().value("id").toString() + "&offset=0&address=" + m_serverIP + "&port=" + m_serverPort + "&machineIdentifier=" + m_serverId;
-                    getRequest(url, message);
+                    m_commands->push("/player/playback/playMedia", message, PlexCommandQueue::MEDIA);
                 }
             }
         }
@@ -753,8 +1331,8 @@ void PlexMedia::sendCommand(const QString& type, const QString& entityId, int co
         if (param.toMap().contains("type")) {
             if (param.toMap().value("type").toString() != "playlist") { // do not allow playlists to be added to the queue
                 qCDebug(m_logCategory) << "ADD ITEMS(S) TO QUEUE";
-                if (!(m_playerQueue.isNull() || m_playerQueue.isEmpty())) { // add to Now Playing
-                    QString url     = m_serverURL + "/playQueues/" + m_playerQueue;
+                if (!(player().queue.isNull() || player().queue.isEmpty())) { // add to Now Playing
+                    QString url     = m_serverURL + "/playQueues/" + player().queue;
                     // appears to be a bug with Plex which intermittently gets fixed where this may act as "Add Next" if adding to an already defined playlist.
                     QString type_class;
                     if (param.toMap().value("type").toString() == "track" || param.toMap().value("type").toString() == "artist" || param.toMap().value("type").toString() == "album") {
@@ -763,33 +1341,46 @@ void PlexMedia::sendCommand(const QString& type, const QString& entityId, int co
                         type_class = "video";
                     }
                     QString message = "?type=" + type_class + "&uri=server://" + m_serverId + "/com.plexapp.plugins.library/library/metadata/" + param.toMap().value("id").toString() + "&repeat=0&own=1&includeChapters=1";
-                    putRequest(url, message);
-                    url = m_playerURL + "/player/playback/refreshPlayQueue";
-                    if (!(m_playerPlatform == "iOS")) { // currently crashes plex player in iOS! Have to rely on the natural order of things.
-                        message = "?playQueueID=" + m_playerQueue;// refresh playQueue after adding to it.
-                        getRequest(url, message);
-                    }
+                    QString queueId = player().queue;
+                    putRequest(url, message)->then(this, [=](const PlexMediaContainer& queue) {
+                        // the reply is the updated queue with its new version, no need to download it again
+                        if (queueId == player().queue && queue.playQueue.id == player().queue) {
+                            m_playQueue.update(queue);
+                            player().queueVersion = queue.playQueue.version;
+                        }
+                        if (!(player().session.player.platform == "iOS")) { // currently crashes plex player in iOS! Have to rely on the natural order of things.
+                            m_commands->push("/player/playback/refreshPlayQueue", "?playQueueID=" + queueId);// refresh playQueue after adding to it.
+                        }
+                    });
                 }
             }
         }
     } else if (command == MediaPlayerDef::C_PAUSE) {
-        getRequest(m_playerURL + "/player/playback/pause", "");
-        m_playerState = "paused";
+        m_commands->expect(PlexCommandQueue::STATE, "paused", "PAUSE");
+        m_commands->push(PlexCommandQueue::STATE, "paused");
+        player().state = "paused";
+        m_progressClock->pause();
         // if we are pausing then we are moving from a direct to indirect connection. Therefore update the button immeadiately otherwise we have to wait while the integration sorts itself out.
-        EntityInterface* entity = static_cast<EntityInterface*>(m_entities->getEntityInterface(m_entityId));
-        if (entity) { entity->updateAttrByIndex(MediaPlayerDef::STATE, MediaPlayerDef::IDLE); }
+        m_entityState->update(MediaPlayerDef::STATE, MediaPlayerDef::IDLE);
     } else if (command == MediaPlayerDef::C_NEXT) {
-        getRequest(m_playerURL + "/player/playback/skipNext", "");
+        m_commands->expect(PlexCommandQueue::SKIP, player().currentTrack, "NEXT");
+        m_commands->push(PlexCommandQueue::SKIP, 1);
+        showQueueItem(1);
         m_newTrack = true; // this would be picked up by the polling but better to pre-empt it and speed everything up a bit.
     } else if (command == MediaPlayerDef::C_PREVIOUS) {
-        getRequest(m_playerURL + "/player/playback/skipPrevious", "");
+        m_commands->expect(PlexCommandQueue::SKIP, player().currentTrack, "PREVIOUS");
+        m_commands->push(PlexCommandQueue::SKIP, -1);
+        showQueueItem(-1);
         m_newTrack = true; // as above
+    } else if (command == MediaPlayerDef::C_SEEK) {
+        seek(param.toLongLong() * 1000);
     } else if (command == MediaPlayerDef::C_VOLUME_SET) {
-        getRequest(m_playerURL + "/player/playback/setParameters", "?volume=" + param.toString());
+        setVolume(param.toInt(), "VOLUME_SET");
     } else if (command == MediaPlayerDef::C_VOLUME_UP) {
-        getRequest(m_playerURL + "/player/playback/setParameters", "?volume=" + QString::number(m_playerVol + 5)); // this should probably be standardised for API based integrations?
+        // steps from the volume already asked for, not from the last one the player reported
+        setVolume(m_commands->expected(PlexCommandQueue::VOLUME, player().volume).toInt() + 5, "VOLUME_UP"); // this should probably be standardised for API based integrations?
     } else if (command == MediaPlayerDef::C_VOLUME_DOWN) {
-        getRequest(m_playerURL + "/player/playback/setParameters", "?volume=" + QString::number(m_playerVol - 5));; // this should probably be standardised for API based integrations?
+        setVolume(m_commands->expected(PlexCommandQueue::VOLUME, player().volume).toInt() - 5, "VOLUME_DOWN");
     } else if (command == MediaPlayerDef::C_SEARCH) {
         search(param.toString());
     } else if (command == MediaPlayerDef::C_GETALBUM) {
@@ -808,15 +1399,46 @@ void PlexMedia::sendCommand(const QString& type, const QString& entityId, int co
     }
 }
 
+// player commands that show their expected result straight away, confirmed or rolled back by the timeline
+void PlexMedia::play() {
+    m_commands->expect(PlexCommandQueue::STATE, "playing", "PLAY");
+    m_commands->push(PlexCommandQueue::STATE, "playing");
+    m_entityState->update(MediaPlayerDef::STATE, MediaPlayerDef::PLAYING);
+}
+
+void PlexMedia::seek(qint64 offset) {
+    m_commands->expect(PlexCommandQueue::SEEK, offset, "SEEK");
+    m_commands->push(PlexCommandQueue::SEEK, offset);
+    m_sessionTable.sample(playerId(), offset, player().state == "playing");
+    m_progressClock->sample(player().timelineKey, offset, player().duration, player().state == "playing");
+}
+
+void PlexMedia::setVolume(int volume, const QString& command) {
+    volume = qBound(0, volume, 100);
+    m_commands->expect(PlexCommandQueue::VOLUME, volume, command);
+    m_commands->push(PlexCommandQueue::VOLUME, volume);
+    m_entityState->update(MediaPlayerDef::VOLUME, volume);
+}
+
 void PlexMedia::changeSpeaker(const QString& id) {
     qCDebug(m_logCategory) << "CHANGE SPEAKER";
-    m_playerId = id;
-    m_playerURL = ""; // reset URL - acts a flag to not poll the old player
-    m_playerPort = "0"; //reset port
-    m_directConn = false; // player has changed so direct control is no longer possible.
+    if (id == playerId()) {
+        return;
+    }
+    m_commands->clear(); // meant for the old player
+    // the old player's state stays in its entry. A player without a session starts from scratch: port unknown, no
+    // direct connection and no URL, so it is not polled before it is found.
+    m_sessionTable.setActive(id);
+    player().currentTrack = "0"; // fetch the metadata of what this player plays
+
+    // a player with a session was tracked all along: carry on where we left it and show it straight away
+    if (m_sessionTable.contains(id)) {
+        m_entityState->update(MediaPlayerDef::VOLUME, player().volume);
+        updateSessions(allSessions());
+    }
 }
 
-void PlexMedia::getSpeakers(const QVariantMap& map) {
+void PlexMedia::getSpeakers(const QVector<PlexSession>& players) {
     qCDebug(m_logCategory) << "GET SPEAKERS";
     QString id = "";
     QString title = "";
@@ -827,120 +1449,64 @@ void PlexMedia::getSpeakers(const QVariantMap& map) {
     QStringList supported = {}; // default
     SpeakerModel* allPlayers = new SpeakerModel(nullptr, id, title, description, type, image, commands, supported);
     //Loop through all players.
-    QVariantList players = map.value("MediaContainer").toMap().value("Metadata").toList();
-    //qCDebug(m_logCategory) << "Number of players found: " << players.length();
-    for (int i = 0; i < players.length(); i++) {
-        id       = players[i].toMap().value("Player").toMap().value("machineIdentifier").toString();
+    //qCDebug(m_logCategory) << "Number of players found: " << players.size();
+    for (int i = 0; i < players.size(); i++) {
+        id       = players[i].player.machineIdentifier;
 
-        title    = players[i].toMap().value("Player").toMap().value("title").toString();
-        if (players[i].toMap().value("Player").toMap().value("machineIdentifier").toString() == m_playerId) {
+        title    = players[i].player.title;
+        if (players[i].player.machineIdentifier == playerId()) {
             title += " (Connected)";
-            QStringList commands = {}; // typically cannot control remote devices
         } else {
-            if (players[i].toMap().value("Player").toMap().value("local").toBool()) {
+            if (players[i].player.local) {
                 title += " (Local)";
-                QStringList commands = {"CONNECT"};
             } else {
                 title += " (Remote)";
-                QStringList commands = {}; // typically cannot control remote devices
             }
         }
 
-        description = players[i].toMap().value("title").toString();
+        description = players[i].item.title;
         if (description.length() == 0) { description = "Unknown"; }
-        description += " (" + players[i].toMap().value("librarySectionTitle").toString() + ")";
+        description += " (" + players[i].item.librarySectionTitle + ")";
 
-        image    = players[i].toMap().value("User").toMap().value("thumb").toString();
+        image    = players[i].userThumb;
         allPlayers->addItem(id, title, description, type, image, commands, supported);
     }
+    m_dispatcher->adopt(allPlayers);
+
     // update the entity
-    EntityInterface* entity = static_cast<EntityInterface*>(m_entities->getEntityInterface(m_entityId));
-    if (entity) {
-        MediaPlayerInterface* me = static_cast<MediaPlayerInterface*>(entity->getSpecificInterface());
-        me->setSpeakerModel(allPlayers);
-    }
+    EntitiesInterface* entities = m_entities;
+    QString            entityId = m_entityId;
+    m_dispatcher->post([entities, entityId, allPlayers]() {
+        EntityInterface* entity = static_cast<EntityInterface*>(entities->getEntityInterface(entityId));
+        if (entity) {
+            MediaPlayerInterface* me = static_cast<MediaPlayerInterface*>(entity->getSpecificInterface());
+            me->setSpeakerModel(allPlayers);
+        }
+    });
     m_speakerRequest = false;
 }
 
 void PlexMedia::updateEntity(const QString& entity_id, const QVariantMap& attr) {
-    EntityInterface* entity = static_cast<EntityInterface*>(m_entities->getEntityInterface(entity_id));
-    if (entity) {
-        // update the media player
-        entity->updateAttrByIndex(MediaPlayerDef::Attributes::STATE, attr.value("state").toInt());
-        entity->updateAttrByIndex(MediaPlayerDef::Attributes::SOURCE, attr.value("device").toString());
-        entity->updateAttrByIndex(MediaPlayerDef::Attributes::VOLUME, attr.value("volume").toInt());
-        entity->updateAttrByIndex(MediaPlayerDef::Attributes::MEDIATITLE, attr.value("title").toString());
-        entity->updateAttrByIndex(MediaPlayerDef::Attributes::MEDIAARTIST, attr.value("artist").toString());
-        entity->updateAttrByIndex(MediaPlayerDef::Attributes::MEDIAIMAGE, attr.value("image").toString());
-    }
+    EntitiesInterface* entities = m_entities;
+    m_dispatcher->post([entities, entity_id, attr]() {
+        EntityInterface* entity = static_cast<EntityInterface*>(entities->getEntityInterface(entity_id));
+        if (entity) {
+            // update the media player
+            entity->updateAttrByIndex(MediaPlayerDef::Attributes::STATE, attr.value("state").toInt());
+            entity->updateAttrByIndex(MediaPlayerDef::Attributes::SOURCE, attr.value("device").toString());
+            entity->updateAttrByIndex(MediaPlayerDef::Attributes::VOLUME, attr.value("volume").toInt());
+            entity->updateAttrByIndex(MediaPlayerDef::Attributes::MEDIATITLE, attr.value("title").toString());
+            entity->updateAttrByIndex(MediaPlayerDef::Attributes::MEDIAARTIST, attr.value("artist").toString());
+            entity->updateAttrByIndex(MediaPlayerDef::Attributes::MEDIAIMAGE, attr.value("image").toString());
+        }
+    });
 }
 
 void PlexMedia::getPollRequest(const QString& url, const QString& params) {
-    EntityInterface* entity = static_cast<EntityInterface*>(m_entities->getEntityInterface(m_entityId));
-    if (entity) {
-        if (m_pollingTimer->interval() > 2000) { m_pollingTimer->setInterval(2000); } // if we are actively and directly polling a client then turn up the heat!
-        // create new networkacces manager and request
-        QNetworkAccessManager* manager = new QNetworkAccessManager(this);
-        QNetworkRequest        request;
-
-        QObject* context = new QObject(this);
-        // connect to finish signal
-        QObject::connect(manager, &QNetworkAccessManager::finished, context, [=](QNetworkReply* reply) {
-            int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-            if (statusCode != 200) {
-                qCWarning(m_logCategory) << "ERROR WITH POLL GET REQUEST " << statusCode << reply->readAll();
-                // Note: status code of 0 indicates connection was accepted but an empty response was returned.
-                qCDebug(m_logCategory) << "POLLING DID NOT RETURN VALID RESPONSE. NO DIRECT CONNECTION ASSUMED";
-                m_directConn = false;
-            } else {
-                QString     answer = reply->readAll();
-                //qCDebug(m_logCategory) << "Response from POLL GET: " << answer;
-
-                QDomDocument doc;
-                if (!doc.setContent(answer,true)) return;
-
-                QDomNodeList timelines = doc.elementsByTagName("Timeline");
-                //run through and overwrite in order - photos - video - music
-                for (int i = 0; i < timelines.size(); i++) {
-                    QDomElement n = timelines.item(i).toElement();
-                    if (n.attribute("state") != "stopped") {
-                        m_playerVol = n.attribute("volume").toInt();
-                        m_playerQueue = n.attribute("playQueueID");
-                        m_playerState = n.attribute("state");
-                        m_playerDuration = n.attribute("duration").toInt();
-                        m_playerTime = n.attribute("time").toInt();
-                        if (m_playerCurrentTrack == n.attribute("ratingKey")) {
-                            m_newTrack = false;
-                        } else {
-                            m_newTrack = true;
-                        }
-                        //qCDebug(m_logCategory) << "State is: " << m_playerState << ", Progress is: " << static_cast<int>(m_playerTime/1000) << " of " << static_cast<int>(m_playerDuration/1000);
-                    }
-                }
-
-                entity->updateAttrByIndex(MediaPlayerDef::VOLUME, m_playerVol);
-
-                // get the state
-                if (m_playerState == "playing") {
-                    entity->updateAttrByIndex(MediaPlayerDef::STATE, MediaPlayerDef::PLAYING);
-                } else {
-                    entity->updateAttrByIndex(MediaPlayerDef::STATE, MediaPlayerDef::IDLE);
-                }
-
-                // update progress
-                entity->updateAttrByIndex(MediaPlayerDef::MEDIADURATION, static_cast<int>(m_playerDuration / 1000));
-                entity->updateAttrByIndex(MediaPlayerDef::MEDIAPROGRESS, static_cast<int>(m_playerTime / 1000));
-                m_directConn = true;
-            }
-
-            reply->deleteLater();
-            context->deleteLater();
-            manager->deleteLater();
-        });
-
-        QObject::connect(
-            manager, &QNetworkAccessManager::networkAccessibleChanged, context,
-            [=](QNetworkAccessManager::NetworkAccessibility accessibility) { qCDebug(m_logCategory) << accessibility; });
+    if (hasEntity(m_entityId)) {
+        QString endpoint = "timeline " + playerId(); // each player backs off on its own when it does not answer
+        if (!m_pollScheduler->acquire(endpoint)) { return; } // the player has not answered the last poll yet.
+        QNetworkRequest request;
 
         // set headers
         //request.setRawHeader("Accept", "application/json"); //only responds in XML.
@@ -949,7 +1515,7 @@ void PlexMedia::getPollRequest(const QString& url, const QString& params) {
         request.setRawHeader("X-Plex-Device", m_remoteSys);
         request.setRawHeader("X-Plex-Device-Name", m_remoteName);
         request.setRawHeader("X-Plex-Provides", "controller");
-        request.setRawHeader("X-Plex-Target-Client-Identifier", m_playerId.toLocal8Bit());
+        request.setRawHeader("X-Plex-Target-Client-Identifier", playerId().toLocal8Bit());
 
         // set the URL
         if (params.length() > 0) request.setUrl(QUrl::fromUserInput(url + params + "&commandId=" +  QString::number(m_cmdId)));
@@ -957,66 +1523,327 @@ void PlexMedia::getPollRequest(const QString& url, const QString& params) {
 
         //qCDebug(m_logCategory) << "Sending as POLL GET: " << request.url().toString();
 
-        // send the get request
-        manager->get(request);
+        // send the get request over the shared client
+        PlexRequest* handle = m_pollScheduler->track(endpoint, m_http->get(request));
+        handle->onReply(this, [=](int statusCode, const QByteArray& body) {
+            if (statusCode != 200) {
+                qCWarning(m_logCategory) << "ERROR WITH POLL GET REQUEST " << statusCode << body;
+                // Note: status code of 0 indicates connection was accepted but an empty response was returned.
+                qCDebug(m_logCategory) << "POLLING DID NOT RETURN VALID RESPONSE. NO DIRECT CONNECTION ASSUMED";
+                player().directConn = false;
+            } else if (updateTimeline(body)) {
+                player().directConn = true;
+            }
+        });
         m_cmdId++;
     }
 }
 
-void PlexMedia::getRequest(const QString& url, const QString& params) {
-    if (m_authToken.isNull() || m_authToken.isEmpty()) {
-        qCWarning(m_logCategory) << "No access token available.";
-        requestAuthToken();
+bool PlexMedia::updateTimeline(const QByteArray& xml) {
+    if (!hasEntity(m_entityId)) {
+        return false;
+    }
+
+    PlexTimeline timeline;
+    if (!PlexTimelineDecoder::decode(xml, &timeline)) return false;
+
+    qint64 queueItem = 0;
+    if (timeline.active) {
+        player().volume = timeline.volume;
+        if (timeline.playQueueID != player().queue) player().queueVersion = 0; // another queue
+        player().queue = timeline.playQueueID;
+        if (timeline.playQueueVersion >= 0) player().queueVersion = timeline.playQueueVersion;
+        queueItem = timeline.playQueueItemID;
+        player().state = timeline.state;
+        player().duration = timeline.duration;
+        player().timelineKey = timeline.ratingKey;
+        m_newTrack = player().currentTrack != timeline.ratingKey;
+        //qCDebug(m_logCategory) << "State is: " << player().state << ", Progress is: " << static_cast<int>(timeline.time/1000) << " of " << static_cast<int>(timeline.duration/1000);
+    }
+
+    // commands still on their way keep showing what was asked for
+    m_entityState->update(MediaPlayerDef::VOLUME,
+                          m_commands->reconcile(PlexCommandQueue::VOLUME, player().volume).toInt());
+    m_commands->reconcile(PlexCommandQueue::SKIP, player().timelineKey);
+    m_commands->reconcile(PlexCommandQueue::MEDIA,
+                          (timeline.active ? timeline.ratingKey : QString()) + "/" + QString::number(queueItem));
+    bool skipping = m_commands->expecting(PlexCommandQueue::SKIP);  // already showing the item it lands on
+    if (!skipping) player().queueItem = queueItem;
+    syncPlayQueue(PlexRequest::ContainerHandler());
+
+    // get the state
+    m_pollScheduler->setActivity(player().state == "playing" ? PlexPollScheduler::PLAYING
+                                                             : PlexPollScheduler::PAUSED);
+    if (m_commands->reconcile(PlexCommandQueue::STATE, player().state).toString() == "playing") {
+        m_entityState->update(MediaPlayerDef::STATE, MediaPlayerDef::PLAYING);
+    } else {
+        m_entityState->update(MediaPlayerDef::STATE, MediaPlayerDef::IDLE);
+    }
+
+    // update progress
+    if (skipping) return true;
+    m_entityState->update(MediaPlayerDef::MEDIADURATION, static_cast<int>(player().duration / 1000));
+    if (timeline.active &&
+        m_commands->reconcile(PlexCommandQueue::SEEK, timeline.time).toLongLong() == timeline.time) {
+        m_sessionTable.sample(playerId(), timeline.time, player().state == "playing");
+        m_progressClock->sample(player().timelineKey, timeline.time, player().duration, player().state == "playing");
+    }
+    return true;
+}
+
+void PlexMedia::syncPlayQueue(PlexRequest::ContainerHandler handler) {
+    if (player().queue.isEmpty()) {
+        return;
+    }
+
+    // the cached window is current while the player reports the same queue version and plays inside it
+    if (m_playQueue.isCurrent(player().queue, player().queueVersion) &&
+        m_playQueue.covers(player().queueItem, PREFETCH_QUEUE)) {
+        prefetchQueueArtwork();
+        if (handler) handler(m_playQueue.container());
+        return;
+    }
+
+    // one download at a time, later callers wait for it
+    if (!m_playQueueRequest.isNull()) {
+        if (handler) {
+            m_playQueueRequest->then(this, [=](const PlexMediaContainer&) { handler(m_playQueue.container()); });
+        }
         return;
     }
 
-    // create new networkacces manager and request
-    QNetworkAccessManager* manager = new QNetworkAccessManager(this);
-    QNetworkRequest        request;
+    // only a window around the playing item
+    QString params = "?window=" + QString::number(PLAY_QUEUE_WINDOW);
+    if (player().queueItem > 0) params += "&center=" + QString::number(player().queueItem);
+
+    QString server = player().session.server.isEmpty() ? m_serverURL : player().session.server;
+    m_playQueueRequest = getRequest(server + "/playQueues/" + player().queue, params);
+    m_playQueueRequest->then(this, [=](const PlexMediaContainer& queue) {
+        m_playQueue.update(queue);
+        if (player().queueVersion == 0) player().queueVersion = queue.playQueue.version; // not every player reports it
+        prefetchQueueArtwork();
+        if (handler) handler(m_playQueue.container());
+    });
+}
 
-    QObject* context = new QObject(this);
+void PlexMedia::prefetchQueueArtwork() {
+    // artwork of what plays next, once per item
+    if (player().queueItem == m_prefetchedQueueItem) {
+        return;
+    }
+    m_prefetchedQueueItem = player().queueItem;
+    for (int i = 1; i <= PREFETCH_QUEUE; i++) {
+        const PlexMetadataItem* next = m_playQueue.item(player().queueItem, i);
+        if (!next) break;
+        m_artwork->prefetch(next->image(), PlexArtwork::ARTWORK);
+    }
+}
 
-    // connect to finish signal
-    QObject::connect(manager, &QNetworkAccessManager::finished, context, [=](QNetworkReply* reply) {
-        if (reply->error()) {
-            qCWarning(m_logCategory) << reply->errorString();
+void PlexMedia::showQueueItem(int offset) {
+    // the item a skip lands on is already in the cached window, show it before the player gets there
+    if (!m_playQueue.isCurrent(player().queue, player().queueVersion)) {
+        return;
+    }
+    const PlexMetadataItem* item = m_playQueue.item(player().queueItem, offset);
+    if (!item) {
+        return;
+    }
+    player().queueItem = item->playQueueItemID;
+    showArtwork(item->image());
+    m_entityState->update(MediaPlayerDef::MEDIATITLE, item->title);
+    m_entityState->update(MediaPlayerDef::MEDIAARTIST, mediaArtist(*item));
+    m_entityState->update(MediaPlayerDef::MEDIADURATION, static_cast<int>(item->duration / 1000));
+    m_progressClock->sample(item->ratingKey, 0, item->duration, player().state == "playing");
+    prefetchQueueArtwork();
+}
+
+void PlexMedia::showArtwork(const QString& thumb) {
+    // the transcode URL only works for the UI where the server allows the remote without a token. Downloaded with
+    // the token in the background, the cached file replaces it (see the cached signal in the constructor).
+    m_playerThumb = thumb;
+    m_artwork->prefetch(thumb, PlexArtwork::ARTWORK);
+    m_entityState->update(MediaPlayerDef::MEDIAIMAGE, m_artwork->url(thumb, PlexArtwork::ARTWORK));
+}
+
+void PlexMedia::onTimelineReceived(const QByteArray& xml) {
+    if (updateTimeline(xml)) {
+        player().directConn = true;
+        if (m_newTrack) {
+            getCurrentPlayer();  // fetch the new track's metadata straight away instead of waiting for the next tick
         }
+    }
+}
 
-        QString     answer = reply->readAll();
-        //qCDebug(m_logCategory) << "Response from GET: " << answer;
+void PlexMedia::openNotifications() {
+    // opening the URL that is already open does nothing, another server address reconnects
+    if (!m_notificationMode || m_authToken.isEmpty()) {
+        return;
+    }
+    QUrl url(m_serverURL + "/:/websockets/notifications");
+    url.setScheme("ws");
+    url.setQuery("X-Plex-Token=" + m_authToken);
+    m_notifications->open(url);
+}
 
-        if (answer != "") {
-            QVariantMap map;
-            // convert to json
-            QJsonParseError parseerror;
-            QJsonDocument   doc = QJsonDocument::fromJson(answer.toUtf8(), &parseerror);
-            if (parseerror.error != QJsonParseError::NoError) {
-                qCWarning(m_logCategory) << "JSON error : " << parseerror.errorString();
-                return;
+void PlexMedia::onNotificationsConnected() {
+    qCDebug(m_logCategory) << "Server notifications connected";
+    // events may have been missed while disconnected
+    m_sessionsStale = true;
+    getCurrentPlayer();
+}
+
+void PlexMedia::onNotificationsDisconnected() {
+    qCDebug(m_logCategory) << "Server notifications disconnected, downloading sessions instead.";
+    m_sessionsStale = true;
+}
+
+void PlexMedia::onPlaySessionStateChanged(const QVector<PlexPlaySessionState>& states) {
+    bool changed = false;
+    for (const PlexPlaySessionState& state : states) {
+        int index = -1;
+        for (int i = 0; i < m_sessions.size(); i++) {
+            if (m_sessions[i].player.machineIdentifier == state.clientIdentifier) {
+                index = i;
+                break;
             }
+        }
+
+        if (index < 0 || m_sessions[index].item.ratingKey != state.ratingKey) {
+            // new session or a different track, the notification does not carry the metadata we need
+            if (state.state != "stopped") m_sessionsStale = true;
+            continue;
+        }
+        if (state.state == "stopped") {
+            m_sessions.remove(index);
+        } else {
+            m_sessions[index].player.state = state.state;
+            m_sessions[index].item.viewOffset = state.viewOffset;
+        }
+        changed = true;
+    }
+
+    if (m_sessionsStale) {
+        getCurrentPlayer();
+    } else if (changed) {
+        updateSessions(allSessions());
+    }
+}
 
-            // createa a map object
-            map = doc.toVariant().toMap();
-            emit requestReady(map, url);
+void PlexMedia::onLibraryTimelineChanged(const QVector<PlexTimelineEntry>& entries) {
+    m_libraryIndex->changed();
+
+    // metadata of a playing item changed on the server (e.g. artwork or title was edited)
+    for (const PlexTimelineEntry& entry : entries) {
+        for (const PlexSession& session : m_sessions) {
+            if (session.item.ratingKey == entry.itemID) {
+                m_sessionsStale = true;
+                return;
+            }
         }
+    }
+}
+
+void PlexMedia::onPlayerDiscovered(const PlexDiscovery::Device& device) {
+    if (device.capabilities.contains("playback")) {
+        m_startupState.players.insert(device.machineIdentifier, device.name);  // offered as an entity next time
+    }
+    if (device.machineIdentifier != playerId() || device.port.isEmpty() || device.port == player().port) {
+        return;
+    }
+    // the active player answered (again, possibly on another port): control it directly, no /clients lookup needed
+    player().port = device.port;
+    if (player().address.isEmpty()) player().address = device.address;
+    player().url = "http://" + player().address + ":" + player().port;
+    m_startupState.playerPorts.insert(playerId(), player().port);
+    qCDebug(m_logCategory) << "PORT DISCOVERED, SETTING TO: " << player().port;
+}
+
+void PlexMedia::onServerDiscovered(const PlexDiscovery::Device& device) {
+    qCDebug(m_logCategory) << "Server on the local network:" << device.name << device.address << device.port;
+    if (!m_serverDiscovery || (!m_serverId.isEmpty() && m_serverId != device.machineIdentifier)) {
+        return;  // configured by the user, or another server is already in use
+    }
+    QString port = device.port.isEmpty() ? "32400" : device.port;
+    if (device.address == m_serverIP && port == m_serverPort) {
+        return;
+    }
+    bool first = m_serverIP.isEmpty();
+    m_serverIP = device.address;
+    m_serverPort = port;
+    m_serverURL = "http://" + m_serverIP + ":" + m_serverPort;
+    m_serverId = device.machineIdentifier;  // same as /identity returns
+    m_startupState.serverURL = m_serverURL;
+    m_startupState.serverId = m_serverId;
+    saveStartupState();
+    m_artwork->setServer(m_serverURL, m_authToken);
+    m_libraryIndex->setServer(m_serverURL, m_authToken);
+
+    if (!m_authToken.isEmpty()) {
+        openNotifications();  // reconnects to the new address
+        if (first) m_libraryIndex->start();
+    }
+    m_sessionsStale = true;
+    getCurrentPlayer();
+}
 
-        reply->deleteLater();
-        context->deleteLater();
-        manager->deleteLater();
+PlexRequest* PlexMedia::sendRequest(const QByteArray& verb, QNetworkRequest request, const QByteArray& body) {
+    Q_ASSERT(QThread::currentThread() == thread());  // the HTTP client, m_cmdId and the token are not shared
+    PlexRequest* handle;
+    if (m_authToken.isEmpty()) {
+        // not signed in yet: the request waits for the token instead of being dropped
+        requestAuthToken();
+        handle = m_http->hold(verb, request, body);
+    } else {
+        request.setRawHeader("X-Plex-Token", m_authToken.toLocal8Bit());
+        if (verb == "GET") {
+            handle = m_http->get(request);
+        } else if (verb == "POST") {
+            handle = m_http->post(request, body);
+        } else {
+            handle = m_http->put(request, body);
+        }
+    }
+    handle->setTimeout(REQUEST_TIMEOUT);
+
+    // decoding and model building run on the integration's thread, long ones hold up polling and commands
+    QObject::connect(handle, &PlexRequest::finished, this, [=]() {
+        if (handle->decodeTime() + handle->handlerTime() > SLOW_REPLY * 1000) {
+            m_slowReplies++;
+            qCDebug(m_logCategory) << "Slow reply" << handle->url().path() << "decode:" << handle->decodeTime()
+                                   << "us handlers:" << handle->handlerTime() << "us";
+        }
     });
 
-    QObject::connect(
-        manager, &QNetworkAccessManager::networkAccessibleChanged, context,
-        [=](QNetworkAccessManager::NetworkAccessibility accessibility) { qCDebug(m_logCategory) << accessibility; });
+    // a stored token can have been revoked since it was saved. The server's answer tells.
+    if (request.url().toString().startsWith(m_serverURL)) {
+        handle->onReply(this, [=](int statusCode, const QByteArray& reply) {
+            Q_UNUSED(reply)
+            if (statusCode == 401 && !m_tokenVerified && !m_authToken.isEmpty() && !m_fixedToken) {
+                qCWarning(m_logCategory) << "Stored auth token was rejected, signing in again";
+                m_authToken.clear();
+                requestAuthToken();
+            } else if (statusCode >= 200 && statusCode < 300) {
+                m_tokenVerified = true;
+            }
+        });
+    }
+    return handle;
+}
+
+PlexRequest* PlexMedia::getRequest(const QString& url, const QString& params,
+                                   const QMap<QByteArray, QByteArray>& headers) {
+    QNetworkRequest request;
 
     // set headers
     request.setRawHeader("Accept", "application/json"); //need this to get a json rather than xml response from the server.
-    request.setRawHeader("X-Plex-Token", m_authToken.toLocal8Bit());
     request.setRawHeader("X-Plex-Client-Identifier", m_remoteId);
     request.setRawHeader("X-Plex-Device", m_remoteSys);
     request.setRawHeader("X-Plex-Device-Name", m_remoteName);
     request.setRawHeader("X-Plex-Provides", "controller");
-    request.setRawHeader("X-Plex-Target-Client-Identifier", m_playerId.toLocal8Bit());
+    request.setRawHeader("X-Plex-Target-Client-Identifier", playerId().toLocal8Bit());
+    for (QMap<QByteArray, QByteArray>::const_iterator iter = headers.constBegin(); iter != headers.constEnd(); ++iter) {
+        request.setRawHeader(iter.key(), iter.value());
+    }
 
     // set the URL
     if (params.length() > 0) { request.setUrl(QUrl::fromUserInput(url + params + "&commandId=" +  QString::number(m_cmdId)));
@@ -1024,67 +1851,71 @@ void PlexMedia::getRequest(const QString& url, const QString& params) {
 
     qCDebug(m_logCategory) << "Sending as GET: " + request.url().toString();
 
-    // send the get request
-    manager->get(request);
+    // send the get request over the shared client. The caller attaches its own continuations to the handle.
+    PlexRequest* handle = sendRequest("GET", request, QByteArray());
+    handle->onError(this, [=](const QString& error) { qCWarning(m_logCategory) << "ERROR WITH GET REQUEST " << url << error; });
     m_cmdId++;
+    return handle;
 }
 
-void PlexMedia::postRequest(const QString& url, const QString& params) {
-    if (m_authToken.isNull() || m_authToken.isEmpty()) {
-        qCWarning(m_logCategory) << "No access token available";
-        requestAuthToken();
-        return;
+void PlexMedia::getCachedRequest(const QString& url, const QString& params, PlexRequest::ContainerHandler handler) {
+    QString                  key = url + params;
+    PlexMetadataCache::Entry cached;
+    bool                     hit = m_metadataCache->find(key, &cached);
+    if (hit) {
+        PlexMediaContainer container;
+        if (PlexJsonDecoder::decode(cached.body, &container, nullptr)) {
+            handler(container);  // show the cached copy now, the request below only checks it is still current
+        } else {
+            m_metadataCache->remove(key);
+            hit = false;
+        }
     }
 
-    // create new networkacces manager and request
-    QNetworkAccessManager* manager = new QNetworkAccessManager(this);
-    QNetworkRequest        request;
-
-    QObject* context = new QObject(this);
+    QMap<QByteArray, QByteArray> headers;
+    if (hit && !cached.etag.isEmpty()) headers.insert("If-None-Match", cached.etag);
+    if (hit && !cached.lastModified.isEmpty()) headers.insert("If-Modified-Since", cached.lastModified);
 
-    // connect to finish signal
-    QObject::connect(manager, &QNetworkAccessManager::finished, context, [=](QNetworkReply* reply) {
-        int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-        if (statusCode != 200) {
-            qCWarning(m_logCategory) << "ERROR WITH POST REQUEST " << statusCode << reply->readAll();
-        } else {
-            QString     answer = reply->readAll();
-            //qCDebug(m_logCategory) << "Response from POST: " << answer;
-
-            if (answer != "") {
-                QVariantMap map;
-                // convert to json
-                QJsonParseError parseerror;
-                QJsonDocument   doc = QJsonDocument::fromJson(answer.toUtf8(), &parseerror);
-                if (parseerror.error != QJsonParseError::NoError) {
-                    qCWarning(m_logCategory) << "JSON error : " << parseerror.errorString();
-                    return;
-                }
-                // createa a map object
-                map = doc.toVariant().toMap();
-                emit requestReady(map, url);
-            }
+    PlexRequest* handle = getRequest(url, params, headers);
+    handle->onReply(this, [=](int statusCode, const QByteArray& body) {
+        if (statusCode != 200 || body.isEmpty()) {
+            return;  // 304 not modified, or an error that getRequest has logged already
+        }
+        if (hit && body == cached.body) {
+            return;
+        }
 
+        PlexMediaContainer container;
+        QString            error;
+        if (!PlexJsonDecoder::decode(body, &container, &error)) {
+            qCWarning(m_logCategory) << "JSON error : " << error << url;
+            return;
         }
 
-        reply->deleteLater();
-        context->deleteLater();
-        manager->deleteLater();
+        PlexMetadataCache::Entry entry;
+        entry.body         = body;
+        entry.etag         = handle->rawHeader("ETag");
+        entry.lastModified = handle->rawHeader("Last-Modified");
+        entry.updatedAt    = container.updatedAt;
+        m_metadataCache->insert(key, entry);
+
+        // anything in the body may be shown (i.e. leafCount in the paging labels), rebuild whenever it changed.
+        // Unchanged listings are answered with a 304 and never get here.
+        handler(container);
     });
+}
 
-    QObject::connect(
-        manager, &QNetworkAccessManager::networkAccessibleChanged, context,
-        [=](QNetworkAccessManager::NetworkAccessibility accessibility) { qCDebug(m_logCategory) << accessibility; });
+PlexRequest* PlexMedia::postRequest(const QString& url, const QString& params) {
+    QNetworkRequest request;
 
     // set headers
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
     request.setRawHeader("Accept", "application/json");
-    request.setRawHeader("X-Plex-Token", m_authToken.toLocal8Bit());
     request.setRawHeader("X-Plex-Client-Identifier", m_remoteId);
     request.setRawHeader("X-Plex-Device", m_remoteSys);
     request.setRawHeader("X-Plex-Device-Name", m_remoteName);
     request.setRawHeader("X-Plex-Provides", "controller");
-    request.setRawHeader("X-Plex-Target-Client-Identifier", m_playerId.toLocal8Bit());
+    request.setRawHeader("X-Plex-Target-Client-Identifier", playerId().toLocal8Bit());
 
     // set the URL
     if (params.length() > 0) { request.setUrl(QUrl::fromUserInput(url + params + "&commandId=" +  QString::number(m_cmdId)));
@@ -1092,48 +1923,24 @@ void PlexMedia::postRequest(const QString& url, const QString& params) {
 
     qCDebug(m_logCategory) << "Sending as POST: " << request.url().toString();
 
-    // send the get request
-    manager->post(request, "");
+    // send the post request over the shared client
+    PlexRequest* handle = sendRequest("POST", request, QByteArray());
+    handle->onError(this, [=](const QString& error) { qCWarning(m_logCategory) << "ERROR WITH POST REQUEST " << url << error; });
     m_cmdId++;
+    return handle;
 }
 
-void PlexMedia::putRequest(const QString& url, const QString& params) {
-    if (m_authToken.isNull() || m_authToken.isEmpty()) {
-        qCWarning(m_logCategory) << "No access token available";
-        requestAuthToken();
-        return;
-    }
-
-    // create new networkacces manager and request
-    QNetworkAccessManager* manager = new QNetworkAccessManager(this);
-    QNetworkRequest        request;
-
-    QObject* context = new QObject(this);
-
-    // connect to finish signal
-    QObject::connect(manager, &QNetworkAccessManager::finished, context, [=](QNetworkReply* reply) {
-        int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-        if (statusCode != 200) {
-            qCWarning(m_logCategory) << "ERROR WITH PUT REQUEST " << statusCode << reply->readAll();
-        }
-        reply->deleteLater();
-        context->deleteLater();
-        manager->deleteLater();
-    });
-
-    QObject::connect(
-        manager, &QNetworkAccessManager::networkAccessibleChanged, context,
-        [=](QNetworkAccessManager::NetworkAccessibility accessibility) { qCDebug(m_logCategory) << accessibility; });
+PlexRequest* PlexMedia::putRequest(const QString& url, const QString& params) {
+    QNetworkRequest request;
 
     // set headers
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
     request.setRawHeader("Accept", "application/json");
-    request.setRawHeader("X-Plex-Token", m_authToken.toLocal8Bit());
     request.setRawHeader("X-Plex-Client-Identifier", m_remoteId);
     request.setRawHeader("X-Plex-Device", m_remoteSys);
     request.setRawHeader("X-Plex-Device-Name", m_remoteName);
     request.setRawHeader("X-Plex-Provides", "controller");
-    request.setRawHeader("X-Plex-Target-Client-Identifier", m_playerId.toLocal8Bit());
+    request.setRawHeader("X-Plex-Target-Client-Identifier", playerId().toLocal8Bit());
 
     // set the URL
     if (params.length() > 0) { request.setUrl(QUrl::fromUserInput(url + params + "&commandId=" +  QString::number(m_cmdId)));
@@ -1141,19 +1948,27 @@ void PlexMedia::putRequest(const QString& url, const QString& params) {
 
     qCDebug(m_logCategory) << "Sending as PUT: " << request.url().toString();
 
-    // send the put request
-    manager->put(request, "");
+    // send the put request over the shared client
+    PlexRequest* handle = sendRequest("PUT", request, QByteArray());
+    handle->onError(this, [=](const QString& error) { qCWarning(m_logCategory) << "ERROR WITH PUT REQUEST " << url << error; });
     m_cmdId++;
+    return handle;
 }
 
 void PlexMedia::onPollingTimerTimeout() { getCurrentPlayer(); }
 
 
 void PlexMedia::updateBrowseModel(BrowseModel * model) {
+    m_dispatcher->adopt(model);
+
     // update the entity
-    EntityInterface* entity = static_cast<EntityInterface*>(m_entities->getEntityInterface(m_entityId));
-    if (entity) {
-        MediaPlayerInterface* me = static_cast<MediaPlayerInterface*>(entity->getSpecificInterface());
-        me->setBrowseModel(model);
-    }
+    EntitiesInterface* entities = m_entities;
+    QString            entityId = m_entityId;
+    m_dispatcher->post([entities, entityId, model]() {
+        EntityInterface* entity = static_cast<EntityInterface*>(entities->getEntityInterface(entityId));
+        if (entity) {
+            MediaPlayerInterface* me = static_cast<MediaPlayerInterface*>(entity->getSpecificInterface());
+            me->setBrowseModel(model);
+        }
+    });
 }
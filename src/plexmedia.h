@@ -22,12 +22,32 @@
 
 #pragma once
 
+#include <QElapsedTimer>
+#include <QMutex>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
+#include <QSet>
+#include <QSharedPointer>
+#include <QThread>
 #include <QTimer>
 
 #include <QSysInfo>
 
+#include "plexartwork.h"
+#include "plexcommandqueue.h"
+#include "plexdiscovery.h"
+#include "plexentitystate.h"
+#include "plexguidispatcher.h"
+#include "plexhttpclient.h"
+#include "plexlibraryindex.h"
+#include "plexmetadatacache.h"
+#include "plexnotificationclient.h"
+#include "plexpollscheduler.h"
+#include "plexprogressclock.h"
+#include "plexqueuecache.h"
+#include "plexsessiontable.h"
+#include "plexstartupstate.h"
+#include "plextimelinesubscription.h"
 #include "yio-interface/entities/mediaplayerinterface.h"
 #include "yio-model/mediaplayer/albummodel_mediaplayer.h"
 #include "yio-model/mediaplayer/searchmodel_mediaplayer.h"
@@ -39,7 +59,18 @@
 //// PLEXMEDIA FACTORY
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-const bool USE_WORKER_THREAD = false;
+const bool USE_WORKER_THREAD = false;      // networking and parsing off the GUI thread, see tests/plexmedia
+const int  REQUEST_TIMEOUT = 10000;        // ms before an unanswered request is aborted
+const int  TIMELINE_PUSH_TIMEOUT = 65000;  // ms without a pushed timeline before falling back to polling
+const int  TIMELINE_BACKOFF = 120000;      // ms of polling after that before subscribing again
+const int  BROWSE_PAGE_SIZE = 100;         // items per page of long shows and playlists
+const int  SEARCH_LIMIT = 25;              // results per type from the local library index
+const int  SEARCH_DEBOUNCE = 300;          // ms without a keystroke before the server is searched
+const int  PREFETCH_ROWS = 8;              // browse rows whose artwork is cached, roughly one screen
+const int  PREFETCH_QUEUE = 3;             // upcoming play queue items whose artwork is cached
+const int  PLAY_QUEUE_WINDOW = 25;         // play queue items downloaded around the playing one
+const int  SLOW_REPLY = 20;                // ms of decoding and handling a reply before it is logged
+const int  METRICS_INTERVAL = 60000;       // ms between writes of the request metrics file
 
 class PlexMediaPlugin : public Plugin {
     Q_OBJECT
@@ -66,6 +97,7 @@ class PlexMedia : public Integration {
  public:
     explicit PlexMedia(const QVariantMap& config, EntitiesInterface* entities, NotificationsInterface* notifications,
                      YioAPIInterface* api, ConfigInterface* configObj, Plugin* plugin);
+    ~PlexMedia() override;
 
     void sendCommand(const QString& type, const QString& entitId, int command, const QVariant& param) override;
 
@@ -75,48 +107,168 @@ class PlexMedia : public Integration {
     void enterStandby() override;
     void leaveStandby() override;
 
- signals:
-    void requestReady(const QVariantMap& obj, const QString& url);
-
  private:
     // PlexMedia API calls
     void search(QString query);
     void search(QString query, QString type);
     void getAlbum(QString id);
     void getPlaylist(QString id);
+    void getEpisodes(const QString& id, int start);  //one page of a show's episodes
     void getUserPlaylists();
+    void publishSearch(const QVector<PlexLibraryIndex::Item>& results);
+    void cancelSearch();
 
     // PlexMedia API authentication
     void getMachineIdentifier();
     void requestAuthToken();
+    void saveStartupState();
+    void saveMetrics();  //request metrics as JSON, next to the caches
 
     // PlexMedia status API calls
-    void getCurrentPlayer();  //subsribtion option is possible but not advisable as connection is not kept open.
+    void getCurrentPlayer();
 
     void updateEntity(const QString& entity_id, const QVariantMap& attr);
+    void bindEntityState(PlexEntityState* state, const QString& entityId);  //writes its changes to the entity
+    void traceEntityUpdates(PlexCommandQueue* commands, PlexEntityState* state);  //ends its traces with its flushes
+
+    // which of our entities the remote has loaded. Entities may only be looked up on the GUI thread, so that is
+    // where the cache is refreshed; here it is only read. Calls made on the GUI thread refresh it straight away.
+    struct EntityPresence {
+        QStringList   ids;      // ours, set up by the constructor
+        QMutex        mutex;
+        QSet<QString> present;  // guarded by mutex
+    };
+    void refreshEntities();
+    bool hasEntity(const QString& entityId) const;
+    bool hasEntities() const;  //any of ours
     void updateBrowseModel(BrowseModel * model);
 
-    // get and post requests
-    void getRequest(const QString& url, const QString& params);
-    void postRequest(const QString& url, const QString& params);
-    void putRequest(const QString& url, const QString& params);  // TODO(marton): change param to QUrlQuery
-                                                                 // QUrlQuery query;
+    // get and post requests. The returned handle receives the reply for this request only.
+    PlexRequest* sendRequest(const QByteArray& verb, QNetworkRequest request, const QByteArray& body);
+    PlexRequest* getRequest(const QString& url, const QString& params,
+                            const QMap<QByteArray, QByteArray>& headers = QMap<QByteArray, QByteArray>());
+    PlexRequest* postRequest(const QString& url, const QString& params);
+    PlexRequest* putRequest(const QString& url, const QString& params);  // TODO(marton): change param to QUrlQuery
+                                                                         // QUrlQuery query;
+
+    // browse listings: handler runs with the cached copy straight away and again only if the server's copy changed
+    void getCachedRequest(const QString& url, const QString& params, PlexRequest::ContainerHandler handler);
 
     void getPollRequest(const QString& url, const QString& params);  //returns player info from /client endpoint in XML format
+    bool updateTimeline(const QByteArray& xml);  //applies a polled or pushed timeline to the entity
+
+    // caches the artwork of the items that play next
+    void syncPlayQueue(PlexRequest::ContainerHandler handler);  //cached window of the current play queue
+    void prefetchQueueArtwork();
+    void showQueueItem(int offset);
+    void showArtwork(const QString& thumb);  //now playing image, the cached file once it is downloaded
+
+    // server notifications (server pushes session changes over a websocket)
+    void openNotifications();
+    void updateSessions(const QVector<PlexSession>& players);  //applies the session table to the entity
+    void getExtraSessions();  //sessions of the other servers
+    QVector<PlexSession> allSessions() const;  //sessions of every server, the configured one first
+    void updatePlayerEntities();  //one entity per player
+    void sendPlayerCommand(const QString& playerId, int command, const QVariant& param);  //through its own queue
+    PlexCommandQueue* playerCommands(const QString& playerId);  //created on its first command
+    PlexRequest*      playerRequest(const QString& playerId, const QString& path, const QString& params,
+                                    PlexCommandQueue::Route* route);  //direct if its address is known, else relayed
+    void              pollPlayerVolume(const QString& playerId);  //sessions carry no volume, its timeline does
+
+    // player commands with an expected result, shown before the player confirms it
+    void play();
+    void seek(qint64 offset);
+    void setVolume(int volume, const QString& command);  // command: the name it is traced under
 
     // speaker/source selection
     void changeSpeaker(const QString& id);  //change the speaker/source
-    void getSpeakers(const QVariantMap& map);  //returns model populated with speakers/sources
+    void getSpeakers(const QVector<PlexSession>& players);  //returns model populated with speakers/sources
 
  private slots:  // NOLINT open issue: https://github.com/cpplint/cpplint/pull/99
     void onPollingTimerTimeout();
+    void onSearchTimerTimeout();
+    void onTimelineReceived(const QByteArray& xml);
+    void onNotificationsConnected();
+    void onNotificationsDisconnected();
+    void onPlaySessionStateChanged(const QVector<PlexPlaySessionState>& states);
+    void onLibraryTimelineChanged(const QVector<PlexTimelineEntry>& entries);
+    void onPlayerDiscovered(const PlexDiscovery::Device& device);
+    void onServerDiscovered(const PlexDiscovery::Device& device);
 
  private:
     bool    m_speakerRequest = true;
     QString m_entityId;
 
-    // polling timer
-    QTimer* m_pollingTimer;
+    // polling scheduler (adaptive cadence, one poll in flight per endpoint)
+    PlexPollScheduler* m_pollScheduler;
+    int                m_pollFast = 2000;  // ms, configurable
+    int                m_pollSlow = 4000;
+    int                m_pollMax = 60000;
+
+    // local playback position between polls
+    PlexProgressClock* m_progressClock;
+
+    // shadow copy of the entity attributes, only changes are written
+    PlexEntityState* m_entityState;
+
+    // browse replies, kept across restarts and revalidated on use
+    PlexMetadataCache* m_metadataCache;
+
+    // scaled artwork, cached on disk
+    PlexArtwork* m_artwork;
+
+    // local library index, answers search without asking the server
+    PlexLibraryIndex* m_libraryIndex;
+
+    // search session: debounced server queries, only the latest one is kept
+    QTimer*                         m_searchTimer;
+    QString                         m_searchQuery;
+    QString                         m_searchType;
+    quint32                         m_searchGeneration = 0;
+    QVector<QPointer<PlexRequest> > m_searchRequests;
+    QVector<PlexLibraryIndex::Item> m_searchResults;
+    int                             m_searchesIssued = 0;
+    int                             m_searchesCancelled = 0;
+    int                             m_searchesStale = 0;
+
+    // timeline subscription
+    PlexTimelineSubscription* m_subscription;
+    bool                      m_subscriptionMode = false;  // opt-in via config
+    quint16                   m_subscriptionPort = 0;      // 0 picks a free port
+
+    // server notifications
+    PlexNotificationClient* m_notifications;
+    bool                    m_notificationMode = false;  // opt-in via config
+    bool                    m_sessionsStale = true;      // cached session table must be downloaded again
+    QVector<PlexSession>    m_sessions;                  // last known /status/sessions, patched by notifications
+    PlexSessionTable        m_sessionTable;              // every active player, and the one place their state is kept
+
+    // local network discovery of players and servers
+    PlexDiscovery* m_discovery;
+    bool           m_discoveryMode = true;     // on unless disabled in the config
+    bool           m_serverDiscovery = false;  // no server address configured, the one found on the network is used
+
+    // more servers and an entity per player (opt-in). Sign-in, connections, discovery, caches and polling are shared.
+    QStringList                           m_extraServers;        // base URLs
+    QHash<QString, QVector<PlexSession> > m_extraSessions;       // server -> its last /status/sessions
+    bool                                  m_playerEntityMode = false;
+    QHash<QString, QString>               m_playerEntities;      // entity id -> player machineIdentifier
+    QHash<QString, PlexEntityState*>      m_playerEntityStates;  // entity id -> its attributes
+    QHash<QString, PlexCommandQueue*>     m_playerCommands;      // player machineIdentifier -> its commands
+
+    // shared HTTP client (keep-alive connection pools for the server and player)
+    PlexHttpClient* m_http;
+
+    // player commands: ordered, bursts merged, expected state shown until the timeline confirms it
+    PlexCommandQueue* m_commands;
+
+    // window of the current play queue
+    PlexQueueCache        m_playQueue;
+    QPointer<PlexRequest> m_playQueueRequest;
+
+    // entity calls, run on the GUI thread. All other members are only touched on the integration's own thread.
+    PlexGuiDispatcher*             m_dispatcher;
+    QSharedPointer<EntityPresence> m_entityPresence;
 
     // PMS details
     QString m_serverIP;
@@ -129,20 +281,21 @@ class PlexMedia : public Integration {
     QByteArray m_remoteSys = "yioRemote"; //OS name
     QByteArray m_remoteName = "My YIO Remote"; //Device name
 
-    // Player details
-    QString m_playerId;
-    QString m_playerIP;
-    QString m_playerPort = "0"; //set as 0 for default (no info)
-    QString m_playerURL;
-    QString m_playerPlatform; //used to track issue and bugs with different platforms. I.e. iOS catastropically crashes out on refreshPlayQueue request (as of 18/05/2020).
-    QString m_playerQueue; //now playing queue Id
-    QString m_playerCurrentTrack = "0"; //store current track to reduce polling burden. Set as 0 for default (no info)
-    QString m_playerState;
-    int  m_playerDuration;
-    int  m_playerTime;
-    int  m_playerVol = 100; //track volume, default to max
+    // Player details. The active player's state is kept in its session table entry (port, URL, queue, volume, timeline
+    // and progress), player() and playerId() give access to it. The session's platform is used to track issues and
+    // bugs with different players, i.e. iOS catastropically crashes out on refreshPlayQueue request (as of 18/05/2020).
+    // only on the integration's own thread, like every member below that is not shared with the GUI thread
+    PlexSessionTable::Player& player() {
+        Q_ASSERT(QThread::currentThread() == thread());
+        return m_sessionTable.active();
+    }
+    const QString& playerId() const {
+        Q_ASSERT(QThread::currentThread() == thread());
+        return m_sessionTable.activeId();
+    }
+    qint64  m_prefetchedQueueItem = 0;
+    QString m_playerThumb; //thumb of the image shown on the now playing screen
     bool m_playerConnected = false;
-    bool m_directConn = true;
     bool m_newTrack = true;
     int  m_cmdId = 0; //cmdId is used by Plex to track the order of requests
 
@@ -150,4 +303,20 @@ class PlexMedia : public Integration {
     QString m_clientUser;
     QString m_clientPass;
     QString m_authToken;
+    bool    m_fixedToken = false; //token given in the config, no plex.tv sign-in
+    bool    m_tokenVerified = false; //false while the token is the stored one and the server has not accepted it yet
+    QPointer<PlexRequest> m_authRequest;
+
+    // replies that took longer than SLOW_REPLY to decode and handle
+    int m_slowReplies = 0;
+
+    // per endpoint request metrics, written to a JSON file while connected
+    QTimer* m_metricsTimer;
+    QString m_metricsFile;
+
+    // warm startup: state kept across restarts, time from connect() to the first live now playing screen
+    PlexStartupState m_startupState;
+    QString          m_startupStateFile;
+    QElapsedTimer    m_connectTimer;
+    bool             m_nowPlayingReported = false;
 };
@@ -0,0 +1,188 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "plexmetadatacache.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
+
+static const quint32 CACHE_MAGIC = 0x504c5843;  // "PLXC"
+static const quint32 CACHE_VERSION = 1;
+
+static qint64 entrySize(const QString& key, const PlexMetadataCache::Entry& entry) {
+    return key.size() * 2 + entry.body.size() + entry.etag.size() + entry.lastModified.size();
+}
+
+PlexMetadataCache::PlexMetadataCache(const QString& fileName, int maxBytes, QObject* parent)
+    : QObject(parent), m_fileName(fileName), m_maxBytes(maxBytes), m_saveTimer(new QTimer(this)) {
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(SAVE_DELAY);
+    QObject::connect(m_saveTimer, &QTimer::timeout, this, &PlexMetadataCache::save);
+}
+
+PlexMetadataCache::~PlexMetadataCache() {
+    if (m_dirty) {
+        save();
+    }
+}
+
+bool PlexMetadataCache::find(const QString& key, Entry* entry) {
+    QHash<QString, Entry>::iterator iter = m_entries.find(key);
+    if (iter == m_entries.end()) {
+        m_misses++;
+        return false;
+    }
+    m_hits++;
+    iter.value().lastUsed = ++m_clock;
+    *entry = iter.value();
+    return true;
+}
+
+void PlexMetadataCache::insert(const QString& key, const Entry& entry) {
+    remove(key);
+    if (entrySize(key, entry) > m_maxBytes) {
+        return;
+    }
+    Entry& stored = m_entries[key];
+    stored = entry;
+    stored.lastUsed = ++m_clock;
+    m_bytes += entrySize(key, stored);
+    evict();
+    scheduleSave();
+}
+
+void PlexMetadataCache::remove(const QString& key) {
+    QHash<QString, Entry>::iterator iter = m_entries.find(key);
+    if (iter != m_entries.end()) {
+        m_bytes -= entrySize(key, iter.value());
+        m_entries.erase(iter);
+        scheduleSave();
+    }
+}
+
+void PlexMetadataCache::clear() {
+    m_entries.clear();
+    m_bytes = 0;
+    scheduleSave();
+}
+
+void PlexMetadataCache::evict() {
+    while (m_bytes > m_maxBytes && !m_entries.isEmpty()) {
+        QHash<QString, Entry>::iterator oldest = m_entries.begin();
+        for (QHash<QString, Entry>::iterator iter = m_entries.begin(); iter != m_entries.end(); ++iter) {
+            if (iter.value().lastUsed < oldest.value().lastUsed) {
+                oldest = iter;
+            }
+        }
+        m_bytes -= entrySize(oldest.key(), oldest.value());
+        m_entries.erase(oldest);
+    }
+}
+
+void PlexMetadataCache::scheduleSave() {
+    m_dirty = true;
+    if (!m_saveTimer->isActive()) {
+        m_saveTimer->start();
+    }
+}
+
+bool PlexMetadataCache::load() {
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0) {
+        return false;
+    }
+
+    // read straight from the mapped file, no intermediate copy of the whole file
+    uchar* data = file.map(0, file.size());
+    if (!data) {
+        return false;
+    }
+    QByteArray  raw = QByteArray::fromRawData(reinterpret_cast<const char*>(data), static_cast<int>(file.size()));
+    QDataStream in(raw);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0, version = 0, count = 0;
+    in >> magic >> version >> count;
+    if (magic != CACHE_MAGIC || version != CACHE_VERSION) {
+        file.unmap(data);
+        return false;
+    }
+
+    m_entries.clear();
+    m_bytes = 0;
+    m_clock = 0;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+        QString key;
+        Entry   entry;
+        in >> key >> entry.body >> entry.etag >> entry.lastModified >> entry.updatedAt;
+        if (in.status() != QDataStream::Ok) {
+            break;  // truncated file, keep what we have
+        }
+        entry.lastUsed = ++m_clock;  // stored oldest first
+        m_bytes += entrySize(key, entry);
+        m_entries.insert(key, entry);
+    }
+    file.unmap(data);
+
+    evict();
+    m_dirty = false;
+    return true;
+}
+
+bool PlexMetadataCache::save() {
+    m_saveTimer->stop();
+    QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+
+    QSaveFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    // oldest first so loading restores the LRU order
+    QVector<QHash<QString, Entry>::const_iterator> order;
+    order.reserve(m_entries.size());
+    for (QHash<QString, Entry>::const_iterator iter = m_entries.constBegin(); iter != m_entries.constEnd(); ++iter) {
+        order.append(iter);
+    }
+    std::sort(order.begin(), order.end(),
+              [](const QHash<QString, Entry>::const_iterator& a, const QHash<QString, Entry>::const_iterator& b) {
+                  return a.value().lastUsed < b.value().lastUsed;
+              });
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << CACHE_MAGIC << CACHE_VERSION << static_cast<quint32>(order.size());
+    for (int i = 0; i < order.size(); i++) {
+        const Entry& entry = order[i].value();
+        out << order[i].key() << entry.body << entry.etag << entry.lastModified << entry.updatedAt;
+    }
+
+    if (!file.commit()) {
+        return false;
+    }
+    m_dirty = false;
+    return true;
+}
@@ -0,0 +1,79 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QTimer>
+#include <QVector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMEDIA METADATA CACHE
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Bounded LRU cache of browse replies (album, show and playlist listings), keyed by endpoint. Entries keep the
+// validators of the reply so they can be revalidated with a conditional request. The cache is written to a single
+// file after changes and read back with one mapping of that file on start.
+class PlexMetadataCache : public QObject {
+    Q_OBJECT
+
+ public:
+    struct Entry {
+        QByteArray body;
+        QByteArray etag;          // validators sent back as If-None-Match / If-Modified-Since
+        QByteArray lastModified;
+        qint64     updatedAt = 0;  // MediaContainer updatedAt, if the endpoint has one
+        qint64     lastUsed = 0;
+    };
+
+    explicit PlexMetadataCache(const QString& fileName, int maxBytes = 4 * 1024 * 1024, QObject* parent = nullptr);
+    ~PlexMetadataCache() override;
+
+    bool find(const QString& key, Entry* entry);  // marks the entry as recently used
+    void insert(const QString& key, const Entry& entry);
+    void remove(const QString& key);
+    void clear();
+
+    bool load();
+    bool save();
+
+    int    count() const { return m_entries.size(); }
+    qint64 bytes() const { return m_bytes; }
+    int    hits() const { return m_hits; }
+    int    misses() const { return m_misses; }
+
+ private:
+    void evict();
+    void scheduleSave();
+
+    QString               m_fileName;
+    qint64                m_maxBytes;
+    qint64                m_bytes = 0;
+    qint64                m_clock = 0;  // use counter for the LRU order
+    QHash<QString, Entry> m_entries;
+    QTimer*               m_saveTimer;
+    bool                  m_dirty = false;
+    int                   m_hits = 0;
+    int                   m_misses = 0;
+
+    enum { SAVE_DELAY = 5000 };
+};
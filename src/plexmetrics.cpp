@@ -0,0 +1,140 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "plexmetrics.h"
+
+#include <QJsonArray>
+#include <QRegExp>
+#include <QStringList>
+#include <QtMath>
+
+// upper bounds of the latency buckets in ms, the last one takes everything above
+static const qint64 LATENCY_BOUNDS[] = {10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000};
+
+void PlexMetrics::record(const QByteArray& verb, const QUrl& url, const Sample& sample) {
+    Endpoint& endpoint = m_endpoints[PlexMetrics::endpoint(verb, url)];
+    m_requests++;
+    endpoint.requests++;
+    endpoint.bytesOut += sample.bytesOut;
+    endpoint.bytesIn += sample.bytesIn;
+    endpoint.decodeTime += sample.decodeTime;
+    endpoint.handlerTime += sample.handlerTime;
+    if (sample.failed) endpoint.failures++;
+    if (sample.timedOut) endpoint.timeouts++;
+    if (sample.statusCode > 0) endpoint.statusCodes[sample.statusCode]++;
+
+    if (sample.latency >= 0) {
+        int bucket = 0;
+        while (bucket < BUCKETS - 1 && sample.latency > LATENCY_BOUNDS[bucket]) {
+            bucket++;
+        }
+        endpoint.latency[bucket]++;
+        endpoint.latencies++;
+        endpoint.latencyTotal += sample.latency;
+        endpoint.latencyMax = qMax(endpoint.latencyMax, sample.latency);
+    }
+}
+
+void PlexMetrics::reset() {
+    m_endpoints.clear();
+    m_requests = 0;
+    m_clock.restart();
+}
+
+QString PlexMetrics::endpoint(const QByteArray& verb, const QUrl& url) {
+    QStringList segments = url.path().split('/');
+    for (int i = 0; i < segments.size(); i++) {
+        bool numeric = false;
+        segments[i].toLongLong(&numeric);
+        // rating keys, queue ids and timestamps are numbers, machine identifiers are long hex strings
+        if (numeric || (segments[i].length() >= 16 && !segments[i].contains(QRegExp("[^0-9a-fA-F-]")))) {
+            segments[i] = "{id}";
+        }
+    }
+    return QString::fromLatin1(verb) + " " + segments.join('/');
+}
+
+qint64 PlexMetrics::percentile(const Endpoint& endpoint, double fraction) {
+    int target = qCeil(endpoint.latencies * fraction);
+    int count = 0;
+    for (int i = 0; i < BUCKETS - 1; i++) {
+        count += endpoint.latency[i];
+        if (count >= target) {
+            return LATENCY_BOUNDS[i];
+        }
+    }
+    return endpoint.latencyMax;
+}
+
+QJsonObject PlexMetrics::toJson() const {
+    QJsonObject endpoints;
+    for (QHash<QString, Endpoint>::const_iterator iter = m_endpoints.constBegin(); iter != m_endpoints.constEnd();
+         ++iter) {
+        const Endpoint& endpoint = iter.value();
+
+        QJsonObject statusCodes;
+        for (QHash<int, int>::const_iterator code = endpoint.statusCodes.constBegin();
+             code != endpoint.statusCodes.constEnd(); ++code) {
+            statusCodes.insert(QString::number(code.key()), code.value());
+        }
+
+        QJsonArray buckets;
+        for (int i = 0; i < BUCKETS; i++) {
+            buckets.append(endpoint.latency[i]);
+        }
+        QJsonObject latency;
+        latency.insert("count", endpoint.latencies);
+        if (endpoint.latencies > 0) {
+            latency.insert("avg", static_cast<double>(endpoint.latencyTotal / endpoint.latencies));
+            latency.insert("p50", static_cast<double>(percentile(endpoint, 0.5)));
+            latency.insert("p95", static_cast<double>(percentile(endpoint, 0.95)));
+            latency.insert("max", static_cast<double>(endpoint.latencyMax));
+        }
+        latency.insert("buckets", buckets);
+
+        QJsonObject json;
+        json.insert("requests", endpoint.requests);
+        json.insert("failures", endpoint.failures);
+        json.insert("timeouts", endpoint.timeouts);
+        json.insert("bytesOut", static_cast<double>(endpoint.bytesOut));
+        json.insert("bytesIn", static_cast<double>(endpoint.bytesIn));
+        json.insert("status", statusCodes);
+        json.insert("latencyMs", latency);
+        json.insert("decodeAvgUs", static_cast<double>(endpoint.decodeTime / endpoint.requests));
+        json.insert("handlerAvgUs", static_cast<double>(endpoint.handlerTime / endpoint.requests));
+        endpoints.insert(iter.key(), json);
+    }
+
+    QJsonArray bounds;
+    for (int i = 0; i < BUCKETS - 1; i++) {
+        bounds.append(static_cast<double>(LATENCY_BOUNDS[i]));
+    }
+
+    double      minutes = m_clock.elapsed() / 60000.0;
+    QJsonObject json;
+    json.insert("seconds", static_cast<double>(m_clock.elapsed() / 1000));
+    json.insert("requests", m_requests);
+    json.insert("requestsPerMinute", minutes > 0 ? m_requests / minutes : 0.0);
+    json.insert("latencyBucketsMs", bounds);
+    json.insert("endpoints", endpoints);
+    return json;
+}
@@ -0,0 +1,84 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QUrl>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMEDIA METRICS
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Counters of the HTTP traffic, per endpoint template ("GET /library/metadata/{id}/children"). The client records
+// every finished request: status, bytes, latency from sending to the reply, timeouts and the time spent decoding and
+// handling the reply. Latencies go into fixed buckets, so recording is a hash lookup and a few increments.
+class PlexMetrics {
+ public:
+    struct Sample {
+        int    statusCode = 0;
+        qint64 bytesOut = 0;
+        qint64 bytesIn = 0;
+        qint64 latency = -1;  // ms, -1 if the request was never sent
+        bool   failed = false;
+        bool   timedOut = false;
+        qint64 decodeTime = 0;   // us
+        qint64 handlerTime = 0;  // us
+    };
+
+    PlexMetrics() { m_clock.start(); }
+
+    void record(const QByteArray& verb, const QUrl& url, const Sample& sample);
+    void reset();
+
+    int         requests() const { return m_requests; }
+    QJsonObject toJson() const;
+
+    // verb and path with ids replaced, the query is dropped
+    static QString endpoint(const QByteArray& verb, const QUrl& url);
+
+ private:
+    enum { BUCKETS = 11 };
+
+    struct Endpoint {
+        int              requests = 0;
+        int              failures = 0;
+        int              timeouts = 0;
+        qint64           bytesOut = 0;
+        qint64           bytesIn = 0;
+        QHash<int, int>  statusCodes;
+        int              latency[BUCKETS] = {};
+        int              latencies = 0;
+        qint64           latencyTotal = 0;
+        qint64           latencyMax = 0;
+        qint64           decodeTime = 0;
+        qint64           handlerTime = 0;
+    };
+
+    static qint64 percentile(const Endpoint& endpoint, double fraction);
+
+    QHash<QString, Endpoint> m_endpoints;
+    QElapsedTimer            m_clock;
+    int                      m_requests = 0;
+};
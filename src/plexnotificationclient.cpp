@@ -0,0 +1,116 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "plexnotificationclient.h"
+
+#include "plexjsondecoder.h"
+
+PlexNotificationClient::PlexNotificationClient(QObject* parent)
+    : QObject(parent), m_socket(new QWebSocket(QString(), QWebSocketProtocol::VersionLatest, this)) {
+    m_reconnectTimer = new QTimer(this);
+    m_reconnectTimer->setSingleShot(true);
+    QObject::connect(m_reconnectTimer, &QTimer::timeout, this, [=]() { m_socket->open(m_url); });
+
+    m_heartbeatTimer = new QTimer(this);
+    m_heartbeatTimer->setInterval(HEARTBEAT_INTERVAL);
+    QObject::connect(m_heartbeatTimer, &QTimer::timeout, this, &PlexNotificationClient::onHeartbeat);
+
+    QObject::connect(m_socket, &QWebSocket::connected, this, &PlexNotificationClient::onConnected);
+    QObject::connect(m_socket, &QWebSocket::disconnected, this, &PlexNotificationClient::onDisconnected);
+    QObject::connect(m_socket, &QWebSocket::textMessageReceived, this, &PlexNotificationClient::onTextMessageReceived);
+    QObject::connect(m_socket, &QWebSocket::pong, this, [=]() { m_lastMessage.restart(); });
+    // a failed connection attempt reports an error only, there is no disconnected signal for it
+    QObject::connect(m_socket, QOverload<QAbstractSocket::SocketError>::of(&QWebSocket::error), this,
+                     [=](QAbstractSocket::SocketError error) {
+                         Q_UNUSED(error)
+                         if (m_socket->state() == QAbstractSocket::UnconnectedState) onDisconnected();
+                     });
+}
+
+void PlexNotificationClient::open(const QUrl& url) {
+    if (m_open && url == m_url) {
+        return;
+    }
+    m_open = false;  // no reconnect from dropping the old connection
+    m_reconnectTimer->stop();
+    m_socket->abort();
+
+    m_url = url;
+    m_open = true;
+    m_reconnectDelay = RECONNECT_MIN;
+    m_socket->open(m_url);
+}
+
+void PlexNotificationClient::close() {
+    m_open = false;
+    m_reconnectTimer->stop();
+    m_heartbeatTimer->stop();
+    m_socket->close();
+}
+
+void PlexNotificationClient::onConnected() {
+    m_connected = true;
+    m_reconnectDelay = RECONNECT_MIN;
+    m_lastMessage.start();
+    m_heartbeatTimer->start();
+    emit connected();
+}
+
+void PlexNotificationClient::onDisconnected() {
+    bool wasConnected = m_connected;
+    m_connected = false;
+    m_heartbeatTimer->stop();
+    if (wasConnected) {
+        emit disconnected();
+    }
+
+    if (m_open && !m_reconnectTimer->isActive()) {
+        // back off exponentially while the server is unreachable
+        m_reconnectTimer->start(m_reconnectDelay);
+        m_reconnectDelay = qMin(m_reconnectDelay * 2, static_cast<int>(RECONNECT_MAX));
+    }
+}
+
+void PlexNotificationClient::onTextMessageReceived(const QString& message) {
+    m_lastMessage.restart();
+
+    PlexNotification notification;
+    if (!PlexJsonDecoder::decodeNotification(message.toUtf8(), &notification)) {
+        return;  // not every message is a NotificationContainer
+    }
+
+    if (!notification.playSessions.isEmpty()) {
+        emit playSessionStateChanged(notification.playSessions);
+    }
+    if (!notification.timeline.isEmpty()) {
+        emit timelineChanged(notification.timeline);
+    }
+}
+
+void PlexNotificationClient::onHeartbeat() {
+    // nothing (not even a pong) for two heartbeats: the connection is dead even if the socket has not noticed
+    if (m_lastMessage.elapsed() > 2 * HEARTBEAT_INTERVAL) {
+        m_socket->abort();
+        return;
+    }
+    m_socket->ping();
+}
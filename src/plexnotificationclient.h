@@ -0,0 +1,72 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QUrl>
+#include <QWebSocket>
+
+#include "plextypes.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMEDIA NOTIFICATION CLIENT
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Keeps one connection open to the server's /:/websockets/notifications endpoint and reports the decoded
+// play session and library timeline events. Reconnects with backoff and uses pings to detect a dead connection.
+// Anything may have been missed while disconnected, so connected() is the cue to resynchronise.
+class PlexNotificationClient : public QObject {
+    Q_OBJECT
+
+ public:
+    explicit PlexNotificationClient(QObject* parent = nullptr);
+
+    void open(const QUrl& url);
+    void close();
+    bool isConnected() const { return m_connected; }
+
+ signals:
+    void connected();
+    void disconnected();
+    void playSessionStateChanged(const QVector<PlexPlaySessionState>& states);
+    void timelineChanged(const QVector<PlexTimelineEntry>& entries);
+
+ private slots:  // NOLINT open issue: https://github.com/cpplint/cpplint/pull/99
+    void onConnected();
+    void onDisconnected();
+    void onTextMessageReceived(const QString& message);
+    void onHeartbeat();
+
+ private:
+    enum { RECONNECT_MIN = 1000, RECONNECT_MAX = 60000, HEARTBEAT_INTERVAL = 30000 };
+
+    QWebSocket*   m_socket;
+    QTimer*       m_reconnectTimer;
+    QTimer*       m_heartbeatTimer;
+    QElapsedTimer m_lastMessage;
+    QUrl          m_url;
+    bool          m_open = false;
+    bool          m_connected = false;
+    int           m_reconnectDelay = RECONNECT_MIN;
+};
@@ -0,0 +1,152 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "plexpollscheduler.h"
+
+PlexPollScheduler::PlexPollScheduler(QObject* parent) : QObject(parent), m_timer(new QTimer(this)) {
+    m_timer->setSingleShot(true);
+    QObject::connect(m_timer, &QTimer::timeout, this, &PlexPollScheduler::onTimeout);
+    m_clock.start();
+}
+
+void PlexPollScheduler::start() {
+    m_idleTicks = 0;
+    for (QHash<QString, Endpoint>::iterator iter = m_endpoints.begin(); iter != m_endpoints.end(); ++iter) {
+        iter.value().consecutiveFailures = 0;  // hosts may well be back after standby
+    }
+    m_running = true;
+    m_timer->start(interval());
+}
+
+void PlexPollScheduler::stop() {
+    m_running = false;
+    m_timer->stop();
+}
+
+void PlexPollScheduler::setIntervals(int fast, int slow, int max) {
+    m_fastInterval = qMax(100, fast);
+    m_slowInterval = qMax(m_fastInterval, slow);
+    m_maxInterval = qMax(m_slowInterval, max);
+}
+
+void PlexPollScheduler::setActivity(Activity activity) {
+    if (activity != IDLE) {
+        m_idleTicks = 0;
+    }
+    if (activity == m_activity) {
+        return;
+    }
+    m_activity = activity;
+
+    // speeding up takes effect straight away, slowing down on the next tick
+    if (m_timer->isActive() && m_timer->remainingTime() > interval()) {
+        m_timer->start(interval());
+    }
+}
+
+bool PlexPollScheduler::acquire(const QString& endpoint) {
+    Endpoint& state = m_endpoints[endpoint];
+    if (state.inFlight) {
+        state.misses++;
+        return false;
+    }
+    if (state.consecutiveFailures > 0 && m_clock.elapsed() < state.retryAt) {
+        state.deferred++;
+        return false;
+    }
+    state.inFlight = true;
+    state.polls++;
+    return true;
+}
+
+PlexRequest* PlexPollScheduler::track(const QString& endpoint, PlexRequest* request) {
+    request->setTimeout(m_deadline);
+    request->onReply(this, [=](int statusCode, const QByteArray& body) {
+        Q_UNUSED(body)
+        Endpoint& state = m_endpoints[endpoint];
+        state.inFlight = false;
+        if (statusCode == 0) {  // no answer at all: unreachable, timed out or aborted
+            state.failures++;
+            state.consecutiveFailures++;
+            state.retryAt = m_clock.elapsed() + backoff(state.consecutiveFailures);
+        } else {
+            state.consecutiveFailures = 0;
+        }
+    });
+    return request;
+}
+
+int PlexPollScheduler::interval() const {
+    if (m_activity == PLAYING && m_visible) {
+        return m_fastInterval;
+    }
+    return backoff(m_activity == IDLE ? m_idleTicks : 0);
+}
+
+int PlexPollScheduler::backoff(int steps) const {
+    int shift = qMin(steps, static_cast<int>(MAX_BACKOFF_SHIFT));
+    return qMin(m_slowInterval << shift, m_maxInterval);
+}
+
+int PlexPollScheduler::missedPolls() const {
+    int misses = 0;
+    for (QHash<QString, Endpoint>::const_iterator iter = m_endpoints.begin(); iter != m_endpoints.end(); ++iter) {
+        misses += iter.value().misses;
+    }
+    return misses;
+}
+
+QVariantMap PlexPollScheduler::stats() const {
+    static const char* activities[] = {"playing", "paused", "idle"};
+
+    QVariantMap endpoints;
+    for (QHash<QString, Endpoint>::const_iterator iter = m_endpoints.begin(); iter != m_endpoints.end(); ++iter) {
+        QVariantMap endpoint;
+        endpoint.insert("polls", iter.value().polls);
+        endpoint.insert("misses", iter.value().misses);
+        endpoint.insert("deferred", iter.value().deferred);
+        endpoint.insert("failures", iter.value().failures);
+        endpoint.insert("consecutive_failures", iter.value().consecutiveFailures);
+        if (iter.value().consecutiveFailures > 0) {
+            endpoint.insert("backoff", backoff(iter.value().consecutiveFailures));
+        }
+        endpoint.insert("in_flight", iter.value().inFlight);
+        endpoints.insert(iter.key(), endpoint);
+    }
+
+    QVariantMap map;
+    map.insert("interval", interval());
+    map.insert("activity", activities[m_activity]);
+    map.insert("visible", m_visible);
+    map.insert("endpoints", endpoints);
+    return map;
+}
+
+void PlexPollScheduler::onTimeout() {
+    if (m_activity == IDLE) {
+        m_idleTicks++;
+    }
+    emit tick();
+    if (m_running) {  // the tick may have stopped us
+        m_timer->start(interval());
+    }
+}
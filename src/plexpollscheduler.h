@@ -0,0 +1,100 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QTimer>
+#include <QVariantMap>
+
+#include "plexrequest.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMEDIA POLL SCHEDULER
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Drives the status polling. Ticks are emitted at a cadence that follows the player: fast while playing and shown,
+// slow while paused, and backing off exponentially while there are no sessions.
+// Each endpoint has at most one poll in flight. A tick that finds its endpoint still busy is counted as a miss.
+// An endpoint that does not answer backs off on its own, so one unreachable player does not slow down the others.
+class PlexPollScheduler : public QObject {
+    Q_OBJECT
+
+ public:
+    enum Activity { PLAYING, PAUSED, IDLE };
+
+    explicit PlexPollScheduler(QObject* parent = nullptr);
+
+    void start();
+    void stop();
+    bool isActive() const { return m_running; }
+
+    // cadence in ms. Fast while playing and visible, slow otherwise, backing off up to max.
+    void setIntervals(int fast, int slow, int max);
+    void setDeadline(int msec) { m_deadline = msec; }
+    void setActivity(Activity activity);
+    void setVisible(bool visible) { m_visible = visible; }
+
+    // true if the endpoint has no poll in flight and is not backing off. A busy endpoint counts a miss.
+    bool acquire(const QString& endpoint);
+    // applies the deadline and frees the endpoint once the request has finished
+    PlexRequest* track(const QString& endpoint, PlexRequest* request);
+
+    int         interval() const;
+    Activity    activity() const { return m_activity; }
+    int         missedPolls() const;
+    QVariantMap stats() const;
+
+ signals:
+    void tick();
+
+ private slots:  // NOLINT open issue: https://github.com/cpplint/cpplint/pull/99
+    void onTimeout();
+
+ private:
+    struct Endpoint {
+        bool   inFlight = false;
+        int    polls = 0;
+        int    misses = 0;
+        int    deferred = 0;             // ticks skipped while backing off
+        int    failures = 0;
+        int    consecutiveFailures = 0;  // unanswered polls since the last answer
+        qint64 retryAt = 0;              // m_clock time before which a failing endpoint is not polled again
+    };
+
+    int backoff(int steps) const;  // slow interval doubled per step, up to max
+
+    QTimer*                  m_timer;
+    QElapsedTimer            m_clock;
+    QHash<QString, Endpoint> m_endpoints;
+    Activity                 m_activity = IDLE;
+    bool                     m_running = false;
+    bool                     m_visible = true;
+    int                      m_fastInterval = 2000;
+    int                      m_slowInterval = 4000;
+    int                      m_maxInterval = 60000;
+    int                      m_deadline = 10000;
+    int                      m_idleTicks = 0;  // ticks since the last session was seen
+
+    enum { MAX_BACKOFF_SHIFT = 5 };
+};
@@ -0,0 +1,110 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "plexprogressclock.h"
+
+PlexProgressClock::PlexProgressClock(QObject* parent) : QObject(parent), m_timer(new QTimer(this)) {
+    m_timer->setInterval(TICK_INTERVAL);
+    QObject::connect(m_timer, &QTimer::timeout, this, &PlexProgressClock::onTick);
+    m_clock.start();
+}
+
+void PlexProgressClock::sample(const QString& trackKey, qint64 position, qint64 duration, bool playing) {
+    qint64 now = m_clock.elapsed();
+
+    if (trackKey != m_trackKey || !m_playing || !playing) {
+        // new track, or starting/stopping: nothing to correct against
+        anchor(position, now);
+    } else {
+        qint64 error = position - positionAt(now);
+        if (qAbs(error) > SEEK_THRESHOLD) {
+            anchor(position, now);  // seek
+        } else {
+            // run slightly faster or slower until the error is gone, at most by half the normal speed
+            anchor(positionAt(now), now);
+            double correction = qBound(-0.5, static_cast<double>(error) / SLEW_WINDOW, 0.5);
+            if (error != 0) {
+                m_rate = 1.0 + correction;
+                m_slewUntil = now + static_cast<qint64>(error / correction);
+            }
+        }
+    }
+
+    m_trackKey = trackKey;
+    m_duration = duration;
+    m_playing = playing;
+    if (m_playing) {
+        if (!m_timer->isActive()) m_timer->start();
+    } else {
+        m_timer->stop();
+    }
+    onTick();
+}
+
+void PlexProgressClock::pause() {
+    if (!m_playing) {
+        return;
+    }
+    anchor(positionAt(m_clock.elapsed()), m_clock.elapsed());
+    m_playing = false;
+    m_timer->stop();
+    onTick();
+}
+
+void PlexProgressClock::reset() {
+    m_timer->stop();
+    m_trackKey.clear();
+    m_playing = false;
+    m_duration = 0;
+    m_lastSeconds = -1;
+    anchor(0, m_clock.elapsed());
+}
+
+qint64 PlexProgressClock::position() const { return positionAt(m_clock.elapsed()); }
+
+qint64 PlexProgressClock::positionAt(qint64 now) const {
+    qint64 position = m_anchorPosition;
+    if (m_playing) {
+        qint64 elapsed = now - m_anchorTime;
+        qint64 slewed = qBound(static_cast<qint64>(0), m_slewUntil - m_anchorTime, elapsed);
+        position += static_cast<qint64>(slewed * m_rate) + (elapsed - slewed);
+    }
+    if (m_duration > 0 && position > m_duration) {
+        position = m_duration;
+    }
+    return qMax(static_cast<qint64>(0), position);
+}
+
+void PlexProgressClock::anchor(qint64 position, qint64 now) {
+    m_anchorPosition = position;
+    m_anchorTime = now;
+    m_slewUntil = now;
+    m_rate = 1.0;
+}
+
+void PlexProgressClock::onTick() {
+    int seconds = static_cast<int>(position() / 1000);
+    if (seconds != m_lastSeconds) {
+        m_lastSeconds = seconds;
+        emit progressChanged(seconds);
+    }
+}
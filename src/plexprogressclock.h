@@ -0,0 +1,72 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QTimer>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMEDIA PROGRESS CLOCK
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Local model of the playback position of the active session, so progress moves smoothly between polls.
+// Seeded and corrected by the authoritative samples (session viewOffset or timeline time). Small drift is slewed
+// out over a couple of seconds so the position never jumps; a large difference is a seek and is applied at once.
+class PlexProgressClock : public QObject {
+    Q_OBJECT
+
+ public:
+    explicit PlexProgressClock(QObject* parent = nullptr);
+
+    // authoritative position and duration in ms of the item identified by trackKey
+    void sample(const QString& trackKey, qint64 position, qint64 duration, bool playing);
+    void pause();  // stop ticking straight away, e.g. when a pause command is sent
+    void reset();
+
+    qint64 position() const;  // interpolated, in ms
+    qint64 duration() const { return m_duration; }
+    bool   isPlaying() const { return m_playing; }
+
+ signals:
+    void progressChanged(int seconds);
+
+ private slots:  // NOLINT open issue: https://github.com/cpplint/cpplint/pull/99
+    void onTick();
+
+ private:
+    qint64 positionAt(qint64 now) const;
+    void   anchor(qint64 position, qint64 now);
+
+    QTimer*       m_timer;
+    QElapsedTimer m_clock;
+    QString       m_trackKey;
+    qint64        m_anchorPosition = 0;
+    qint64        m_anchorTime = 0;
+    qint64        m_slewUntil = 0;  // m_rate applies until then, afterwards the clock runs at normal speed
+    double        m_rate = 1.0;
+    qint64        m_duration = 0;
+    bool          m_playing = false;
+    int           m_lastSeconds = -1;
+
+    enum { TICK_INTERVAL = 250, SEEK_THRESHOLD = 3000, SLEW_WINDOW = 2000 };
+};
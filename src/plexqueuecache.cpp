@@ -0,0 +1,68 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "plexqueuecache.h"
+
+bool PlexQueueCache::isCurrent(const QString& id, qint64 version) const {
+    return !isEmpty() && id == m_queue.playQueue.id && version == m_queue.playQueue.version;
+}
+
+bool PlexQueueCache::covers(qint64 itemId, int ahead) const {
+    int index = indexOf(itemId);
+    if (index < 0) {
+        return false;
+    }
+    if (index + ahead < m_queue.metadata.size()) {
+        return true;
+    }
+
+    // the window ends early only at the end of the queue. The selected item's offset places the window in the queue.
+    int    selected = indexOf(m_queue.playQueue.selectedItemID);
+    qint64 first = selected >= 0 ? m_queue.playQueue.selectedItemOffset - selected : 0;
+    return first + m_queue.metadata.size() >= m_queue.playQueue.totalCount;
+}
+
+const PlexMetadataItem* PlexQueueCache::item(qint64 itemId, int offset) const {
+    int index = indexOf(itemId);
+    if (index < 0 || index + offset < 0 || index + offset >= m_queue.metadata.size()) {
+        return nullptr;
+    }
+    return &m_queue.metadata[index + offset];
+}
+
+void PlexQueueCache::update(const PlexMediaContainer& queue) {
+    if (!queue.playQueue.id.isEmpty()) {
+        m_queue = queue;
+    }
+}
+
+int PlexQueueCache::indexOf(qint64 itemId) const {
+    if (itemId <= 0) {
+        return -1;
+    }
+    for (int i = 0; i < m_queue.metadata.size(); i++) {
+        if (m_queue.metadata[i].playQueueItemID == itemId) {
+            return i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,55 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include "plextypes.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMEDIA PLAY QUEUE CACHE
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Window of the current play queue around the playing item, as last received from /playQueues/{id}.
+// It stays valid while the player reports the same playQueueID and playQueueVersion, so it is only downloaded again
+// when the queue changes or the player gets close to the end of the window.
+class PlexQueueCache {
+ public:
+    bool isEmpty() const { return m_queue.playQueue.id.isEmpty(); }
+    bool isCurrent(const QString& id, qint64 version) const;
+
+    // true if the window holds the item and the `ahead` items after it (or the queue ends before them)
+    bool covers(qint64 itemId, int ahead) const;
+
+    // the item `offset` places after itemId (before it if negative), nullptr if that is outside the window
+    const PlexMetadataItem* item(qint64 itemId, int offset) const;
+
+    void update(const PlexMediaContainer& queue);
+    void clear() { m_queue = PlexMediaContainer(); }
+
+    const PlexMediaContainer& container() const { return m_queue; }
+    qint64                    version() const { return m_queue.playQueue.version; }
+
+ private:
+    int indexOf(qint64 itemId) const;
+
+    PlexMediaContainer m_queue;
+};
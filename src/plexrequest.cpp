@@ -0,0 +1,209 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "plexrequest.h"
+
+#include <QJsonDocument>
+
+#include "plexjsondecoder.h"
+
+PlexRequest::PlexRequest(const QUrl& url, QObject* parent) : QObject(parent), m_url(url) {}
+
+PlexRequest* PlexRequest::onReply(QObject* context, ReplyHandler handler) {
+    Continuation<ReplyHandler> continuation;
+    continuation.context = context;
+    continuation.handler = handler;
+    m_replyHandlers.append(continuation);
+    return this;
+}
+
+PlexRequest* PlexRequest::then(QObject* context, ContainerHandler handler) {
+    Continuation<ContainerHandler> continuation;
+    continuation.context = context;
+    continuation.handler = handler;
+    m_containerHandlers.append(continuation);
+    return this;
+}
+
+PlexRequest* PlexRequest::thenJson(QObject* context, JsonHandler handler) {
+    Continuation<JsonHandler> continuation;
+    continuation.context = context;
+    continuation.handler = handler;
+    m_jsonHandlers.append(continuation);
+    return this;
+}
+
+PlexRequest* PlexRequest::onError(QObject* context, ErrorHandler handler) {
+    Continuation<ErrorHandler> continuation;
+    continuation.context = context;
+    continuation.handler = handler;
+    m_errorHandlers.append(continuation);
+    return this;
+}
+
+PlexRequest* PlexRequest::setTimeout(int msec) {
+    if (m_finished) {
+        return this;
+    }
+    if (m_timeout == nullptr) {
+        m_timeout = new QTimer(this);
+        m_timeout->setSingleShot(true);
+        QObject::connect(m_timeout, &QTimer::timeout, this, [=]() {
+            m_abortReason = "Timeout after " + QString::number(m_timeout->interval()) + " ms";
+            m_timedOut = true;
+            abort();
+        });
+    }
+    m_timeout->start(msec);
+    return this;
+}
+
+void PlexRequest::abort() {
+    if (m_finished || m_aborted) {
+        return;
+    }
+    m_aborted = true;
+    if (m_abortReason.isEmpty()) {
+        m_abortReason = "Aborted";
+    }
+
+    if (m_reply) {
+        m_reply->abort();  // emits finished, the client then completes us with the abort reason
+    } else {
+        finish(0, QByteArray(), m_abortReason);  // still queued, the client drops finished handles
+    }
+}
+
+void PlexRequest::fail(const QString& reason) {
+    // deferred so continuations added by the caller after the request was issued are still run
+    QTimer::singleShot(0, this, [=]() { finish(0, QByteArray(), reason); });
+}
+
+QByteArray PlexRequest::rawHeader(const QByteArray& name) const {
+    for (int i = 0; i < m_headers.size(); i++) {
+        if (qstricmp(m_headers[i].first.constData(), name.constData()) == 0) {
+            return m_headers[i].second;
+        }
+    }
+    return QByteArray();
+}
+
+void PlexRequest::attach(QNetworkReply* reply) {
+    m_reply = reply;
+    m_sent.start();
+}
+
+void PlexRequest::complete(QNetworkReply* reply) {
+    int        statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    QByteArray body = reply->readAll();
+    m_headers = reply->rawHeaderPairs();
+
+    QString error;
+    if (m_aborted) {
+        error = m_abortReason;
+    } else if (reply->error() != QNetworkReply::NoError) {
+        error = reply->errorString();
+    }
+    m_reply = nullptr;
+
+    finish(statusCode, body, error);
+}
+
+void PlexRequest::finish(int statusCode, const QByteArray& body, const QString& error) {
+    if (m_finished) {
+        return;
+    }
+    m_finished = true;
+    if (m_timeout) {
+        m_timeout->stop();
+    }
+    m_statusCode = statusCode;
+    m_bytesReceived = body.size();
+    if (m_sent.isValid()) {
+        m_latency = m_sent.elapsed();
+    }
+
+    // decoding and handling are timed apart, handlers build models and update the entity
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < m_replyHandlers.size(); i++) {
+        if (m_replyHandlers[i].context) {
+            m_replyHandlers[i].handler(statusCode, body);
+        }
+    }
+    m_handlerTime += timer.nsecsElapsed() / 1000;
+
+    QString decodeError = error;
+    if (error.isEmpty() && (!m_containerHandlers.isEmpty() || !m_jsonHandlers.isEmpty()) && body.isEmpty()) {
+        decodeError = "Empty response";
+    }
+
+    // typed records are decoded straight from the reply bytes, once for all continuations
+    if (decodeError.isEmpty() && !m_containerHandlers.isEmpty()) {
+        PlexMediaContainer container;
+        timer.restart();
+        bool decoded = PlexJsonDecoder::decode(body, &container, &decodeError);
+        m_decodeTime += timer.nsecsElapsed() / 1000;
+        if (decoded) {
+            timer.restart();
+            for (int i = 0; i < m_containerHandlers.size(); i++) {
+                if (m_containerHandlers[i].context) {
+                    m_containerHandlers[i].handler(container);
+                }
+            }
+            m_handlerTime += timer.nsecsElapsed() / 1000;
+        } else {
+            decodeError = "JSON error : " + decodeError;
+        }
+    }
+
+    if (decodeError.isEmpty() && !m_jsonHandlers.isEmpty()) {
+        QJsonParseError parseerror;
+        timer.restart();
+        QJsonDocument   doc = QJsonDocument::fromJson(body, &parseerror);
+        if (parseerror.error != QJsonParseError::NoError) {
+            decodeError = "JSON error : " + parseerror.errorString();
+        } else {
+            QVariantMap map = doc.toVariant().toMap();
+            m_decodeTime += timer.nsecsElapsed() / 1000;
+            timer.restart();
+            for (int i = 0; i < m_jsonHandlers.size(); i++) {
+                if (m_jsonHandlers[i].context) {
+                    m_jsonHandlers[i].handler(map);
+                }
+            }
+            m_handlerTime += timer.nsecsElapsed() / 1000;
+        }
+    }
+
+    m_failed = !decodeError.isEmpty();
+    if (!decodeError.isEmpty()) {
+        for (int i = 0; i < m_errorHandlers.size(); i++) {
+            if (m_errorHandlers[i].context) {
+                m_errorHandlers[i].handler(decodeError);
+            }
+        }
+    }
+
+    emit finished();
+    deleteLater();
+}
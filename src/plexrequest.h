@@ -0,0 +1,124 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QNetworkReply>
+#include <QPointer>
+#include <QTimer>
+#include <QVariantMap>
+#include <QVector>
+
+#include <functional>
+
+#include "plextypes.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMEDIA REQUEST HANDLE
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Handle for a single HTTP request. The reply is delivered only to the continuations registered on this handle,
+// so concurrent requests never see each other's responses. The handle deletes itself once it has finished.
+class PlexRequest : public QObject {
+    Q_OBJECT
+
+ public:
+    typedef std::function<void(int statusCode, const QByteArray& body)> ReplyHandler;
+    typedef std::function<void(const PlexMediaContainer& container)>    ContainerHandler;
+    typedef std::function<void(const QVariantMap& map)>                 JsonHandler;
+    typedef std::function<void(const QString& error)>                   ErrorHandler;
+
+    explicit PlexRequest(const QUrl& url, QObject* parent = nullptr);
+
+    // continuations. Handlers are skipped if their context object has been destroyed in the meantime.
+    PlexRequest* onReply(QObject* context, ReplyHandler handler);   // raw body, called for success and failure
+    PlexRequest* then(QObject* context, ContainerHandler handler);  // typed MediaContainer of a successful reply
+    PlexRequest* thenJson(QObject* context, JsonHandler handler);   // generic JSON body of a successful reply
+    PlexRequest* onError(QObject* context, ErrorHandler handler);   // network error, HTTP error, timeout or abort
+
+    // fail the request if it has not finished within msec of now (including time spent queued)
+    PlexRequest* setTimeout(int msec);
+
+    // cancel the request. Queued requests are never sent, running ones are aborted. Error handlers are called.
+    void abort();
+
+    QUrl url() const { return m_url; }
+
+    // response header of the finished reply, i.e. ETag or Last-Modified
+    QByteArray rawHeader(const QByteArray& name) const;
+    bool isRunning() const { return !m_reply.isNull(); }
+    bool isFinished() const { return m_finished; }
+    bool isAborted() const { return m_aborted; }
+
+    // cost of the finished reply on our side, in us: decoding the body and running the continuations
+    qint64 decodeTime() const { return m_decodeTime; }
+    qint64 handlerTime() const { return m_handlerTime; }
+
+    // outcome of the finished request
+    int    statusCode() const { return m_statusCode; }
+    qint64 bytesReceived() const { return m_bytesReceived; }
+    qint64 latency() const { return m_latency; }  // ms from sending to the reply, -1 if it was never sent
+    bool   hasFailed() const { return m_failed; }
+    bool   isTimedOut() const { return m_timedOut; }
+
+    // complete the request without sending it (i.e. no access token)
+    void fail(const QString& reason);
+
+ signals:
+    void finished();
+
+ private:
+    friend class PlexHttpClient;
+
+    // called by the client
+    void attach(QNetworkReply* reply);
+    void complete(QNetworkReply* reply);
+
+    void finish(int statusCode, const QByteArray& body, const QString& error);
+
+    template <typename T>
+    struct Continuation {
+        QPointer<QObject> context;
+        T                 handler;
+    };
+
+    QUrl                                      m_url;
+    QPointer<QNetworkReply>                   m_reply;
+    QTimer*                                   m_timeout = nullptr;
+    bool                                      m_finished = false;
+    bool                                      m_aborted = false;
+    bool                                      m_timedOut = false;
+    bool                                      m_failed = false;
+    int                                       m_statusCode = 0;
+    qint64                                    m_bytesReceived = 0;
+    qint64                                    m_latency = -1;
+    QElapsedTimer                             m_sent;
+    QString                                   m_abortReason;
+    QList<QNetworkReply::RawHeaderPair>       m_headers;
+    qint64                                    m_decodeTime = 0;
+    qint64                                    m_handlerTime = 0;
+    QVector<Continuation<ReplyHandler> >      m_replyHandlers;
+    QVector<Continuation<ContainerHandler> >  m_containerHandlers;
+    QVector<Continuation<JsonHandler> >       m_jsonHandlers;
+    QVector<Continuation<ErrorHandler> >      m_errorHandlers;
+};
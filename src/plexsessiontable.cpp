@@ -0,0 +1,120 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "plexsessiontable.h"
+
+PlexSessionTable::PlexSessionTable() {
+    m_clock.start();
+    m_players.insert(m_active, Player());  // no player yet
+}
+
+void PlexSessionTable::update(const QVector<PlexSession>& sessions) {
+    qint64      now = m_clock.elapsed();
+    QStringList order;
+    for (const PlexSession& session : sessions) {
+        const QString& id = session.player.machineIdentifier;
+        if (id.isEmpty() || order.contains(id)) {
+            continue;
+        }
+        order.append(id);
+
+        Player& player = m_players[id];
+        bool    playing = session.player.state == "playing";
+        // the same report shown again (e.g. the cached table after a speaker switch) keeps its original time
+        if (player.sampledAt == 0 || player.session.item.ratingKey != session.item.ratingKey ||
+            player.session.item.viewOffset != session.item.viewOffset || player.playing != playing) {
+            player.position = session.item.viewOffset;
+            player.duration = session.item.duration;
+            player.sampledAt = now;
+            player.playing = playing;
+        }
+        player.session = session;
+        player.listed = true;
+    }
+
+    for (int i = 0; i < m_order.size(); i++) {
+        if (order.contains(m_order[i])) {
+            continue;
+        }
+        if (m_order[i] == m_active) {
+            m_players[m_active].listed = false;  // kept with what was learned, it may come back
+        } else {
+            m_players.remove(m_order[i]);
+        }
+    }
+    m_order = order;
+}
+
+void PlexSessionTable::clear() {
+    m_players.clear();
+    m_order.clear();
+    m_players.insert(m_active, Player());
+}
+
+void PlexSessionTable::setActive(const QString& id) {
+    if (id == m_active) {
+        return;
+    }
+    if (!m_players.value(m_active).listed) {
+        m_players.remove(m_active);
+    }
+    m_active = id;
+    if (!m_players.contains(id)) {
+        m_players.insert(id, Player());
+    }
+}
+
+bool PlexSessionTable::contains(const QString& id) const {
+    return m_players.value(id).listed;
+}
+
+PlexSessionTable::Player* PlexSessionTable::find(const QString& id) {
+    QHash<QString, Player>::iterator iter = m_players.find(id);
+    return iter != m_players.end() && iter->listed ? &iter.value() : nullptr;
+}
+
+const PlexSessionTable::Player* PlexSessionTable::find(const QString& id) const {
+    QHash<QString, Player>::const_iterator iter = m_players.constFind(id);
+    return iter != m_players.constEnd() && iter->listed ? &iter.value() : nullptr;
+}
+
+void PlexSessionTable::sample(const QString& id, qint64 position, bool playing) {
+    QHash<QString, Player>::iterator iter = m_players.find(id);
+    if (iter == m_players.end()) {
+        return;
+    }
+    iter->position = position;
+    iter->sampledAt = m_clock.elapsed();
+    iter->playing = playing;
+}
+
+qint64 PlexSessionTable::position(const QString& id) const {
+    QHash<QString, Player>::const_iterator player = m_players.constFind(id);
+    if (player == m_players.constEnd()) {
+        return 0;
+    }
+    qint64 position = player->position;
+    if (player->playing) {
+        position += m_clock.elapsed() - player->sampledAt;
+    }
+    return player->duration > 0 ? qMin(position, player->duration) : position;
+}
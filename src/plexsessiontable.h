@@ -0,0 +1,95 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QStringList>
+
+#include "plextypes.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMEDIA SESSION TABLE
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Every player with an active session, updated from the one /status/sessions download (or its notification-patched
+// copy), plus the active player whether it has a session or not. The entry is the only copy of a player's state: what
+// was learned about it while it was the active one (control port and URL, direct connection, play queue, volume,
+// timeline) stays with it, so switching speakers carries on where that player was left.
+// Each entry runs its own progress clock from the last position reported by its session, its timeline or a seek.
+class PlexSessionTable {
+ public:
+    struct Player {
+        PlexSession session;
+        bool        listed = false;  // had a session in the last update
+
+        // learned while it was the active player
+        QString address;             // from its session or discovery
+        QString port = "0";          // control port, "0" while unknown
+        QString url;                 // control URL, empty while it is not known
+        bool    directConn = false;  // its own timeline answers
+        QString queue;
+        qint64  queueVersion = 0;    // as reported by the player, 0 if unknown
+        qint64  queueItem = 0;       // playQueueItemID of the playing item
+        int     volume = 100;
+        QString currentTrack = "0";  // ratingKey whose details are shown, "0" to fetch them again
+        QString state;
+        QString timelineKey;         // ratingKey of the last polled/pushed timeline
+
+        // progress clock
+        qint64 position = 0;   // ms, as last reported
+        qint64 duration = 0;   // ms
+        qint64 sampledAt = 0;  // when it was reported, on the table's clock
+        bool   playing = false;
+    };
+
+    PlexSessionTable();
+
+    // adds and refreshes the players in the list, forgets the ones that are not in it any more but the active one
+    void update(const QVector<PlexSession>& sessions);
+    void clear();
+
+    // the active player. Its entry is created if it has none, the one of the previous player is dropped if that one
+    // has no session.
+    void           setActive(const QString& id);
+    const QString& activeId() const { return m_active; }
+    Player&        active() { return m_players[m_active]; }
+
+    // players with a session
+    bool          contains(const QString& id) const;
+    Player*       find(const QString& id);
+    const Player* find(const QString& id) const;
+    QStringList   ids() const { return m_order; }  // in the order the server listed them
+    int           size() const { return m_order.size(); }
+
+    // sets the player's progress clock. Sessions set it themselves when their report changes.
+    void sample(const QString& id, qint64 position, bool playing);
+    // position of the player's item now, moved on from the last report while it is playing
+    qint64 position(const QString& id) const;
+
+ private:
+    QHash<QString, Player> m_players;
+    QStringList            m_order;
+    QString                m_active;
+    QElapsedTimer          m_clock;
+};
@@ -0,0 +1,73 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "plexstartupstate.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+static const quint32 STATE_MAGIC = 0x504c5853;  // "PLXS"
+static const quint32 STATE_VERSION = 2;
+
+bool PlexStartupState::load(const QString& fileName) {
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0, version = 0;
+    in >> magic >> version;
+    if (magic != STATE_MAGIC || version != STATE_VERSION) {
+        return false;
+    }
+
+    PlexStartupState state;
+    in >> state.user >> state.serverURL >> state.authToken >> state.serverId >> state.playerPorts >> state.sessions >>
+        state.players;
+    if (in.status() != QDataStream::Ok) {
+        return false;
+    }
+    *this = state;
+    return true;
+}
+
+bool PlexStartupState::save(const QString& fileName) const {
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    // the token is a credential, keep it private to the remote's user
+    file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << STATE_MAGIC << STATE_VERSION;
+    out << user << serverURL << authToken << serverId << playerPorts << sessions << players;
+    return file.commit();
+}
@@ -0,0 +1,47 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMEDIA STARTUP STATE
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// What a restart needs to show the player without signing in again: the plex.tv auth token, the server's
+// machineIdentifier, player ports found on /clients and the last /status/sessions reply. Kept in one small file.
+// Also the players seen so far, which are offered as entities of their own.
+struct PlexStartupState {
+    QString                 user;       // plex.tv account the token belongs to
+    QString                 serverURL;  // server the identity and sessions belong to
+    QString                 authToken;
+    QString                 serverId;
+    QHash<QString, QString> playerPorts;  // machineIdentifier -> port
+    QByteArray              sessions;     // body of the last /status/sessions reply
+    QHash<QString, QString> players;      // machineIdentifier -> title
+
+    bool load(const QString& fileName);
+    bool save(const QString& fileName) const;
+};
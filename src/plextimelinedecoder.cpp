@@ -0,0 +1,59 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "plextimelinedecoder.h"
+
+#include <QXmlStreamReader>
+
+bool PlexTimelineDecoder::decode(const QByteArray& xml, PlexTimeline* timeline) {
+    QXmlStreamReader reader(xml);
+    PlexTimeline     decoded;
+    while (!reader.atEnd()) {
+        if (reader.readNext() != QXmlStreamReader::StartElement || reader.name() != QLatin1String("Timeline")) {
+            continue;
+        }
+        QXmlStreamAttributes attributes = reader.attributes();
+        QStringRef           state = attributes.value(QLatin1String("state"));
+        if (state == QLatin1String("stopped")) {
+            continue;
+        }
+
+        // overwrite in order - photos - video - music
+        decoded.active = true;
+        decoded.state = state.toString();
+        decoded.ratingKey = attributes.value(QLatin1String("ratingKey")).toString();
+        decoded.type = attributes.value(QLatin1String("type")).toString();
+        decoded.playQueueID = attributes.value(QLatin1String("playQueueID")).toString();
+        decoded.playQueueVersion = attributes.hasAttribute(QLatin1String("playQueueVersion"))
+                                       ? attributes.value(QLatin1String("playQueueVersion")).toLongLong()
+                                       : -1;
+        decoded.playQueueItemID = attributes.value(QLatin1String("playQueueItemID")).toLongLong();
+        decoded.duration = attributes.value(QLatin1String("duration")).toLongLong();
+        decoded.time = attributes.value(QLatin1String("time")).toLongLong();
+        decoded.volume = attributes.value(QLatin1String("volume")).toInt();
+    }
+    if (reader.hasError()) {
+        return false;
+    }
+    *timeline = decoded;
+    return true;
+}
@@ -0,0 +1,39 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+
+#include "plextypes.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMEDIA TIMELINE DECODER
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Pull parser for the player timeline XML, the most frequent reply of all (every poll and every pushed update).
+// Streams over the raw reply bytes and reads only the Timeline attributes the integration uses. No DOM is built and
+// attribute values are only copied for the fields that are kept.
+class PlexTimelineDecoder {
+ public:
+    static bool decode(const QByteArray& xml, PlexTimeline* timeline);
+};
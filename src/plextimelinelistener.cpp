@@ -0,0 +1,131 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "plextimelinelistener.h"
+
+PlexTimelineListener::PlexTimelineListener(QObject* parent) : QObject(parent), m_server(new QTcpServer(this)) {
+    QObject::connect(m_server, &QTcpServer::newConnection, this, &PlexTimelineListener::onNewConnection);
+}
+
+bool PlexTimelineListener::listen(quint16 port) {
+    if (m_server->isListening()) {
+        return true;
+    }
+    return m_server->listen(QHostAddress::AnyIPv4, port);
+}
+
+void PlexTimelineListener::close() {
+    m_server->close();
+    QList<QTcpSocket*> sockets = m_buffers.keys();  // disconnecting removes the socket from m_buffers
+    for (int i = 0; i < sockets.size(); i++) {
+        sockets[i]->disconnectFromHost();
+    }
+}
+
+void PlexTimelineListener::onNewConnection() {
+    while (m_server->hasPendingConnections()) {
+        QTcpSocket* socket = m_server->nextPendingConnection();
+        m_buffers.insert(socket, QByteArray());
+        QObject::connect(socket, &QTcpSocket::readyRead, this, &PlexTimelineListener::onReadyRead);
+        QObject::connect(socket, &QTcpSocket::disconnected, this, [=]() {
+            m_buffers.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void PlexTimelineListener::onReadyRead() {
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+    if (!socket || !m_buffers.contains(socket)) {
+        return;
+    }
+
+    m_buffers[socket].append(socket->readAll());
+    if (m_buffers[socket].size() > MAX_REQUEST_SIZE) {
+        socket->abort();
+        return;
+    }
+
+    // handle every complete request in the buffer, the rest waits for more data
+    while (processRequest(socket)) {
+    }
+}
+
+bool PlexTimelineListener::processRequest(QTcpSocket* socket) {
+    QByteArray& buffer = m_buffers[socket];
+
+    int headerEnd = buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        return false;
+    }
+
+    QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+    QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    int               contentLength = 0;
+    bool              keepAlive = requestLine.size() > 2 && requestLine[2] == "HTTP/1.1";
+    for (int i = 1; i < lines.size(); i++) {
+        int colon = lines[i].indexOf(':');
+        if (colon < 0) {
+            continue;
+        }
+        QByteArray name = lines[i].left(colon).trimmed().toLower();
+        QByteArray value = lines[i].mid(colon + 1).trimmed();
+        if (name == "content-length") {
+            // a length we cannot trust would stall the connection or let the buffer grow, drop the connection
+            bool ok = false;
+            contentLength = value.toInt(&ok);
+            if (!ok || contentLength < 0 || contentLength > MAX_BODY_SIZE) {
+                socket->abort();  // removes the buffer
+                return false;
+            }
+        } else if (name == "connection") {
+            keepAlive = value.toLower() != "close";
+        }
+    }
+
+    int bodyStart = headerEnd + 4;
+    if (buffer.size() < bodyStart + contentLength) {
+        return false;
+    }
+    QByteArray body = buffer.mid(bodyStart, contentLength);
+    buffer.remove(0, bodyStart + contentLength);
+
+    QByteArray method = requestLine.value(0);
+    QByteArray path = requestLine.value(1);
+
+    QByteArray status = "200 OK";
+    if (method == "POST" && path.startsWith("/:/timeline")) {
+        emit timelineReceived(body, socket->peerAddress());
+    } else if (method != "OPTIONS") {
+        status = "404 Not Found";
+    }
+
+    socket->write("HTTP/1.1 " + status + "\r\n"
+                  "Content-Length: 0\r\n"
+                  "Access-Control-Allow-Origin: *\r\n"
+                  "Connection: " + QByteArray(keepAlive ? "keep-alive" : "close") + "\r\n\r\n");
+    if (!keepAlive) {
+        socket->disconnectFromHost();
+        return false;
+    }
+    return true;
+}
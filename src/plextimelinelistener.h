@@ -0,0 +1,65 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMEDIA TIMELINE LISTENER
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Minimal embedded HTTP server that receives the timeline updates a player pushes to its subscribers
+// (POST /:/timeline with the same MediaContainer XML as /player/timeline/poll). Only what the players send is
+// understood: requests with a Content-Length body of up to MAX_BODY_SIZE, optionally several on one keep-alive
+// connection. Anything else closes the connection. Pushes come with the peer they came from, which the subscriber
+// checks: the listener accepts connections from anywhere on the network.
+class PlexTimelineListener : public QObject {
+    Q_OBJECT
+
+ public:
+    explicit PlexTimelineListener(QObject* parent = nullptr);
+
+    bool    listen(quint16 port = 0);  // 0 picks a free port
+    void    close();
+    bool    isListening() const { return m_server->isListening(); }
+    quint16 port() const { return m_server->serverPort(); }
+
+ signals:
+    void timelineReceived(const QByteArray& xml, const QHostAddress& peer);
+
+ private slots:  // NOLINT open issue: https://github.com/cpplint/cpplint/pull/99
+    void onNewConnection();
+    void onReadyRead();
+
+ private:
+    bool processRequest(QTcpSocket* socket);
+
+    QTcpServer*                     m_server;
+    QHash<QTcpSocket*, QByteArray>  m_buffers;
+
+    static const int MAX_BODY_SIZE = 64 * 1024;  // a timeline is well under 2 KiB
+    static const int MAX_REQUEST_SIZE = MAX_BODY_SIZE + 16 * 1024;
+};
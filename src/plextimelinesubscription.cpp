@@ -0,0 +1,134 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "plextimelinesubscription.h"
+
+#include <QUrl>
+
+PlexTimelineSubscription::PlexTimelineSubscription(Sender sender, QObject* parent)
+    : QObject(parent), m_sender(sender), m_listener(new PlexTimelineListener(this)), m_renewTimer(new QTimer(this)) {
+    m_renewTimer->setInterval(30000);
+    QObject::connect(m_renewTimer, &QTimer::timeout, this, &PlexTimelineSubscription::onRenewTimerTimeout);
+    QObject::connect(m_listener, &PlexTimelineListener::timelineReceived, this,
+                     &PlexTimelineSubscription::onTimelineReceived);
+}
+
+void PlexTimelineSubscription::setIntervals(int renew, int pushTimeout, int backoff) {
+    m_renewTimer->setInterval(renew);
+    m_pushTimeout = pushTimeout;
+    m_backoffInterval = backoff;
+}
+
+bool PlexTimelineSubscription::start(quint16 port) {
+    if (!m_listener->listen(port)) {
+        return false;
+    }
+    m_renewTimer->start();
+    return true;
+}
+
+void PlexTimelineSubscription::stop() {
+    unsubscribe();
+    m_playerURL.clear();
+    m_backoff.invalidate();
+    m_renewTimer->stop();
+    m_listener->close();
+}
+
+void PlexTimelineSubscription::setPlayer(const QString& playerURL) {
+    if (playerURL == m_playerURL) {
+        if (!m_subscribed) subscribe();  // not accepted yet, or given up: subscribe() knows when to ask again
+        return;
+    }
+    unsubscribe();
+    m_playerURL = playerURL;
+    m_backoff.invalidate();  // another player gets its own chance
+    subscribe();
+}
+
+void PlexTimelineSubscription::subscribe() {
+    if (m_playerURL.isEmpty() || m_subscribing || !m_listener->isListening()) {
+        return;
+    }
+    if (m_backoff.isValid() && m_backoff.elapsed() < m_backoffInterval) {
+        return;  // pushes did not arrive last time, keep polling for now
+    }
+    m_backoff.invalidate();
+
+    int generation = m_generation;
+    m_subscribing = true;
+    m_sender(m_playerURL + "/player/timeline/subscribe", "?protocol=http&port=" + QString::number(m_listener->port()))
+        ->onReply(this, [=](int statusCode, const QByteArray& body) {
+            Q_UNUSED(body)
+            if (generation != m_generation) {
+                return;  // sent to a player we have moved away from
+            }
+            m_subscribing = false;
+            if (statusCode != 200) {
+                m_subscribed = false;
+                m_pushing = false;
+                return;
+            }
+            if (!m_subscribed) {
+                m_subscribed = true;
+                m_lastPush.start();  // the first push is due from now
+            }
+        });
+}
+
+void PlexTimelineSubscription::unsubscribe() {
+    if ((m_subscribed || m_subscribing) && !m_playerURL.isEmpty()) {
+        m_sender(m_playerURL + "/player/timeline/unsubscribe", "");
+    }
+    m_generation++;
+    m_subscribing = false;
+    m_subscribed = false;
+    m_pushing = false;
+}
+
+void PlexTimelineSubscription::fallBack(const QString& reason) {
+    unsubscribe();
+    m_backoff.start();
+    m_fallbacks++;
+    emit fellBack(reason);
+}
+
+void PlexTimelineSubscription::onRenewTimerTimeout() {
+    if (m_subscribed && m_lastPush.elapsed() > m_pushTimeout) {
+        fallBack(m_pushing ? "No timeline pushed for " + QString::number(m_lastPush.elapsed()) + " ms"
+                           : "Player accepted the subscription but never pushed its timeline");
+        return;
+    }
+    subscribe();  // renews an accepted subscription, retries a refused one once the backoff is over
+}
+
+void PlexTimelineSubscription::onTimelineReceived(const QByteArray& xml, const QHostAddress& peer) {
+    if (!m_subscribed) {
+        return;  // late push from a player we have moved away from, or one we gave up on
+    }
+    if (!peer.isEqual(QHostAddress(QUrl(m_playerURL).host()), QHostAddress::TolerantConversion)) {
+        return;  // not from the player we subscribed to, anyone on the network can post to the listener
+    }
+    m_lastPush.restart();
+    m_pushing = true;
+    emit timelineReceived(xml);
+}
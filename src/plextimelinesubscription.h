@@ -0,0 +1,91 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include <functional>
+
+#include "plexrequest.h"
+#include "plextimelinelistener.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMEDIA TIMELINE SUBSCRIPTION
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Subscription to the active player's timeline, delivered to our listener. A player accepting the subscription does
+// not mean its pushes reach us (NAT, firewall, blocked listener port), so polling only stops once a push has
+// actually arrived. When pushes stop, polling takes over for a while before the player is asked again.
+class PlexTimelineSubscription : public QObject {
+    Q_OBJECT
+
+ public:
+    // sends a GET to url + params and returns the handle
+    typedef std::function<PlexRequest*(const QString& url, const QString& params)> Sender;
+
+    explicit PlexTimelineSubscription(Sender sender, QObject* parent = nullptr);
+
+    // renew: subscriptions are renewed this often (players drop them after 90 s). pushTimeout: silence after which
+    // pushes count as lost. backoff: time spent polling after that before subscribing again. All in ms.
+    void setIntervals(int renew, int pushTimeout, int backoff);
+
+    bool start(quint16 port = 0);  // opens the listener, 0 picks a free port
+    void stop();                   // unsubscribes and closes the listener
+
+    // subscribes to this player, dropping the subscription to the previous one. Empty unsubscribes.
+    void setPlayer(const QString& playerURL);
+
+    // the player's pushes reach us, it does not have to be polled
+    bool isPushing() const { return m_pushing; }
+
+    quint16 port() const { return m_listener->port(); }
+    int     fallbacks() const { return m_fallbacks; }
+
+ signals:
+    void timelineReceived(const QByteArray& xml);
+    void fellBack(const QString& reason);  // pushes are not arriving, the player has to be polled
+
+ private slots:  // NOLINT open issue: https://github.com/cpplint/cpplint/pull/99
+    void onRenewTimerTimeout();
+    void onTimelineReceived(const QByteArray& xml, const QHostAddress& peer);
+
+ private:
+    void subscribe();
+    void unsubscribe();
+    void fallBack(const QString& reason);
+
+    Sender                m_sender;
+    PlexTimelineListener* m_listener;
+    QTimer*               m_renewTimer;
+    QString               m_playerURL;
+    int                   m_generation = 0;  // replies to a subscribe sent before the last change are ignored
+    bool                  m_subscribing = false;
+    bool                  m_subscribed = false;  // the player accepted, pushes may still not reach us
+    bool                  m_pushing = false;     // a push has arrived since subscribing
+    QElapsedTimer         m_lastPush;            // since the last push, or since subscribing while none has come
+    QElapsedTimer         m_backoff;             // since falling back to polling
+    int                   m_pushTimeout = 65000;
+    int                   m_backoffInterval = 120000;
+    int                   m_fallbacks = 0;
+};
@@ -0,0 +1,163 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLEXMEDIA RECORDS
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Compact records filled straight from the server replies. They only hold the fields the integration reads;
+// everything else in a reply is skipped by the decoder. Absent attributes are left empty/zero.
+
+struct PlexPlayer {
+    QString machineIdentifier;
+    QString address;
+    QString title;
+    QString platform;
+    QString state;
+    bool    local = false;
+};
+
+struct PlexMetadataItem {
+    QString ratingKey;
+    QString key;
+    QString type;
+    QString title;
+    QString titleSort;
+    QString originalTitle;
+    QString parentTitle;
+    QString grandparentTitle;
+    QString thumb;
+    QString parentThumb;
+    QString grandparentThumb;
+    QString summary;
+    QString tagLine;
+    QString playlistType;
+    QString librarySectionTitle;
+    QString leafCount;
+    qint64  duration = 0;
+    qint64  viewOffset = 0;
+    qint64  updatedAt = 0;
+    qint64  playQueueItemID = 0;
+
+    // first available image, working backwards from the item itself to its grandparent
+    QString image() const {
+        if (!thumb.isEmpty()) return thumb;
+        if (!parentThumb.isEmpty()) return parentThumb;
+        return grandparentThumb;
+    }
+};
+
+struct PlexSession {
+    PlexMetadataItem item;
+    PlexPlayer       player;
+    QString          userThumb;
+    QString          server;  // base URL of the server the session is on, empty for the configured one
+};
+
+// entry of the "Server" list returned by /clients
+struct PlexClient {
+    QString machineIdentifier;
+    QString name;
+    QString address;
+    QString port;
+    QString product;
+    QString platform;
+};
+
+struct PlexPlayQueue {
+    QString id;
+    qint64  version = 0;
+    qint64  selectedItemID = 0;
+    qint64  selectedItemOffset = 0;
+    qint64  totalCount = 0;
+};
+
+// PlaySessionStateNotification entry of the server notification stream
+struct PlexPlaySessionState {
+    QString sessionKey;
+    QString clientIdentifier;
+    QString ratingKey;
+    QString key;
+    QString state;
+    qint64  viewOffset = 0;
+    qint64  playQueueItemID = 0;
+};
+
+// TimelineEntry of the server notification stream (library item changes)
+struct PlexTimelineEntry {
+    QString itemID;
+    int     type = 0;
+    int     state = 0;
+    qint64  updatedAt = 0;
+};
+
+// Timeline of a player's /player/timeline/poll reply or pushed update (XML). The player lists one per media type,
+// the last one that is not stopped is kept.
+struct PlexTimeline {
+    QString state;
+    QString ratingKey;
+    QString type;
+    QString playQueueID;
+    qint64  playQueueVersion = -1;  // -1 if the player does not report it
+    qint64  playQueueItemID = 0;
+    qint64  duration = 0;
+    qint64  time = 0;
+    int     volume = 0;
+    bool    active = false;  // false if every timeline was stopped
+};
+
+struct PlexNotification {
+    QString                        type;
+    QVector<PlexPlaySessionState>  playSessions;
+    QVector<PlexTimelineEntry>     timeline;
+};
+
+struct PlexMediaContainer {
+    int     size = 0;
+    qint64  totalSize = 0;
+    qint64  offset = 0;
+    qint64  updatedAt = 0;
+    QString key;
+    QString ratingKey;
+    QString title;
+    QString title1;
+    QString title2;
+    QString parentTitle;
+    QString grandparentTitle;
+    QString thumb;
+    QString grandparentThumb;
+    QString viewGroup;
+    QString leafCount;
+    QString machineIdentifier;
+
+    PlexPlayQueue playQueue;  // only set for /playQueues replies
+
+    QVector<PlexMetadataItem> metadata;  // library, search, playlist and play queue items
+    QVector<PlexSession>      sessions;  // Metadata entries that carry a Player (/status/sessions)
+    QVector<PlexClient>       clients;   // Server entries (/clients)
+    QVector<PlexMetadataItem> directories;  // Directory entries (/library/sections)
+};
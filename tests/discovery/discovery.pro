@@ -0,0 +1,6 @@
+include(../tests.pri)
+
+TARGET   = tst_discovery
+HEADERS += $$SRC_PATH/plexdiscovery.h
+SOURCES += tst_discovery.cpp \
+    $$SRC_PATH/plexdiscovery.cpp
@@ -0,0 +1,150 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QNetworkDatagram>
+#include <QSignalSpy>
+#include <QUdpSocket>
+#include <QtTest>
+
+#include "plexdiscovery.h"
+
+// Stand-in for a GDM device on localhost: answers every search with its description while answering is on
+class FakeResponder : public QObject {
+ public:
+    FakeResponder(const QByteArray& contentType, const QByteArray& identifier) {
+        m_answer = "HTTP/1.0 200 OK\r\nContent-Type: " + contentType + "\r\nResource-Identifier: " + identifier +
+                   "\r\nName: Living Room\r\nPort: 32500\r\nProduct: Plex for Android\r\n"
+                   "Protocol-Capabilities: timeline,playback,playqueues\r\n\r\n";
+        m_socket.bind(QHostAddress::LocalHost, 0);
+        QObject::connect(&m_socket, &QUdpSocket::readyRead, this, [this]() {
+            while (m_socket.hasPendingDatagrams()) {
+                QNetworkDatagram datagram = m_socket.receiveDatagram();
+                if (!datagram.data().startsWith("M-SEARCH")) {
+                    continue;
+                }
+                searches++;
+                if (answers) m_socket.writeDatagram(datagram.makeReply(m_answer));
+            }
+        });
+    }
+
+    quint16 port() const { return m_socket.localPort(); }
+
+    bool answers = true;
+    int  searches = 0;
+
+ private:
+    QUdpSocket m_socket;
+    QByteArray m_answer;
+};
+
+class TestDiscovery : public QObject {
+    Q_OBJECT
+
+ private slots:  // NOLINT open issue: https://github.com/cpplint/cpplint/pull/99
+    void findsPlayerAndServer() {
+        FakeResponder         player("plex/media-player", "player-1");
+        FakeResponder         server("plex/media-server", "server-1");
+        PlexDiscovery         discovery;
+        PlexDiscovery::Device foundPlayer;
+        PlexDiscovery::Device foundServer;
+        int                   playerFound = 0;
+        QObject::connect(&discovery, &PlexDiscovery::playerFound, this, [&](const PlexDiscovery::Device& device) {
+            foundPlayer = device;
+            playerFound++;
+        });
+        QObject::connect(&discovery, &PlexDiscovery::serverFound, this,
+                         [&](const PlexDiscovery::Device& device) { foundServer = device; });
+
+        discovery.setTarget(QHostAddress::LocalHost, player.port(), server.port());
+        QVERIFY(discovery.start(INTERVAL));
+
+        QTRY_VERIFY(foundPlayer.isValid());
+        QTRY_VERIFY(foundServer.isValid());
+        QCOMPARE(foundPlayer.machineIdentifier, QString("player-1"));
+        QCOMPARE(foundPlayer.address, QString("127.0.0.1"));
+        QCOMPARE(foundPlayer.port, QString("32500"));
+        QVERIFY(!foundPlayer.server);
+        QCOMPARE(foundPlayer.capabilities, QStringList({"timeline", "playback", "playqueues"}));
+        QVERIFY(foundServer.server);
+        QCOMPARE(discovery.players().size(), 1);
+        QCOMPARE(discovery.servers().size(), 1);
+
+        // answers to later rounds only refresh the table
+        QTRY_VERIFY_WITH_TIMEOUT(player.searches >= 2, 3 * INTERVAL);
+        QCOMPARE(playerFound, 1);
+    }
+
+    void dropsSilentPlayer() {
+        FakeResponder player("plex/media-player", "player-1");
+        FakeResponder server("plex/media-server", "server-1");
+        PlexDiscovery discovery;
+        QSignalSpy    lost(&discovery, &PlexDiscovery::playerLost);
+
+        discovery.setTarget(QHostAddress::LocalHost, player.port(), server.port());
+        QVERIFY(discovery.start(INTERVAL));
+        QTRY_COMPARE(discovery.players().size(), 1);
+
+        player.answers = false;
+        QTRY_COMPARE_WITH_TIMEOUT(lost.count(), 1, 6 * INTERVAL);  // after three silent rounds
+        QCOMPARE(lost.first().first().toString(), QString("player-1"));
+        QVERIFY(discovery.players().isEmpty());
+        QCOMPARE(discovery.servers().size(), 1);
+    }
+
+    void parse_data() {
+        QTest::addColumn<QByteArray>("datagram");
+        QTest::addColumn<bool>("valid");
+        QTest::addColumn<bool>("server");
+        QTest::addColumn<QString>("port");
+        QTest::newRow("answer") << QByteArray("HTTP/1.0 200 OK\r\nContent-Type: plex/media-server\r\n"
+                                              "Resource-Identifier: abc\r\nPort: 32400\r\n\r\n")
+                                << true << true << "32400";
+        QTest::newRow("hello") << QByteArray("HELLO * HTTP/1.0\r\nContent-Type: plex/media-player\r\n"
+                                             "Resource-Identifier: abc\r\n\r\n")
+                               << true << false << "";
+        QTest::newRow("no identifier") << QByteArray("HTTP/1.0 200 OK\r\nPort: 32400\r\n\r\n") << false << false
+                                       << "32400";
+        QTest::newRow("search") << QByteArray("M-SEARCH * HTTP/1.0\r\n\r\n") << false << false << "";
+    }
+
+    void parse() {
+        QFETCH(QByteArray, datagram);
+        QFETCH(bool, valid);
+        QFETCH(bool, server);
+        QFETCH(QString, port);
+
+        PlexDiscovery::Device device;
+        QCOMPARE(PlexDiscovery::parse(datagram, &device), valid);
+        if (valid) {
+            QCOMPARE(device.server, server);
+            QCOMPARE(device.port, port);
+        }
+    }
+
+ private:
+    enum { INTERVAL = 1000 };  // ms, the shortest start() accepts
+};
+
+QTEST_GUILESS_MAIN(TestDiscovery)
+
+#include "tst_discovery.moc"
@@ -0,0 +1,6 @@
+include(../tests.pri)
+
+TARGET   = tst_guidispatcher
+HEADERS += $$SRC_PATH/plexguidispatcher.h
+SOURCES += tst_guidispatcher.cpp \
+    $$SRC_PATH/plexguidispatcher.cpp
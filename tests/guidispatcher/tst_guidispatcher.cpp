@@ -0,0 +1,113 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QThread>
+#include <QtTest>
+
+#include "plexguidispatcher.h"
+
+// Stand-in for a browse model: counts rows added from any thread but its own
+class Model : public QObject {
+ public:
+    void addItem(const QString& key) {
+        if (QThread::currentThread() != thread()) wrongThread.ref();
+        items.append(key);
+    }
+
+    QStringList       items;
+    static QAtomicInt wrongThread;
+};
+
+QAtomicInt Model::wrongThread;
+
+class TestGuiDispatcher : public QObject {
+    Q_OBJECT
+
+ private slots:  // NOLINT open issue: https://github.com/cpplint/cpplint/pull/99
+    void init() { Model::wrongThread = 0; }
+
+    void postFromGuiThreadRunsInline() {
+        PlexGuiDispatcher dispatcher;
+        bool              ran = false;
+        dispatcher.post([&ran]() { ran = true; });
+        QVERIFY(ran);
+    }
+
+    // what getAlbum and getEpisodes do for a show, from several worker threads at once: the model is built on the
+    // worker, handed over, then filled by tasks posted straight after. Every row must be added on the GUI thread,
+    // in order, however the worker and the GUI thread interleave.
+    void handOverThenFill() {
+        PlexGuiDispatcher dispatcher;
+        QVector<Model*>   shown;  // only touched by tasks, on the GUI thread
+        QAtomicInt        done(0);
+
+        QVector<QThread*> threads;
+        for (int t = 0; t < THREADS; t++) {
+            QThread* thread = new QThread(this);
+            QObject* context = new QObject();
+            context->moveToThread(thread);
+            QObject::connect(thread, &QThread::finished, context, &QObject::deleteLater);
+            thread->start();
+            threads.append(thread);
+
+            QMetaObject::invokeMethod(
+                context,
+                [&dispatcher, &shown, &done]() {
+                    for (int m = 0; m < MODELS; m++) {
+                        Model* model = new Model();
+                        model->addItem("header");  // filled on the worker while it still owns the model
+                        dispatcher.adopt(model);
+                        dispatcher.post([&shown, model]() { shown.append(model); });
+                        for (int row = 0; row < ROWS; row++) {
+                            dispatcher.post([model, row]() { model->addItem(QString::number(row)); });
+                        }
+                    }
+                    dispatcher.post([&done]() { done.ref(); });
+                },
+                Qt::QueuedConnection);
+        }
+
+        QTRY_COMPARE_WITH_TIMEOUT(done.load(), THREADS, 30000);
+        for (int t = 0; t < threads.size(); t++) {
+            threads[t]->quit();
+            threads[t]->wait();
+        }
+
+        QCOMPARE(Model::wrongThread.load(), 0);
+        QCOMPARE(shown.size(), THREADS * MODELS);
+        QStringList expected("header");
+        for (int row = 0; row < ROWS; row++) expected.append(QString::number(row));
+        for (int i = 0; i < shown.size(); i++) {
+            QCOMPARE(shown[i]->thread(), QThread::currentThread());
+            QCOMPARE(shown[i]->items, expected);
+        }
+        qDeleteAll(shown);
+        QVERIFY(dispatcher.batches() < dispatcher.tasks());  // posts from busy workers were batched
+    }
+
+ private:
+    enum { THREADS = 4, MODELS = 500, ROWS = 20 };
+};
+
+QTEST_GUILESS_MAIN(TestGuiDispatcher)
+
+#include "tst_guidispatcher.moc"
@@ -0,0 +1,125 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QThread>
+#include <QVariant>
+
+#include "yio-interface/entities/entitiesinterface.h"
+#include "yio-interface/entities/entityinterface.h"
+#include "yio-interface/entities/mediaplayerinterface.h"
+
+// Stand-ins for the remote's entities. They belong to the thread that creates them, like the real ones belong to the
+// GUI thread, and count every call made to them from any other thread. Only the calls the plugin makes do anything.
+class FakeMediaPlayer : public EntityInterface, public MediaPlayerInterface {
+ public:
+    explicit FakeMediaPlayer(const QString& entityId) : m_entityId(entityId), m_thread(QThread::currentThread()) {}
+
+    QVariant attribute(int index) const { return m_attributes.value(index); }
+    int      models() const { return m_models; }
+
+    static QAtomicInt wrongThread;
+
+    // EntityInterface
+    QString     type() override { return "media_player"; }
+    QString     area() override { return QString(); }
+    QString     friendly_name() override { return m_entityId; }
+    QString     entity_id() override { return m_entityId; }
+    QString     integration() override { return "plexmedia"; }
+    QObject*    integrationObj() override { return nullptr; }
+    QStringList supported_features() override { return QStringList(); }
+    bool        isSupported(int feature) override {
+        Q_UNUSED(feature)
+        return true;
+    }
+    bool updateAttrByName(const QString& name, const QVariant& value) override {
+        Q_UNUSED(name)
+        Q_UNUSED(value)
+        check();
+        return true;
+    }
+    bool updateAttrByIndex(int attrIndex, const QVariant& value) override {
+        check();
+        m_attributes.insert(attrIndex, value);
+        return true;
+    }
+    int   state() override { return m_attributes.value(MediaPlayerDef::STATE).toInt(); }
+    bool  isOn() override { return true; }
+    bool  connected() override { return true; }
+    void  setConnected(bool value) override { Q_UNUSED(value) }
+    void* getSpecificInterface() override {
+        check();
+        return static_cast<MediaPlayerInterface*>(this);
+    }
+
+    // MediaPlayerInterface
+    void setSearchModel(QObject* model) override { setModel(model); }
+    void setBrowseModel(QObject* model) override { setModel(model); }
+    void setSpeakerModel(QObject* model) override { setModel(model); }
+
+ private:
+    void check() const {
+        if (QThread::currentThread() != m_thread) wrongThread.ref();
+    }
+    void setModel(QObject* model) {
+        check();
+        if (model && model->thread() != m_thread) wrongThread.ref();  // handed over before it was moved
+        m_models++;
+    }
+
+    QString              m_entityId;
+    QThread*             m_thread;
+    QHash<int, QVariant> m_attributes;
+    int                  m_models = 0;
+};
+
+class FakeEntities : public EntitiesInterface {
+ public:
+    FakeEntities() : m_thread(QThread::currentThread()) {}
+    ~FakeEntities() override { qDeleteAll(m_entities); }
+
+    FakeMediaPlayer* add(const QString& entityId) {
+        FakeMediaPlayer* entity = new FakeMediaPlayer(entityId);
+        m_entities.insert(entityId, entity);
+        return entity;
+    }
+
+    EntityInterface* getEntityInterface(const QString& entityId) override {
+        if (QThread::currentThread() != m_thread) FakeMediaPlayer::wrongThread.ref();
+        return m_entities.value(entityId);
+    }
+    void addAvailableEntity(const QString& entityId, const QString& type, const QString& integration,
+                            const QString& friendlyName, const QStringList& supportedFeatures) override {
+        Q_UNUSED(entityId)
+        Q_UNUSED(type)
+        Q_UNUSED(integration)
+        Q_UNUSED(friendlyName)
+        Q_UNUSED(supportedFeatures)
+    }
+
+ private:
+    QThread*                          m_thread;
+    QHash<QString, FakeMediaPlayer*>  m_entities;
+};
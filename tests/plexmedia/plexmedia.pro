@@ -0,0 +1,86 @@
+# The whole integration on a worker thread, driven from the test's thread against the stand-in server and player.
+# Unlike the other tests it needs integrations.library, for the plugin and entity interfaces.
+include(../tests.pri)
+
+TARGET   = tst_plexmedia
+QT      += quick websockets  # as the plugin itself
+CONFIG  += debug  # the thread checks in the accessors are Q_ASSERTs
+
+INTG_LIB_PATH = $$(YIO_SRC)
+isEmpty(INTG_LIB_PATH) {
+    INTG_LIB_PATH = $$clean_path($$PWD/../../../integrations.library)
+    message("Environment variables YIO_SRC not defined! Using '$$INTG_LIB_PATH' for integrations.library project.")
+} else {
+    INTG_LIB_PATH = $$(YIO_SRC)/integrations.library
+    message("YIO_SRC is set: using '$$INTG_LIB_PATH' for integrations.library project.")
+}
+
+! include($$INTG_LIB_PATH/yio-plugin-lib.pri) {
+    error( "Cannot find the yio-plugin-lib.pri file!" )
+}
+
+! include($$INTG_LIB_PATH/yio-model-mediaplayer.pri) {
+    error( "Cannot find the yio-model-mediaplayer.pri file!" )
+}
+
+# plexmedia.h names its plugin metadata file, only the plugin build fills it in
+write_file($$OUT_PWD/plexmedia.json, "{}")
+INCLUDEPATH += $$OUT_PWD
+DEFINES += PLUGIN_VERSION=\\\"test\\\"
+
+MOCK_PATH = $$PWD/../../mock
+INCLUDEPATH += $$MOCK_PATH
+
+HEADERS += fakeentities.h \
+    $$MOCK_PATH/mockhttpserver.h \
+    $$MOCK_PATH/mocklibrary.h \
+    $$MOCK_PATH/mockplexplayer.h \
+    $$MOCK_PATH/mockplexserver.h \
+    $$SRC_PATH/plexmedia.h \
+    $$SRC_PATH/plexartwork.h \
+    $$SRC_PATH/plexcommandqueue.h \
+    $$SRC_PATH/plexdiscovery.h \
+    $$SRC_PATH/plexentitystate.h \
+    $$SRC_PATH/plexguidispatcher.h \
+    $$SRC_PATH/plexhttpclient.h \
+    $$SRC_PATH/plexjsondecoder.h \
+    $$SRC_PATH/plexlibraryindex.h \
+    $$SRC_PATH/plexmetadatacache.h \
+    $$SRC_PATH/plexmetrics.h \
+    $$SRC_PATH/plexnotificationclient.h \
+    $$SRC_PATH/plexpollscheduler.h \
+    $$SRC_PATH/plexprogressclock.h \
+    $$SRC_PATH/plexqueuecache.h \
+    $$SRC_PATH/plexrequest.h \
+    $$SRC_PATH/plexsessiontable.h \
+    $$SRC_PATH/plexstartupstate.h \
+    $$SRC_PATH/plextimelinedecoder.h \
+    $$SRC_PATH/plextimelinelistener.h \
+    $$SRC_PATH/plextimelinesubscription.h \
+    $$SRC_PATH/plextypes.h
+SOURCES += tst_plexmedia.cpp \
+    $$MOCK_PATH/mockhttpserver.cpp \
+    $$MOCK_PATH/mocklibrary.cpp \
+    $$MOCK_PATH/mockplexplayer.cpp \
+    $$MOCK_PATH/mockplexserver.cpp \
+    $$SRC_PATH/plexmedia.cpp \
+    $$SRC_PATH/plexartwork.cpp \
+    $$SRC_PATH/plexcommandqueue.cpp \
+    $$SRC_PATH/plexdiscovery.cpp \
+    $$SRC_PATH/plexentitystate.cpp \
+    $$SRC_PATH/plexguidispatcher.cpp \
+    $$SRC_PATH/plexhttpclient.cpp \
+    $$SRC_PATH/plexjsondecoder.cpp \
+    $$SRC_PATH/plexlibraryindex.cpp \
+    $$SRC_PATH/plexmetadatacache.cpp \
+    $$SRC_PATH/plexmetrics.cpp \
+    $$SRC_PATH/plexnotificationclient.cpp \
+    $$SRC_PATH/plexpollscheduler.cpp \
+    $$SRC_PATH/plexprogressclock.cpp \
+    $$SRC_PATH/plexqueuecache.cpp \
+    $$SRC_PATH/plexrequest.cpp \
+    $$SRC_PATH/plexsessiontable.cpp \
+    $$SRC_PATH/plexstartupstate.cpp \
+    $$SRC_PATH/plextimelinedecoder.cpp \
+    $$SRC_PATH/plextimelinelistener.cpp \
+    $$SRC_PATH/plextimelinesubscription.cpp
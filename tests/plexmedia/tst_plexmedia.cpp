@@ -0,0 +1,182 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QRandomGenerator>
+#include <QStandardPaths>
+#include <QThread>
+#include <QtTest>
+
+#include "fakeentities.h"
+#include "mocklibrary.h"
+#include "mockplexplayer.h"
+#include "mockplexserver.h"
+#include "plexmedia.h"
+
+QAtomicInt FakeMediaPlayer::wrongThread;
+
+static const char* ENTITY_ID = "media_player.plex";
+
+// The integration in worker thread mode: PlexMedia on its own thread, called from this one the way the remote's GUI
+// thread calls it, while it polls the stand-in server and player. Any member touched from the wrong thread trips the
+// Q_ASSERTs in its accessors, any entity call made off this thread is counted by the fake entities.
+class TestPlexMedia : public QObject {
+    Q_OBJECT
+
+ private slots:  // NOLINT open issue: https://github.com/cpplint/cpplint/pull/99
+    void initTestCase() { QStandardPaths::setTestModeEnabled(true); }  // caches and state go to a scratch location
+
+    void init() {
+        FakeMediaPlayer::wrongThread = 0;
+        m_library = new MockLibrary(500, 2019);
+        m_player = new MockPlexPlayer(m_library);
+        m_server = new MockPlexServer(m_library, m_player, 5);
+        QVERIFY(m_player->listen(0));
+        QVERIFY(m_server->listen(0));
+        m_entity = m_entities.add(ENTITY_ID);
+
+        QVariantMap data;
+        data.insert("server_address", "127.0.0.1");
+        data.insert("server_port", QString::number(m_server->port()));
+        data.insert("auth_token", "test");
+        data.insert("entity_id", ENTITY_ID);
+        data.insert("discovery", false);
+        QVariantMap config;
+        config.insert(Integration::KEY_ID, "plexmedia.test");
+        config.insert(Integration::KEY_FRIENDLYNAME, "Plex");
+        config.insert(Integration::OBJ_DATA, data);
+
+        m_media = new PlexMedia(config, &m_entities, nullptr, nullptr, nullptr, &m_plugin);
+        m_worker = new QThread(this);
+        m_media->moveToThread(m_worker);
+        QObject::connect(m_worker, &QThread::finished, m_media, &QObject::deleteLater);
+        m_worker->start();
+    }
+
+    void cleanup() {
+        m_media->disconnect();
+        QTest::qWait(100);  // the disconnect runs on the worker, its entity calls come back here
+        m_worker->quit();
+        QVERIFY(m_worker->wait(10000));
+        delete m_worker;
+        delete m_server;
+        delete m_player;
+        delete m_library;
+    }
+
+    void commandsWhilePolling() {
+        m_media->connect();
+        startPlayback();
+        QTRY_COMPARE_WITH_TIMEOUT(m_entity->attribute(MediaPlayerDef::SOURCE).toString(), QString("Mock Player"),
+                                  15000);
+
+        // presses, browsing and reconnects from this thread while the worker polls and handles replies
+        QRandomGenerator random(2019);
+        QElapsedTimer    elapsed;
+        elapsed.start();
+        int presses = 0;
+        while (elapsed.elapsed() < STRESS_TIME) {
+            switch (random.bounded(10)) {
+                case 0:
+                    m_media->sendCommand("media_player", ENTITY_ID, MediaPlayerDef::C_PLAY, QVariant());
+                    break;
+                case 1:
+                    m_media->sendCommand("media_player", ENTITY_ID, MediaPlayerDef::C_PAUSE, QVariant());
+                    break;
+                case 2:
+                    m_media->sendCommand("media_player", ENTITY_ID, MediaPlayerDef::C_NEXT, QVariant());
+                    break;
+                case 3:
+                    m_media->sendCommand("media_player", ENTITY_ID, MediaPlayerDef::C_PREVIOUS, QVariant());
+                    break;
+                case 4:
+                    m_media->sendCommand("media_player", ENTITY_ID, MediaPlayerDef::C_VOLUME_SET,
+                                         random.bounded(101));
+                    break;
+                case 5:
+                    m_media->sendCommand("media_player", ENTITY_ID, MediaPlayerDef::C_SEEK, random.bounded(60));
+                    break;
+                case 6:
+                    m_media->sendCommand("media_player", ENTITY_ID, MediaPlayerDef::C_GETPLAYLIST, "user");
+                    break;
+                case 7:
+                    m_media->sendCommand("media_player", ENTITY_ID, MediaPlayerDef::C_GET_SPEAKERS, QVariant());
+                    break;
+                case 8:
+                    m_media->disconnect();
+                    m_media->connect();
+                    break;
+                default:
+                    QTest::qWait(random.bounded(20));  // let replies and entity updates through
+                    break;
+            }
+            presses++;
+            if (presses % 8 == 0) QCoreApplication::processEvents();
+        }
+
+        // the worker is still answering: a last press reaches the player
+        int commands = playerCommands();
+        m_media->sendCommand("media_player", ENTITY_ID, MediaPlayerDef::C_VOLUME_SET, 42);
+        QTRY_VERIFY_WITH_TIMEOUT(playerCommands() > commands, 10000);
+
+        QVERIFY(playerCommands() > 0);
+        QVERIFY(m_entity->models() > 0);
+        QCOMPARE(FakeMediaPlayer::wrongThread.load(), 0);
+    }
+
+ private:
+    // the mock player only shows up in the sessions while it plays
+    void startPlayback() {
+        QNetworkAccessManager manager;
+        QNetworkReply*        reply = manager.get(QNetworkRequest(
+            QUrl("http://127.0.0.1:" + QString::number(m_player->port()) +
+                 "/player/playback/playMedia?key=/library/metadata/1000000&offset=0")));
+        QTRY_VERIFY(reply->isFinished());
+        QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 200);
+        delete reply;
+    }
+
+    int playerCommands() const {
+        QJsonObject requests = m_player->stats().value("requests").toObject();
+        int         count = 0;
+        for (QJsonObject::const_iterator iter = requests.constBegin(); iter != requests.constEnd(); ++iter) {
+            if (iter.key().startsWith("/player/playback/")) count += iter.value().toInt();
+        }
+        return count;
+    }
+
+    enum { STRESS_TIME = 10000 };  // ms
+
+    PlexMediaPlugin  m_plugin;
+    FakeEntities     m_entities;
+    FakeMediaPlayer* m_entity = nullptr;
+    MockLibrary*     m_library = nullptr;
+    MockPlexPlayer*  m_player = nullptr;
+    MockPlexServer*  m_server = nullptr;
+    PlexMedia*       m_media = nullptr;
+    QThread*         m_worker = nullptr;
+};
+
+QTEST_GUILESS_MAIN(TestPlexMedia)
+
+#include "tst_plexmedia.moc"
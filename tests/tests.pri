@@ -0,0 +1,9 @@
+# shared by the test projects, each lists the plugin sources it exercises. Only plexmedia needs integrations.library.
+TEMPLATE  = app
+QT       += core network testlib
+QT       -= gui
+CONFIG   += testcase console c++11
+CONFIG   -= app_bundle
+
+SRC_PATH = $$PWD/../src
+INCLUDEPATH += $$SRC_PATH
@@ -0,0 +1,6 @@
+# Unit tests of the plugin's building blocks, and the integration as a whole. Build and run with: qmake && make check
+TEMPLATE = subdirs
+SUBDIRS += discovery \
+    guidispatcher \
+    plexmedia \
+    timelinesubscription
@@ -0,0 +1,17 @@
+include(../tests.pri)
+
+TARGET   = tst_timelinesubscription
+HEADERS += $$SRC_PATH/plexhttpclient.h \
+    $$SRC_PATH/plexjsondecoder.h \
+    $$SRC_PATH/plexmetrics.h \
+    $$SRC_PATH/plexrequest.h \
+    $$SRC_PATH/plextimelinelistener.h \
+    $$SRC_PATH/plextimelinesubscription.h \
+    $$SRC_PATH/plextypes.h
+SOURCES += tst_timelinesubscription.cpp \
+    $$SRC_PATH/plexhttpclient.cpp \
+    $$SRC_PATH/plexjsondecoder.cpp \
+    $$SRC_PATH/plexmetrics.cpp \
+    $$SRC_PATH/plexrequest.cpp \
+    $$SRC_PATH/plextimelinelistener.cpp \
+    $$SRC_PATH/plextimelinesubscription.cpp
@@ -0,0 +1,239 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2019 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUrlQuery>
+#include <QtTest>
+
+#include "plexhttpclient.h"
+#include "plextimelinesubscription.h"
+
+static const QByteArray TIMELINE =
+    "<MediaContainer commandID=\"1\"><Timeline type=\"music\" state=\"playing\" time=\"1000\" duration=\"200000\" "
+    "ratingKey=\"42\" volume=\"50\" /></MediaContainer>";
+
+// Stand-in for a player's control port. Accepts timeline subscriptions and, while pushing is on, pushes a timeline
+// to the subscriber's port on every (re)subscribe like a real player does. Pushes always leave from 127.0.0.1.
+class FakePlayer : public QObject {
+ public:
+    explicit FakePlayer(const QString& host = "127.0.0.1") : m_host(host) {
+        m_server.listen(QHostAddress(host));
+        QObject::connect(&m_server, &QTcpServer::newConnection, this, [this]() {
+            while (m_server.hasPendingConnections()) {
+                QTcpSocket* socket = m_server.nextPendingConnection();
+                QObject::connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+                QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+            }
+        });
+    }
+
+    QString url() const { return "http://" + m_host + ":" + QString::number(m_server.serverPort()); }
+
+    void push(quint16 port, const QByteArray& xml) {
+        QTcpSocket* socket = new QTcpSocket(this);
+        QObject::connect(socket, &QTcpSocket::connected, socket, [=]() {
+            socket->write("POST /:/timeline HTTP/1.1\r\nContent-Length: " + QByteArray::number(xml.size()) +
+                          "\r\nConnection: close\r\n\r\n" + xml);
+        });
+        QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        socket->connectToHost(QHostAddress::LocalHost, port);
+    }
+
+    bool pushes = false;
+    int  subscribes = 0;
+    int  unsubscribes = 0;
+
+ private:
+    void onReadyRead(QTcpSocket* socket) {
+        QByteArray& buffer = m_buffers[socket];
+        buffer.append(socket->readAll());
+        if (!buffer.contains("\r\n\r\n")) {
+            return;
+        }
+        QUrl url("http://player" + buffer.split(' ').value(1));
+        buffer.clear();
+
+        if (url.path() == "/player/timeline/subscribe") {
+            subscribes++;
+            if (pushes) push(static_cast<quint16>(QUrlQuery(url).queryItemValue("port").toUInt()), TIMELINE);
+        } else if (url.path() == "/player/timeline/unsubscribe") {
+            unsubscribes++;
+        }
+        socket->write("HTTP/1.1 200 OK\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        socket->disconnectFromHost();
+    }
+
+    QString                         m_host;
+    QTcpServer                      m_server;
+    QHash<QTcpSocket*, QByteArray>  m_buffers;
+};
+
+class TestTimelineSubscription : public QObject {
+    Q_OBJECT
+
+ private slots:  // NOLINT open issue: https://github.com/cpplint/cpplint/pull/99
+    void initTestCase() { qRegisterMetaType<QHostAddress>("QHostAddress"); }
+
+    void init() {
+        m_http = new PlexHttpClient(4, this);
+        m_subscription = new PlexTimelineSubscription(
+            [=](const QString& url, const QString& params) {
+                return m_http->get(QNetworkRequest(QUrl(url + params)));
+            },
+            this);
+        m_subscription->setIntervals(RENEW, PUSH_TIMEOUT, BACKOFF);
+        QVERIFY(m_subscription->start());
+    }
+
+    void cleanup() {
+        delete m_subscription;
+        delete m_http;
+    }
+
+    void pollsUntilFirstPush() {
+        FakePlayer player;
+        player.pushes = true;
+        QSignalSpy received(m_subscription, &PlexTimelineSubscription::timelineReceived);
+
+        m_subscription->setPlayer(player.url());
+        QVERIFY(!m_subscription->isPushing());  // accepted or not, nothing has arrived yet
+
+        QTRY_VERIFY(m_subscription->isPushing());
+        QVERIFY(received.count() >= 1);
+        QCOMPARE(received.first().first().toByteArray(), TIMELINE);
+    }
+
+    void acceptedButNeverPushed() {
+        FakePlayer player;  // behind NAT: accepts the subscription, its pushes never arrive
+        QSignalSpy fellBack(m_subscription, &PlexTimelineSubscription::fellBack);
+
+        m_subscription->setPlayer(player.url());
+        QTRY_VERIFY(player.subscribes >= 1);
+        QVERIFY(!m_subscription->isPushing());
+
+        // gives up, unsubscribes and keeps polling through the backoff instead of renewing straight away
+        QTRY_COMPARE_WITH_TIMEOUT(fellBack.count(), 1, 5 * PUSH_TIMEOUT);
+        QTRY_COMPARE(player.unsubscribes, 1);
+        int subscribes = player.subscribes;
+        m_subscription->setPlayer(player.url());
+        QTest::qWait(BACKOFF / 2);
+        QCOMPARE(player.subscribes, subscribes);
+        QVERIFY(!m_subscription->isPushing());
+
+        // and tries again once the backoff is over
+        QTRY_VERIFY_WITH_TIMEOUT(player.subscribes > subscribes, 4 * BACKOFF);
+    }
+
+    void pushesStop() {
+        FakePlayer player;
+        player.pushes = true;
+        QSignalSpy fellBack(m_subscription, &PlexTimelineSubscription::fellBack);
+
+        m_subscription->setPlayer(player.url());
+        QTRY_VERIFY(m_subscription->isPushing());
+
+        player.pushes = false;
+        QTRY_VERIFY_WITH_TIMEOUT(!m_subscription->isPushing(), 5 * PUSH_TIMEOUT);
+        QCOMPARE(fellBack.count(), 1);
+    }
+
+    void pushFromAnotherHost() {
+        FakePlayer player("127.0.0.2");  // subscribed to at 127.0.0.2, its pushes arrive from 127.0.0.1
+        player.pushes = true;
+        QSignalSpy received(m_subscription, &PlexTimelineSubscription::timelineReceived);
+
+        m_subscription->setPlayer(player.url());
+        QTRY_VERIFY(player.subscribes >= 1);
+        QTest::qWait(PUSH_TIMEOUT / 2);
+        QCOMPARE(received.count(), 0);
+        QVERIFY(!m_subscription->isPushing());
+    }
+
+    void changePlayer() {
+        FakePlayer first;
+        FakePlayer second;
+        first.pushes = true;
+
+        m_subscription->setPlayer(first.url());
+        QTRY_VERIFY(m_subscription->isPushing());
+
+        // the new player has not pushed yet, so it is polled, and the old one is told to stop
+        m_subscription->setPlayer(second.url());
+        QVERIFY(!m_subscription->isPushing());
+        QTRY_COMPARE(first.unsubscribes, 1);
+        QTRY_VERIFY(second.subscribes >= 1);
+        QVERIFY(!m_subscription->isPushing());
+    }
+
+    void listenerKeepAlive() {
+        PlexTimelineListener listener;
+        QVERIFY(listener.listen());
+        QSignalSpy received(&listener, &PlexTimelineListener::timelineReceived);
+
+        // two pushes on one connection, in one segment
+        QTcpSocket socket;
+        socket.connectToHost(QHostAddress::LocalHost, listener.port());
+        QVERIFY(socket.waitForConnected());
+        QByteArray request = "POST /:/timeline HTTP/1.1\r\nContent-Length: " + QByteArray::number(TIMELINE.size()) +
+                             "\r\n\r\n" + TIMELINE;
+        socket.write(request + request);
+
+        QTRY_COMPARE(received.count(), 2);
+        QCOMPARE(received.last().first().toByteArray(), TIMELINE);
+        QCOMPARE(socket.state(), QAbstractSocket::ConnectedState);
+    }
+
+    void listenerRejectsContentLength_data() {
+        QTest::addColumn<QByteArray>("length");
+        QTest::newRow("negative") << QByteArray("-1");
+        QTest::newRow("not a number") << QByteArray("12abc");
+        QTest::newRow("over the limit") << QByteArray("65537");
+        QTest::newRow("overflow") << QByteArray("99999999999");
+    }
+
+    void listenerRejectsContentLength() {
+        QFETCH(QByteArray, length);
+        PlexTimelineListener listener;
+        QVERIFY(listener.listen());
+        QSignalSpy received(&listener, &PlexTimelineListener::timelineReceived);
+
+        QTcpSocket socket;
+        socket.connectToHost(QHostAddress::LocalHost, listener.port());
+        QVERIFY(socket.waitForConnected());
+        socket.write("POST /:/timeline HTTP/1.1\r\nContent-Length: " + length + "\r\n\r\n" + TIMELINE);
+
+        QTRY_COMPARE(socket.state(), QAbstractSocket::UnconnectedState);
+        QCOMPARE(received.count(), 0);
+    }
+
+ private:
+    enum { RENEW = 100, PUSH_TIMEOUT = 300, BACKOFF = 800 };  // ms, scaled down from 30 s, 65 s and 120 s
+
+    PlexHttpClient*           m_http = nullptr;
+    PlexTimelineSubscription* m_subscription = nullptr;
+};
+
+QTEST_GUILESS_MAIN(TestTimelineSubscription)
+
+#include "tst_timelinesubscription.moc"